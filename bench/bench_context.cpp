@@ -0,0 +1,253 @@
+#include "bench_context.hpp"
+
+#include <cut/exception.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#ifdef GLW_BENCH_EGL
+#include "egl_context.hpp"
+#endif
+
+namespace {
+
+using namespace glw;
+using namespace glw::bench;
+
+Backend current_backend = Backend::Null;
+
+/*
+* Null driver, objects are just increasing names and queries report success
+*/
+const char* const null_uniform_names[] = {
+    "u_model", "u_view_projection", "u_normal_matrix", "u_light_direction",
+    "u_color", "u_roughness", "u_metallic", "u_time", "glw_draw_index"
+};
+
+GLuint next_name = 1;
+std::unordered_map<GLuint, std::vector<std::byte>> buffer_mappings;
+GLDEBUGPROC debug_callback = nullptr;
+
+template<typename T>
+struct NullFunction;
+
+template<typename R, typename... Args>
+struct NullFunction<R (APIENTRY*)(Args...)> {
+    static R APIENTRY call(Args...) {
+        if constexpr (!std::is_void_v<R>) return R{};
+    }
+};
+
+void APIENTRY null_create_objects(GLsizei count, GLuint* names) {
+    for (GLsizei i = 0; i < count; ++i) names[i] = next_name++;
+}
+
+void APIENTRY null_create_targets(GLenum, GLsizei count, GLuint* names) {
+    null_create_objects(count, names);
+}
+
+GLuint APIENTRY null_create_shader(GLenum) {
+    return next_name++;
+}
+
+GLuint APIENTRY null_create_program() {
+    return next_name++;
+}
+
+void APIENTRY null_delete_buffers(GLsizei count, const GLuint* names) {
+    for (GLsizei i = 0; i < count; ++i) buffer_mappings.erase(names[i]);
+}
+
+// GL 4.5 minimum, sizes SpriteBatch texture slots
+void APIENTRY null_get_integer(GLenum name, GLint* value) {
+    switch (name) {
+    case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS: *value = 80; return;
+    case GL_MAX_TEXTURE_IMAGE_UNITS: *value = 16; return;
+    }
+    *value = 0;
+}
+
+void APIENTRY null_get_object_iv(GLuint, GLenum name, GLint* value) {
+    switch (name) {
+    case GL_COMPILE_STATUS:
+    case GL_LINK_STATUS: *value = GL_TRUE; return;
+    case GL_ACTIVE_UNIFORMS: *value = static_cast<GLint>(std::size(null_uniform_names)); return;
+    case GL_ACTIVE_UNIFORM_MAX_LENGTH: *value = 32; return;
+    }
+    *value = 0;
+}
+
+void APIENTRY null_get_active_uniform(GLuint, GLuint index, GLsizei buffer_size, GLsizei* length, GLint* size, GLenum* type,
+                                      GLchar* name) {
+    GLsizei copied = std::min(static_cast<GLsizei>(std::strlen(null_uniform_names[index])), buffer_size - 1);
+    std::memcpy(name, null_uniform_names[index], copied);
+    name[copied] = '\0';
+    *length = copied;
+    *size = 1;
+    *type = GL_FLOAT_MAT4;
+}
+
+GLint APIENTRY null_get_uniform_location(GLuint, const GLchar* name) {
+    for (size_t i = 0; i < std::size(null_uniform_names); ++i) {
+        if (std::strcmp(name, null_uniform_names[i]) == 0) return static_cast<GLint>(i);
+    }
+    return -1;
+}
+
+void* APIENTRY null_map_buffer_range(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield) {
+    auto& mapping = buffer_mappings[buffer];
+    mapping.resize(static_cast<size_t>(offset + length));
+    return mapping.data() + offset;
+}
+
+GLsync APIENTRY null_fence_sync(GLenum, GLbitfield) {
+    return reinterpret_cast<GLsync>(static_cast<std::uintptr_t>(1));
+}
+
+GLenum APIENTRY null_client_wait_sync(GLsync, GLbitfield, GLuint64) {
+    return GL_ALREADY_SIGNALED;
+}
+
+GLenum APIENTRY null_check_framebuffer_status(GLuint, GLenum) {
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void APIENTRY null_get_query_object(GLuint, GLenum name, GLuint64* value) {
+    *value = name == GL_QUERY_RESULT_AVAILABLE ? 1 : 0;
+}
+
+void APIENTRY null_debug_message_callback(GLDEBUGPROC callback, const void*) {
+    debug_callback = callback;
+}
+
+struct NullEntry {
+    std::string_view name;
+    GLWApiProc proc;
+};
+
+#define NULL_OVERRIDE(NAME, FUNC) NullEntry{ #NAME, reinterpret_cast<GLWApiProc>(&FUNC) }
+
+const NullEntry null_overrides[] = {
+    NULL_OVERRIDE(glCheckNamedFramebufferStatus, null_check_framebuffer_status),
+    NULL_OVERRIDE(glClientWaitSync, null_client_wait_sync),
+    NULL_OVERRIDE(glCreateBuffers, null_create_objects),
+    NULL_OVERRIDE(glCreateFramebuffers, null_create_objects),
+    NULL_OVERRIDE(glCreateProgram, null_create_program),
+    NULL_OVERRIDE(glCreateQueries, null_create_targets),
+    NULL_OVERRIDE(glCreateSamplers, null_create_objects),
+    NULL_OVERRIDE(glCreateShader, null_create_shader),
+    NULL_OVERRIDE(glCreateTextures, null_create_targets),
+    NULL_OVERRIDE(glCreateVertexArrays, null_create_objects),
+    NULL_OVERRIDE(glDebugMessageCallback, null_debug_message_callback),
+    NULL_OVERRIDE(glDeleteBuffers, null_delete_buffers),
+    NULL_OVERRIDE(glFenceSync, null_fence_sync),
+    NULL_OVERRIDE(glGetActiveUniform, null_get_active_uniform),
+    NULL_OVERRIDE(glGetIntegerv, null_get_integer),
+    NULL_OVERRIDE(glGetProgramiv, null_get_object_iv),
+    NULL_OVERRIDE(glGetQueryObjectui64v, null_get_query_object),
+    NULL_OVERRIDE(glGetShaderiv, null_get_object_iv),
+    NULL_OVERRIDE(glGetUniformLocation, null_get_uniform_location),
+    NULL_OVERRIDE(glMapNamedBufferRange, null_map_buffer_range),
+};
+
+#undef NULL_OVERRIDE
+
+const NullEntry null_functions[] = {
+#define NULL_FUNCTION(TYPE, NAME) NullEntry{ #NAME, reinterpret_cast<GLWApiProc>(&NullFunction<TYPE>::call) },
+FOR_OPENGL_FUNCTIONS(NULL_FUNCTION)
+#undef NULL_FUNCTION
+};
+
+GLWApiProc load_null_function(const char* name) {
+    for (const auto& entry : null_overrides) {
+        if (entry.name == name) return entry.proc;
+    }
+    for (const auto& entry : null_functions) {
+        if (entry.name == name) return entry.proc;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+namespace glw::bench {
+
+void init_backend(Backend backend, bool fast_paths) {
+    switch (backend) {
+    using enum Backend;
+    case Null:
+        init(load_null_function, { .debug_output = DebugOutput::Off, .fast_paths = fast_paths });
+        break;
+    case Egl:
+#ifdef GLW_BENCH_EGL
+        tools::create_egl_context();
+        init(tools::load_egl_function, { .debug_output = DebugOutput::Off, .fast_paths = fast_paths });
+        break;
+#else
+        throw cut::Exception("glw_bench was built without GLW_BENCH_EGL!");
+#endif
+    }
+    current_backend = backend;
+}
+
+Backend get_backend() {
+    return current_backend;
+}
+
+const char* to_string(Backend backend) {
+    switch (backend) {
+    using enum Backend;
+    case Null: return "null";
+    case Egl:  return "egl";
+    }
+
+    throw cut::Exception("Unhandled benchmark backend!");
+    return {};
+}
+
+std::span<const char* const> get_null_uniform_names() {
+    return null_uniform_names;
+}
+
+GLDEBUGPROC get_null_debug_callback() {
+    return debug_callback;
+}
+
+GridMesh make_grid(u32 size) {
+    GridMesh grid;
+    u32 side = size + 1;
+    grid.vertex_count = side * side;
+    grid.vertices.resize(static_cast<size_t>(grid.vertex_count) * grid_stride);
+
+    for (u32 y = 0; y < side; ++y) {
+        for (u32 x = 0; x < side; ++x) {
+            // Gentle hills so simplification and culling see non-planar data
+            f32 fx = static_cast<f32>(x) / size;
+            f32 fy = static_cast<f32>(y) / size;
+            glm::vec3 position{ fx, 0.1f * std::sin(fx * 12.0f) * std::cos(fy * 9.0f), fy };
+            glm::vec3 normal{ 0.0f, 1.0f, 0.0f };
+
+            std::byte* vertex = grid.vertices.data() + static_cast<size_t>(y * side + x) * grid_stride;
+            std::memcpy(vertex, &position, sizeof(position));
+            std::memcpy(vertex + sizeof(position), &normal, sizeof(normal));
+        }
+    }
+
+    grid.indices.reserve(static_cast<size_t>(size) * size * 6);
+    for (u32 y = 0; y < size; ++y) {
+        for (u32 x = 0; x < size; ++x) {
+            u32 i = y * side + x;
+            grid.indices.insert(grid.indices.end(), { i, i + side, i + 1, i + 1, i + side, i + side + 1 });
+        }
+    }
+    return grid;
+}
+
+} // namespace glw::bench
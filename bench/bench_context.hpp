@@ -0,0 +1,49 @@
+#pragma once
+#include "glw/glw.hpp"
+
+#include <cut/types.hpp>
+
+#include <span>
+#include <vector>
+
+namespace glw::bench {
+
+using cut::u32;
+using cut::f32;
+
+enum class Backend {
+    Null, // Every entry point is a stub, measures the wrapper alone
+    Egl   // Surfaceless EGL context, llvmpipe when run with LIBGL_ALWAYS_SOFTWARE=1
+};
+
+/*
+* Loads GL through glw::init for the whole benchmark run, fast_paths is passed on in InitOptions
+*/
+void init_backend(Backend backend, bool fast_paths = true);
+Backend get_backend();
+const char* to_string(Backend backend);
+
+/*
+* Uniforms the null driver reports for every program, bench shaders declare the same ones
+*/
+std::span<const char* const> get_null_uniform_names();
+
+/*
+* Callback glw registered through glDebugMessageCallback, only tracked by the null driver
+*/
+GLDEBUGPROC get_null_debug_callback();
+
+/*
+* Indexed grid of size x size quads, interleaved position and normal
+*/
+struct GridMesh {
+    std::vector<std::byte> vertices;
+    std::vector<u32> indices;
+    u32 vertex_count;
+};
+
+constexpr u32 grid_stride = 24;
+
+GridMesh make_grid(u32 size);
+
+} // namespace glw::bench
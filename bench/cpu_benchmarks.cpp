@@ -0,0 +1,203 @@
+#include "bench_context.hpp"
+
+#include "glw/cluster.hpp"
+#include "glw/culling.hpp"
+#include "glw/frustum.hpp"
+#include "glw/mesh_file.hpp"
+#include "glw/mesh_lod.hpp"
+#include "glw/mesh_optimizer.hpp"
+#include "glw/static_batch.hpp"
+#include "glw/texture_atlas.hpp"
+#include "glw/thread_pool.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <filesystem>
+#include <random>
+
+namespace {
+
+using namespace glw;
+using namespace glw::bench;
+
+using GridLayout = VertexLayout<glm::vec3, glm::vec3>;
+
+Frustum make_frustum() {
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3{ 0.0f, 10.0f, 0.0f }, glm::vec3{ 100.0f, 0.0f, 100.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f });
+    return Frustum(projection * view);
+}
+
+void BM_CullSpheres(benchmark::State& state) {
+    auto level = static_cast<SimdLevel>(state.range(0));
+    auto thread_count = static_cast<u32>(state.range(1));
+    auto count = static_cast<u32>(state.range(2));
+    if (level > get_supported_simd_level()) {
+        state.SkipWithError("SIMD level not supported by this CPU");
+        return;
+    }
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<f32> position(-1000.0f, 1000.0f);
+    BoundingSpheres spheres;
+    for (u32 i = 0; i < count; ++i) spheres.add({ position(random), position(random) * 0.05f, position(random) }, 2.0f);
+
+    Frustum frustum = make_frustum();
+    ThreadPool thread_pool(thread_count);
+    std::vector<u32> visible;
+    for (auto _ : state) {
+        if (thread_count == 1) cull_spheres(spheres, frustum, visible, level);
+        else cull_spheres(spheres, frustum, visible, thread_pool, level);
+        benchmark::DoNotOptimize(visible.data());
+    }
+    state.SetItemsProcessed(state.iterations() * spheres.get_size());
+}
+BENCHMARK(BM_CullSpheres)
+    ->ArgsProduct({ { static_cast<int>(SimdLevel::Scalar), static_cast<int>(SimdLevel::SSE2), static_cast<int>(SimdLevel::AVX2) }, { 1, 2, 4, 8 }, { 16384, 1'000'000 } })
+    ->ArgNames({ "simd", "threads", "spheres" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void BM_CullClusters(benchmark::State& state) {
+    auto level = static_cast<SimdLevel>(state.range(0));
+    if (level > get_supported_simd_level()) {
+        state.SkipWithError("SIMD level not supported by this CPU");
+        return;
+    }
+
+    GridMesh grid = make_grid(512);
+    ClusterSet clusters = build_clusters({ grid.vertices, grid.indices, grid_stride, 0 });
+    Frustum frustum(glm::perspective(glm::radians(60.0f), 1.0f, 0.01f, 10.0f) *
+                    glm::lookAt(glm::vec3{ 0.5f, 0.5f, -0.2f }, glm::vec3{ 0.5f, 0.0f, 0.5f }, glm::vec3{ 0.0f, 1.0f, 0.0f }));
+    ClusterDrawList draw_list;
+    for (auto _ : state) {
+        draw_list.clear();
+        benchmark::DoNotOptimize(cull_clusters(clusters, frustum, glm::vec3{ 0.5f, 0.5f, -0.2f }, draw_list, level));
+    }
+    state.SetItemsProcessed(state.iterations() * clusters.bounds.get_size());
+}
+BENCHMARK(BM_CullClusters)
+    ->Arg(static_cast<int>(SimdLevel::Scalar))
+    ->Arg(static_cast<int>(SimdLevel::SSE2))
+    ->Arg(static_cast<int>(SimdLevel::AVX2))
+    ->ArgName("simd");
+
+void BM_OptimizeVertexCache(benchmark::State& state) {
+    GridMesh grid = make_grid(static_cast<u32>(state.range(0)));
+    std::vector<u32> indices;
+    for (auto _ : state) {
+        indices = grid.indices;
+        optimize_vertex_cache(indices, grid.vertex_count);
+    }
+    state.SetItemsProcessed(state.iterations() * grid.indices.size() / 3);
+}
+BENCHMARK(BM_OptimizeVertexCache)->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/*
+* Grid of 724 has 1048352 triangles, levels and coarsest_triangles show what the chain got down to
+*/
+void BM_BuildLodChain(benchmark::State& state) {
+    GridMesh grid = make_grid(static_cast<u32>(state.range(0)));
+    LodSource source{ grid.vertices, grid.indices, grid_stride, 0, {} };
+    LodChain chain;
+    for (auto _ : state) {
+        chain = build_lod_chain(source);
+        benchmark::DoNotOptimize(chain.indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * grid.indices.size() / 3);
+    state.counters["levels"] = static_cast<double>(chain.levels.size());
+    state.counters["coarsest_triangles"] = static_cast<double>(chain.levels.back().index_count / 3);
+}
+BENCHMARK(BM_BuildLodChain)->Arg(64)->Arg(256)->Arg(724)->Unit(benchmark::kMillisecond);
+
+/*
+* build_lod_chains over 8 meshes of 131072 triangles, 1048576 in total, across range(0) threads
+*/
+void BM_BuildLodChains(benchmark::State& state) {
+    auto thread_count = static_cast<u32>(state.range(0));
+    GridMesh grid = make_grid(256);
+    std::vector<LodSource> sources(8, LodSource{ grid.vertices, grid.indices, grid_stride, 0, {} });
+    ThreadPool thread_pool(thread_count);
+    for (auto _ : state) {
+        std::vector<LodChain> chains = build_lod_chains(sources, {}, thread_pool);
+        benchmark::DoNotOptimize(chains.data());
+    }
+    state.SetItemsProcessed(state.iterations() * sources.size() * grid.indices.size() / 3);
+}
+BENCHMARK(BM_BuildLodChains)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->ArgName("threads")
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void BM_AtlasPack(benchmark::State& state) {
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> size(4, 32);
+    std::vector<std::pair<u16, u16>> sizes(100'000);
+    for (auto& [width, height] : sizes) {
+        width = static_cast<u16>(size(random));
+        height = static_cast<u16>(size(random));
+    }
+
+    // Pages are tried in order like TextureAtlas does, so late rects fill holes in early pages
+    std::vector<AtlasPacker> pages;
+    for (auto _ : state) {
+        pages.clear();
+        for (auto [width, height] : sizes) {
+            bool packed = false;
+            for (auto& page : pages) {
+                if (page.insert(width, height)) {
+                    packed = true;
+                    break;
+                }
+            }
+            if (!packed) pages.emplace_back(4096, 4096).insert(width, height);
+        }
+        benchmark::DoNotOptimize(pages.data());
+    }
+
+    double used_area = 0.0;
+    for (const auto& page : pages) used_area += page.get_used_area();
+    state.SetItemsProcessed(state.iterations() * sizes.size());
+    state.counters["pages"] = static_cast<double>(pages.size());
+    state.counters["occupancy"] = used_area / (4096.0 * 4096.0 * pages.size());
+}
+BENCHMARK(BM_AtlasPack)->Unit(benchmark::kMillisecond);
+
+void BM_StaticBatchCreate(benchmark::State& state) {
+    GridMesh grid = make_grid(4);
+    std::vector<StaticBatchMesh> meshes(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        meshes[i] = { grid.vertices, grid.indices, glm::translate(glm::mat4{ 1.0f }, glm::vec3{ static_cast<f32>(i), 0.0f, 0.0f }) };
+    }
+
+    VertexArrayCache cache;
+    for (auto _ : state) {
+        StaticBatch batch(GridLayout::get_format(), meshes, cache, { .position_offset = 0, .normal_offset = 12 });
+        benchmark::DoNotOptimize(batch.get_sub_meshes().data());
+    }
+    state.SetItemsProcessed(state.iterations() * meshes.size());
+}
+BENCHMARK(BM_StaticBatchCreate)->Arg(100)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+void BM_MeshFileLoad(benchmark::State& state) {
+    GridMesh grid = make_grid(256);
+    auto path = std::filesystem::temp_directory_path() / "glw_bench.glwm";
+    write_mesh_file(path, { grid.vertices, grid_stride, GridLayout::attributes, std::as_bytes(std::span{ grid.indices }),
+                            Mesh::IndexType::U32, {} });
+
+    VertexArrayCache cache;
+    for (auto _ : state) {
+        MeshFile file(path);
+        Mesh mesh = file.create_mesh(cache);
+        benchmark::DoNotOptimize(mesh);
+    }
+    state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(path));
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_MeshFileLoad)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,770 @@
+#include "bench_context.hpp"
+
+#include "glw/capabilities.hpp"
+#include "glw/debug_output.hpp"
+#include "glw/draw_data_buffer.hpp"
+#include "glw/fence.hpp"
+#include "glw/framebuffer.hpp"
+#include "glw/gl_instrument.hpp"
+#include "glw/gpu_profiler.hpp"
+#include "glw/mesh.hpp"
+#include "glw/mesh_lod.hpp"
+#include "glw/occlusion_culler.hpp"
+#include "glw/shader.hpp"
+#include "glw/sprite_batch.hpp"
+#include "glw/static_batch.hpp"
+#include "glw/virtual_texture.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace {
+
+using namespace glw;
+using namespace glw::bench;
+
+using GridLayout = VertexLayout<glm::vec3, glm::vec3>;
+
+// Declares the uniforms the null driver reports, see get_null_uniform_names
+constexpr std::string_view vertex_source = R"(#version 450 core
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec3 a_normal;
+uniform mat4 u_model;
+uniform mat4 u_view_projection;
+uniform mat3 u_normal_matrix;
+uniform float u_time;
+out vec3 v_normal;
+void main() {
+    v_normal = u_normal_matrix * a_normal;
+    gl_Position = u_view_projection * u_model * vec4(a_position + vec3(0.0, sin(u_time), 0.0), 1.0);
+}
+)";
+
+constexpr std::string_view fragment_source = R"(#version 450 core
+in vec3 v_normal;
+uniform vec3 u_light_direction;
+uniform vec3 u_color;
+uniform float u_roughness;
+uniform float u_metallic;
+out vec4 o_color;
+void main() {
+    float light = max(dot(normalize(v_normal), u_light_direction), 0.0);
+    o_color = vec4(u_color * light * (1.0 - u_roughness) + u_metallic, 1.0);
+}
+)";
+
+Shader make_shader() {
+    ShaderStage vertex(ShaderStage::Type::Vertex, std::array{ vertex_source });
+    ShaderStage fragment(ShaderStage::Type::Fragment, std::array{ fragment_source });
+    const ShaderStage* stages[] = { &vertex, &fragment };
+    return Shader(stages);
+}
+
+// Draws need a complete framebuffer, surfaceless contexts have no default one
+const FramebufferDescription target_description{ 64, 64, { TextureFormat::RGBA8, TextureFormat::Depth24Stencil8 } };
+
+void BM_ShaderCreate(benchmark::State& state) {
+    for (auto _ : state) {
+        Shader shader = make_shader();
+        benchmark::DoNotOptimize(shader);
+    }
+}
+BENCHMARK(BM_ShaderCreate);
+
+void BM_ShaderSetUniform(benchmark::State& state) {
+    Shader shader = make_shader();
+    glm::mat4 model{ 1.0f };
+    for (auto _ : state) {
+        shader.set_uniform_mat4f("u_model", model);
+        shader.set_uniform_vec3f("u_color", glm::vec3{ 1.0f });
+        shader.set_uniform_1f("u_time", 0.5f);
+    }
+    state.SetItemsProcessed(state.iterations() * 3);
+}
+BENCHMARK(BM_ShaderSetUniform);
+
+void BM_VertexArrayCreate(benchmark::State& state) {
+    for (auto _ : state) {
+        VertexArray vertex_array(GridLayout::get_format());
+        benchmark::DoNotOptimize(vertex_array);
+    }
+}
+BENCHMARK(BM_VertexArrayCreate);
+
+void BM_VertexArrayCacheGet(benchmark::State& state) {
+    VertexArrayCache cache;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(&cache.get(GridLayout::get_format()));
+    }
+}
+BENCHMARK(BM_VertexArrayCacheGet);
+
+void BM_FramebufferResize(benchmark::State& state) {
+    Framebuffer framebuffer({ 256, 256, { TextureFormat::RGBA8, TextureFormat::R32U, TextureFormat::Depth24Stencil8 } });
+    u16 size = 256;
+    for (auto _ : state) {
+        size = size == 256 ? 512 : 256;
+        framebuffer.resize(size, size);
+    }
+}
+BENCHMARK(BM_FramebufferResize);
+
+void BM_MeshCreate(benchmark::State& state) {
+    GridMesh grid = make_grid(static_cast<u32>(state.range(0)));
+    VertexArrayCache cache;
+    for (auto _ : state) {
+        Mesh mesh(grid.vertices, std::as_bytes(std::span{ grid.indices }), Mesh::IndexType::U32, GridLayout::get_format(), cache);
+        benchmark::DoNotOptimize(mesh);
+    }
+    state.SetBytesProcessed(state.iterations() * (grid.vertices.size() + grid.indices.size() * sizeof(u32)));
+}
+BENCHMARK(BM_MeshCreate)->Arg(8)->Arg(64)->Arg(256);
+
+/*
+* Environment map load, creating a mipmapped 128x128 CubemapArray of 4 cubes for range(0) 1 or a
+* Texture2DArray of 24 layers for 0 and uploading every level, with a fresh single region TextureStaging per load
+* for range(1) 0, the way set_pixels used to allocate, and one kept across loads for 1
+*/
+void BM_EnvMapUpload(benchmark::State& state) {
+    TextureDescription desc{
+        .type = state.range(0) ? TextureType::CubemapArray : TextureType::Texture2DArray,
+        .format = TextureFormat::RGBA8,
+        .width = 128,
+        .height = 128,
+        .layers = static_cast<u16>(state.range(0) ? 4 : 24),
+        .levels = 8
+    };
+    size_t size = 0;
+    for (u16 level = 0; level < desc.levels; ++level) size += static_cast<size_t>(128 >> level) * (128 >> level) * 24 * 4;
+    std::vector<std::byte> pixels(size, std::byte{ 0x80 });
+
+    bool reuse = state.range(1) != 0;
+    std::optional<TextureStaging> staging;
+    for (auto _ : state) {
+        if (!reuse || !staging) staging.emplace(0, reuse ? 3u : 1u);
+        Texture texture(desc);
+        texture.set_pixels(pixels, 4, *staging);
+        Fence().wait();
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_EnvMapUpload)->ArgsProduct({ { 0, 1 }, { 0, 1 } })->ArgNames({ "cube", "reuse" })->Unit(benchmark::kMillisecond);
+
+/*
+* 16 mipmapped 256x256 textures uploaded back to back through one TextureStaging of range(0) regions
+* A single region waits for each copy before the next upload can be written, as set_pixels used to
+*/
+void BM_TextureUploadBurst(benchmark::State& state) {
+    constexpr u32 texture_count = 16;
+    TextureDescription desc{ .format = TextureFormat::RGBA8, .width = 256, .height = 256, .levels = 9 };
+    size_t size = 0;
+    for (u16 level = 0; level < desc.levels; ++level) size += static_cast<size_t>(256 >> level) * (256 >> level) * 4;
+    std::vector<std::byte> pixels(size, std::byte{ 0x80 });
+
+    std::vector<std::unique_ptr<Texture>> textures;
+    for (u32 i = 0; i < texture_count; ++i) textures.push_back(std::make_unique<Texture>(desc));
+    TextureStaging staging(size, static_cast<u32>(state.range(0)));
+    for (auto _ : state) {
+        for (const auto& texture : textures) texture->set_pixels(pixels, 4, staging);
+        Fence().wait();
+    }
+    state.SetBytesProcessed(state.iterations() * size * texture_count);
+}
+BENCHMARK(BM_TextureUploadBurst)->Arg(1)->Arg(3)->ArgName("regions")->Unit(benchmark::kMillisecond);
+
+/*
+* Draw loop over meshes each owning its VertexArray for range(0) 0, sharing one from VertexArrayCache for 1
+*/
+void BM_MeshDrawLoop(benchmark::State& state) {
+    constexpr u32 mesh_count = 1000;
+    Framebuffer target(target_description);
+    target.bind();
+    Shader shader = make_shader();
+    GridMesh grid = make_grid(2);
+    auto indices = std::as_bytes(std::span{ grid.indices });
+    VertexArrayCache cache;
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    for (u32 i = 0; i < mesh_count; ++i) {
+        if (state.range(0) == 0) {
+            meshes.push_back(std::make_unique<Mesh>(grid.vertices, indices, Mesh::IndexType::U32,
+                                                    std::initializer_list{ VertexDataType::F32_3, VertexDataType::F32_3 }));
+        }
+        else {
+            meshes.push_back(std::make_unique<Mesh>(grid.vertices, indices, Mesh::IndexType::U32, GridLayout::get_format(), cache));
+        }
+    }
+
+    shader.bind();
+    for (auto _ : state) {
+        for (const auto& mesh : meshes) {
+            mesh->bind();
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh->get_index_count()), GL_UNSIGNED_INT, nullptr);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * mesh_count);
+    state.counters["vertex_arrays"] = static_cast<double>(state.range(0) == 0 ? mesh_count : cache.get_size());
+}
+BENCHMARK(BM_MeshDrawLoop)->Arg(0)->Arg(1);
+
+/*
+* Per-draw data through one uniform upload per draw against a persistent ring indexed by base instance or an index uniform
+*/
+constexpr u32 draws_per_frame = 1000;
+
+void BM_DrawUniformPerDraw(benchmark::State& state) {
+    Framebuffer target(target_description);
+    target.bind();
+    Shader shader = make_shader();
+    GridMesh grid = make_grid(1);
+    VertexArrayCache cache;
+    Mesh mesh(grid.vertices, std::as_bytes(std::span{ grid.indices }), Mesh::IndexType::U32, GridLayout::get_format(), cache);
+
+    shader.bind();
+    mesh.bind();
+    for (auto _ : state) {
+        for (u32 i = 0; i < draws_per_frame; ++i) {
+            shader.set_uniform_mat4f("u_model", glm::mat4{ static_cast<f32>(i) });
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh.get_index_count()), GL_UNSIGNED_INT, nullptr);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * draws_per_frame);
+}
+BENCHMARK(BM_DrawUniformPerDraw);
+
+constexpr std::string_view draw_data_prelude = R"(
+#define GLW_DRAW_DATA_BINDING 0
+struct DrawData { mat4 model; };
+)";
+
+constexpr std::string_view draw_data_vertex_source = R"(
+layout(location = 0) in vec3 a_position;
+uniform mat4 u_view_projection;
+void main() {
+    gl_Position = u_view_projection * glw_draw_data[glw_draw_index].model * vec4(a_position, 1.0);
+}
+)";
+
+constexpr std::string_view draw_data_fragment_source = R"(#version 450 core
+uniform vec3 u_color;
+out vec4 o_color;
+void main() {
+    o_color = vec4(u_color, 1.0);
+}
+)";
+
+/*
+* Index through base instance or, with GLW_DRAW_INDEX_UNIFORM, through the glw_draw_index uniform
+*/
+Shader make_draw_data_shader(bool index_uniform) {
+    std::string_view index_source = index_uniform ? "#define GLW_DRAW_INDEX_UNIFORM\n" : DrawDataBuffer::glsl_extension;
+    ShaderStage vertex(ShaderStage::Type::Vertex, std::array{ std::string_view{ "#version 450 core\n" }, index_source, draw_data_prelude,
+                                                              DrawDataBuffer::glsl_source, draw_data_vertex_source });
+    ShaderStage fragment(ShaderStage::Type::Fragment, std::array{ draw_data_fragment_source });
+    const ShaderStage* stages[] = { &vertex, &fragment };
+    return Shader(stages);
+}
+
+void BM_DrawDataBuffer(benchmark::State& state) {
+    bool index_uniform = state.range(0) != 0;
+    Framebuffer target(target_description);
+    target.bind();
+    Shader shader = make_draw_data_shader(index_uniform);
+    GridMesh grid = make_grid(1);
+    VertexArrayCache cache;
+    Mesh mesh(grid.vertices, std::as_bytes(std::span{ grid.indices }), Mesh::IndexType::U32, GridLayout::get_format(), cache);
+    DrawDataBuffer draw_data({ .struct_size = sizeof(glm::mat4), .max_draws = draws_per_frame });
+
+    shader.bind();
+    shader.set_uniform_mat4f("u_view_projection", glm::mat4{ 1.0f });
+    shader.set_uniform_vec3f("u_color", glm::vec3{ 1.0f });
+    mesh.bind();
+    for (auto _ : state) {
+        draw_data.begin_frame();
+        for (u32 i = 0; i < draws_per_frame; ++i) {
+            u32 draw_index = draw_data.push(glm::mat4{ static_cast<f32>(i) });
+            if (index_uniform) {
+                DrawDataBuffer::draw(shader, mesh, draw_index);
+            }
+            else {
+                DrawDataBuffer::draw(mesh, draw_index);
+            }
+        }
+        draw_data.end_frame();
+    }
+    state.SetItemsProcessed(state.iterations() * draws_per_frame);
+}
+BENCHMARK(BM_DrawDataBuffer)->ArgName("index_uniform")->Arg(0)->Arg(1);
+
+/*
+* Every other mesh of a batch visible so no ranges merge, compare runs with --glw_fast_paths=false
+*/
+void BM_StaticBatchDraw(benchmark::State& state) {
+    Framebuffer target(target_description);
+    target.bind();
+    Shader shader = make_shader();
+    GridMesh grid = make_grid(2);
+    std::vector<StaticBatchMesh> meshes(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        meshes[i] = { grid.vertices, grid.indices, glm::translate(glm::mat4{ 1.0f }, glm::vec3{ static_cast<f32>(i), 0.0f, 0.0f }) };
+    }
+    VertexArrayCache cache;
+    StaticBatch batch(GridLayout::get_format(), meshes, cache, { .position_offset = 0, .normal_offset = 12 });
+
+    std::vector<u32> visible;
+    for (u32 i = 0; i < meshes.size(); i += 2) visible.push_back(i);
+    shader.bind();
+    for (auto _ : state) {
+        batch.draw(visible);
+    }
+    state.SetItemsProcessed(state.iterations() * visible.size());
+}
+BENCHMARK(BM_StaticBatchDraw)->Arg(1000)->Arg(10000);
+
+/*
+* 100k sprites over contiguous runs of range(0) textures, quads_per_ms counts quads per millisecond
+*/
+constexpr u32 sprites_per_frame = 100000;
+
+std::vector<std::unique_ptr<Texture>> make_sprite_textures(u32 count) {
+    std::vector<std::unique_ptr<Texture>> textures;
+    for (u32 i = 0; i < count; ++i) textures.push_back(std::make_unique<Texture>(TextureDescription{ .width = 4, .height = 4 }));
+    return textures;
+}
+
+Sprite to_sprite(u32 i, const std::vector<std::unique_ptr<Texture>>& textures) {
+    auto x = static_cast<f32>(i % 256);
+    auto y = static_cast<f32>(i / 256 % 256);
+    return { { x, y }, { 2.0f, 2.0f }, { 0.0f, 0.0f, 1.0f, 1.0f }, 0xFFFFFFFF - i, textures[i * textures.size() / sprites_per_frame].get() };
+}
+
+void set_quads_per_ms(benchmark::State& state) {
+    state.SetItemsProcessed(state.iterations() * sprites_per_frame);
+    state.counters["quads_per_ms"] = benchmark::Counter(static_cast<double>(state.iterations()) * sprites_per_frame / 1000.0,
+                                                        benchmark::Counter::kIsRate);
+}
+
+void BM_SpriteBatch(benchmark::State& state) {
+    Framebuffer target(target_description);
+    target.bind();
+    auto textures = make_sprite_textures(static_cast<u32>(state.range(0)));
+    SpriteBatch batch({ .max_quads = sprites_per_frame });
+    glm::mat4 view_projection = glm::ortho(0.0f, 256.0f, 0.0f, 256.0f);
+
+    for (auto _ : state) {
+        batch.begin_frame(view_projection);
+        for (u32 i = 0; i < sprites_per_frame; ++i) batch.draw(to_sprite(i, textures));
+        batch.end_frame();
+    }
+    set_quads_per_ms(state);
+    state.counters["draws"] = static_cast<double>(batch.get_draw_count());
+}
+BENCHMARK(BM_SpriteBatch)->Arg(1)->Arg(16)->Arg(64)->Unit(benchmark::kMillisecond);
+
+/*
+* The same sprites as one Buffer::write and draw each
+*/
+void BM_SpritePerQuadDraw(benchmark::State& state) {
+    Framebuffer target(target_description);
+    target.bind();
+    auto textures = make_sprite_textures(static_cast<u32>(state.range(0)));
+    Shader shader = make_shader();
+    Buffer vertex_buffer(4 * sizeof(SpriteVertex));
+    const u16 quad_indices[] = { 0, 1, 2, 2, 3, 0 };
+    Buffer index_buffer(std::as_bytes(std::span{ quad_indices }));
+    VertexArray vertex_array(SpriteLayout::get_format());
+    vertex_array.set_vertex_buffer(vertex_buffer);
+    vertex_array.set_index_buffer(index_buffer);
+
+    shader.bind();
+    vertex_array.bind();
+    for (auto _ : state) {
+        for (u32 i = 0; i < sprites_per_frame; ++i) {
+            Sprite sprite = to_sprite(i, textures);
+            glm::vec2 max = sprite.position + sprite.size;
+            const SpriteVertex quad[] = {
+                { sprite.position, { 0.0f, 0.0f }, sprite.color, 0 },
+                { { max.x, sprite.position.y }, { 1.0f, 0.0f }, sprite.color, 0 },
+                { max, { 1.0f, 1.0f }, sprite.color, 0 },
+                { { sprite.position.x, max.y }, { 0.0f, 1.0f }, sprite.color, 0 }
+            };
+            sprite.texture->bind(0);
+            vertex_buffer.write(std::as_bytes(std::span{ quad }));
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr);
+        }
+    }
+    set_quads_per_ms(state);
+}
+BENCHMARK(BM_SpritePerQuadDraw)->Arg(1)->Arg(64)->Unit(benchmark::kMillisecond);
+
+/*
+* City of upright grids behind a wall covering most of the view, range(0) turns occlusion culling on
+* On EGL primitives, samples and fragments count the building pass of one more frame
+*/
+constexpr u32 city_side = 32;
+const FramebufferDescription city_target_description{ 256, 256, { TextureFormat::RGBA8, TextureFormat::Depth24Stencil8 } };
+
+/*
+* Grid of make_grid standing up to face the camera, its hills becoming depth
+*/
+glm::mat4 to_upright_grid(glm::vec3 center, f32 size) {
+    glm::mat4 model{ 0.0f };
+    model[0] = { size, 0.0f, 0.0f, 0.0f };
+    model[1] = { 0.0f, 0.0f, 1.0f, 0.0f };
+    model[2] = { 0.0f, size, 0.0f, 0.0f };
+    model[3] = { center.x - size / 2.0f, center.y - size / 2.0f, center.z, 1.0f };
+    return model;
+}
+
+void BM_OcclusionCulledCity(benchmark::State& state) {
+    Framebuffer target(city_target_description);
+    target.bind();
+    glViewport(0, 0, city_target_description.width, city_target_description.height);
+    glEnable(GL_DEPTH_TEST);
+    Shader shader = make_shader();
+    GridMesh grid = make_grid(16);
+    VertexArrayCache cache;
+    Mesh mesh(grid.vertices, std::as_bytes(std::span{ grid.indices }), Mesh::IndexType::U32, GridLayout::get_format(), cache);
+
+    // Same screen size at every depth, the wall hides about three quarters of the buildings
+    std::vector<glm::mat4> models;
+    std::vector<OcclusionBounds> bounds;
+    for (u32 i = 0; i < city_side * city_side; ++i) {
+        f32 depth = 10.0f + static_cast<f32>(i % 7) * 5.0f;
+        glm::vec2 position = (glm::vec2{ static_cast<f32>(i % city_side), static_cast<f32>(i / city_side) } + 0.5f) / static_cast<f32>(city_side) * 2.0f - 1.0f;
+        glm::vec3 center{ position.x * 0.5f * depth, position.y * 0.5f * depth, -depth };
+        f32 size = 0.04f * depth;
+        models.push_back(to_upright_grid(center, size));
+        bounds.push_back({ center - glm::vec3{ size / 2.0f, size / 2.0f, 0.1f }, center + glm::vec3{ size / 2.0f, size / 2.0f, 0.1f } });
+    }
+    glm::mat4 wall = to_upright_grid({ 0.0f, 0.0f, -5.0f }, 4.6f);
+    glm::mat4 view_projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+    glm::vec3 camera_position{ 0.0f };
+
+    bool culling = state.range(0) != 0;
+    OcclusionCuller culler({ .max_objects = city_side * city_side });
+    auto draw_wall_and_query = [&] {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        shader.bind();
+        shader.set_uniform_mat4f("u_view_projection", view_projection);
+        shader.set_uniform_mat4f("u_model", wall);
+        mesh.bind();
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh.get_index_count()), GL_UNSIGNED_INT, nullptr);
+
+        if (culling) {
+            culler.begin_frame();
+            culler.query(bounds, view_projection, camera_position);
+            shader.bind();
+            mesh.bind();
+        }
+    };
+    auto draw_buildings = [&] {
+        for (u32 i = 0; i < models.size(); ++i) {
+            shader.set_uniform_mat4f("u_model", models[i]);
+            if (culling) culler.begin_conditional(i);
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh.get_index_count()), GL_UNSIGNED_INT, nullptr);
+            if (culling) culler.end_conditional();
+        }
+        if (culling) culler.end_frame();
+    };
+
+    for (auto _ : state) {
+        draw_wall_and_query();
+        draw_buildings();
+    }
+    state.SetItemsProcessed(state.iterations() * models.size());
+    state.counters["queries"] = static_cast<double>(culler.get_stats().queries);
+    state.counters["occluded"] = static_cast<double>(culler.get_stats().occluded);
+
+    if (get_backend() == Backend::Egl) {
+        // Samples staying the same with culling shows nothing visible was skipped
+        constexpr std::array<GLenum, 3> targets = { GL_PRIMITIVES_GENERATED, GL_SAMPLES_PASSED, GL_FRAGMENT_SHADER_INVOCATIONS_ARB };
+        u32 count = get_capabilities().has_extension("GL_ARB_pipeline_statistics_query") ? 3 : 2;
+        std::array<GLuint, 3> queries{};
+        for (u32 i = 0; i < count; ++i) glCreateQueries(targets[i], 1, &queries[i]);
+
+        draw_wall_and_query();
+        for (u32 i = 0; i < count; ++i) glBeginQuery(targets[i], queries[i]);
+        draw_buildings();
+        for (u32 i = 0; i < count; ++i) glEndQuery(targets[i]);
+
+        std::array<GLuint64, 3> results{};
+        for (u32 i = 0; i < count; ++i) glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &results[i]);
+        glDeleteQueries(static_cast<GLsizei>(count), queries.data());
+        state.counters["primitives"] = static_cast<double>(results[0]);
+        state.counters["samples"] = static_cast<double>(results[1]);
+        // llvmpipe doesn't count fragment shader invocations
+        if (results[2] > 0) state.counters["fragments"] = static_cast<double>(results[2]);
+    }
+    glDisable(GL_DEPTH_TEST);
+}
+BENCHMARK(BM_OcclusionCulledCity)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+/*
+* 64 copies of a 131072 triangle grid from 1 to 64 units away, all drawing the first LOD level
+* for range(0) 0 and the level Mesh::get_lod picks for their distance for 1
+*/
+void BM_LodDraw(benchmark::State& state) {
+    constexpr u32 copy_count = 64;
+    Framebuffer target(city_target_description);
+    target.bind();
+    glViewport(0, 0, city_target_description.width, city_target_description.height);
+    Shader shader = make_shader();
+
+    GridMesh grid = make_grid(256);
+    LodChain chain = build_lod_chain({ grid.vertices, grid.indices, grid_stride, 0, {} });
+    VertexArrayCache cache;
+    Mesh mesh(grid.vertices, std::as_bytes(std::span{ chain.indices }), Mesh::IndexType::U32, GridLayout::get_format(), cache);
+    mesh.set_lods(chain.levels);
+
+    f32 fov_y = glm::radians(60.0f);
+    bool select = state.range(0) != 0;
+    std::vector<glm::mat4> models;
+    std::vector<LodLevel> lods;
+    for (u32 i = 0; i < copy_count; ++i) {
+        f32 distance = 1.0f + static_cast<f32>(i);
+        models.push_back(to_upright_grid({ 0.0f, 0.0f, -distance }, 1.0f));
+        lods.push_back(select ? mesh.get_lod(distance, fov_y, static_cast<f32>(city_target_description.height)) : mesh.get_lods().front());
+    }
+
+    shader.bind();
+    shader.set_uniform_mat4f("u_view_projection", glm::perspective(fov_y, 1.0f, 0.1f, 100.0f));
+    mesh.bind();
+    size_t triangles = 0;
+    for (const auto& lod : lods) triangles += lod.index_count / 3;
+    for (auto _ : state) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for (u32 i = 0; i < copy_count; ++i) {
+            shader.set_uniform_mat4f("u_model", models[i]);
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(lods[i].index_count), GL_UNSIGNED_INT,
+                           reinterpret_cast<const void*>(static_cast<size_t>(lods[i].first_index) * sizeof(u32)));
+        }
+        Fence().wait();
+    }
+    state.SetItemsProcessed(state.iterations() * copy_count);
+    state.counters["triangles"] = static_cast<double>(triangles);
+    state.counters["levels"] = static_cast<double>(mesh.get_lods().size());
+}
+BENCHMARK(BM_LodDraw)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+/*
+* Depth only pass over a 48 byte vertex, through bind_positions of an interleaved mesh for range(0) 0
+* and of a mesh keeping positions in their own stream for 1, vertex_bytes counts what each pass fetches
+*/
+using FatLayout = VertexLayout<glm::vec3, glm::vec3, glm::vec2, glm::vec4>;
+using FatAttributesLayout = VertexLayout<glm::vec3, glm::vec2, glm::vec4>;
+using PositionLayout = VertexLayout<glm::vec3>;
+
+constexpr std::string_view depth_vertex_source = R"(#version 450 core
+layout(location = 0) in vec3 a_position;
+uniform mat4 u_view_projection;
+void main() {
+    gl_Position = u_view_projection * vec4(a_position, 1.0);
+}
+)";
+
+constexpr std::string_view depth_fragment_source = R"(#version 450 core
+void main() {}
+)";
+
+void BM_DepthPass(benchmark::State& state) {
+    Framebuffer target(city_target_description);
+    target.bind();
+    glViewport(0, 0, city_target_description.width, city_target_description.height);
+    glEnable(GL_DEPTH_TEST);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    ShaderStage vertex(ShaderStage::Type::Vertex, std::array{ depth_vertex_source });
+    ShaderStage fragment(ShaderStage::Type::Fragment, std::array{ depth_fragment_source });
+    const ShaderStage* stages[] = { &vertex, &fragment };
+    Shader shader(stages);
+
+    GridMesh grid = make_grid(512);
+    std::vector<std::byte> interleaved(static_cast<size_t>(grid.vertex_count) * FatLayout::stride);
+    std::vector<std::byte> positions(static_cast<size_t>(grid.vertex_count) * PositionLayout::stride);
+    std::vector<std::byte> attributes(static_cast<size_t>(grid.vertex_count) * FatAttributesLayout::stride);
+    for (u32 i = 0; i < grid.vertex_count; ++i) {
+        const std::byte* source = grid.vertices.data() + static_cast<size_t>(i) * grid_stride;
+        std::memcpy(interleaved.data() + static_cast<size_t>(i) * FatLayout::stride, source, grid_stride);
+        std::memcpy(positions.data() + static_cast<size_t>(i) * PositionLayout::stride, source, PositionLayout::stride);
+        std::memcpy(attributes.data() + static_cast<size_t>(i) * FatAttributesLayout::stride, source + PositionLayout::stride,
+                    grid_stride - PositionLayout::stride);
+    }
+
+    VertexArrayCache cache;
+    auto indices = std::as_bytes(std::span{ grid.indices });
+    bool split = state.range(0) != 0;
+    std::optional<Mesh> mesh;
+    if (split) {
+        VertexStream streams[] = { { positions, PositionLayout::get_format() }, { attributes, FatAttributesLayout::get_format() } };
+        mesh.emplace(streams, indices, Mesh::IndexType::U32, cache);
+    }
+    else {
+        mesh.emplace(interleaved, indices, Mesh::IndexType::U32, FatLayout::get_format(), cache);
+    }
+
+    glm::mat4 view_projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 10.0f) *
+                                glm::lookAt(glm::vec3{ 0.5f, 1.0f, -0.5f }, glm::vec3{ 0.5f, 0.0f, 0.5f }, glm::vec3{ 0.0f, 1.0f, 0.0f });
+    shader.set_uniform_mat4f("u_view_projection", view_projection);
+    shader.bind();
+    for (auto _ : state) {
+        glClear(GL_DEPTH_BUFFER_BIT);
+        mesh->bind_positions();
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh->get_index_count()), GL_UNSIGNED_INT, nullptr);
+        Fence().wait();
+    }
+    u32 stride = split ? PositionLayout::stride : FatLayout::stride;
+    state.SetItemsProcessed(state.iterations() * grid.indices.size() / 3);
+    state.counters["vertex_bytes"] = static_cast<double>(grid.vertex_count) * stride;
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDisable(GL_DEPTH_TEST);
+}
+BENCHMARK(BM_DepthPass)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+/*
+* Camera panning over a synthetic 256k x 256k image, 256 GiB of RGBA8 that never exists in memory
+* Each frame requests a window of pages the way feedback would, pages are filled procedurally
+*/
+void BM_VirtualTextureStream(benchmark::State& state) {
+    constexpr u32 window_pages = 24;
+    VirtualTexture texture({ .width = 262144, .height = 262144, .page_size = 128, .max_uploads_per_frame = 64 },
+                           [](u32 page_x, u32 page_y, std::span<std::byte> pixels) {
+                               std::memset(pixels.data(), static_cast<int>((page_x ^ page_y) & 0xFF), pixels.size());
+                           });
+
+    std::vector<u32> page_ids;
+    size_t requested = 0;
+    size_t resident = 0;
+    size_t uploaded = 0;
+    u32 frame = 0;
+    for (auto _ : state) {
+        // One page per frame along the diagonal, the cache keeps up after the first frames
+        u32 origin = frame++ % (texture.get_width_pages() - window_pages);
+        page_ids.clear();
+        for (u32 y = 0; y < window_pages; ++y) {
+            for (u32 x = 0; x < window_pages; ++x) page_ids.push_back(VirtualTexture::to_page_id(origin + x, origin + y));
+        }
+        texture.request_pages(page_ids);
+        texture.update();
+
+        const auto& stats = texture.get_stats();
+        requested += stats.requested_pages;
+        resident += stats.resident_pages;
+        uploaded += stats.uploaded_pages;
+    }
+    state.SetItemsProcessed(state.iterations() * window_pages * window_pages);
+    state.counters["hit_rate"] = requested ? static_cast<double>(resident) / static_cast<double>(requested) : 1.0;
+    state.counters["uploads_per_frame"] = static_cast<double>(uploaded) / static_cast<double>(state.iterations());
+    state.counters["footprint_mb"] = static_cast<double>(texture.get_stats().memory_footprint) / (1024.0 * 1024.0);
+}
+BENCHMARK(BM_VirtualTextureStream);
+
+/*
+* Three frames over a 4x4 page texture and a 2x2 page cache, checked against the LRU evictions and page table
+* they should produce, fails the run on a mismatch. Each frame lists the page indices it requests, the page
+* each cache slot holds afterwards and how many pages it evicts
+*/
+void BM_VirtualTextureEviction(benchmark::State& state) {
+    struct Frame {
+        std::vector<u32> pages;
+        std::array<u32, 4> slot_pages;
+        u32 evicted;
+    };
+    const Frame frames[] = {
+        { { 0, 1, 2, 3 }, { 0, 1, 2, 3 }, 0 },
+        { { 0, 1, 4 }, { 0, 1, 4, 3 }, 1 },  // Page 2 is the least recently used
+        { { 5, 6 }, { 6, 1, 4, 5 }, 2 }      // Then page 3 and page 0
+    };
+    constexpr u32 width_pages = 4;
+    constexpr u32 page_count = width_pages * width_pages;
+
+    std::vector<u32> page_ids;
+    for (auto _ : state) {
+        VirtualTexture texture({ .width = 64, .height = 64, .page_size = 16, .cache_width_pages = 2, .cache_height_pages = 2 },
+                               [](u32, u32, std::span<std::byte> pixels) { std::ranges::fill(pixels, std::byte{ 0xFF }); });
+
+        for (const auto& frame : frames) {
+            page_ids.clear();
+            for (u32 page : frame.pages) page_ids.push_back(VirtualTexture::to_page_id(page % width_pages, page / width_pages));
+            texture.request_pages(page_ids);
+            texture.update();
+
+            if (texture.get_stats().evicted_pages != frame.evicted) {
+                state.SkipWithError("Virtual texture evicted an unexpected number of pages");
+                return;
+            }
+            for (u32 page = 0; page < page_count; ++page) {
+                auto entry = texture.get_page_table_entry(page % width_pages, page / width_pages);
+                auto slot = std::ranges::find(frame.slot_pages, page);
+                bool resident = slot != frame.slot_pages.end();
+                u32 slot_index = resident ? cut::to_u32(slot - frame.slot_pages.begin()) : 0;
+                if ((entry.resident != 0) != resident || (resident && (entry.x != slot_index % 2 || entry.y != slot_index / 2))) {
+                    state.SkipWithError("Virtual texture page table doesn't match the expected LRU order");
+                    return;
+                }
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * std::size(frames));
+}
+BENCHMARK(BM_VirtualTextureEviction);
+
+void BM_GpuProfilerScope(benchmark::State& state) {
+    GpuProfiler profiler;
+    for (auto _ : state) {
+        profiler.begin_frame();
+        for (u32 i = 0; i < 64; ++i) {
+            GLW_GPU_SCOPE(profiler, "scope");
+        }
+        profiler.end_frame();
+    }
+    state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_GpuProfilerScope);
+
+/*
+* Cost the debug callback adds to the GL call reporting a message, one repeated id or 64 cycling ones
+*/
+void BM_DebugCallbackAsync(benchmark::State& state) {
+    if (get_backend() != Backend::Null) {
+        state.SkipWithError("Needs the null driver to call the callback directly");
+        return;
+    }
+
+    set_debug_output(DebugOutput::Async);
+    GLDEBUGPROC callback = get_null_debug_callback();
+    GLuint id_count = static_cast<GLuint>(state.range(0));
+    GLuint id = 0;
+    for (auto _ : state) {
+        callback(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_PERFORMANCE, id++ % id_count, GL_DEBUG_SEVERITY_LOW, -1,
+                 "Buffer object will be used as the source for buffer copy operations", nullptr);
+    }
+    set_debug_output(DebugOutput::Off);
+    state.counters["dropped"] = static_cast<double>(get_debug_message_counts().dropped);
+}
+BENCHMARK(BM_DebugCallbackAsync)->Arg(1)->Arg(64);
+
+void BM_InstrumentedCall(benchmark::State& state) {
+    auto mode = static_cast<GLInstrumentMode>(state.range(0));
+    if (GLW_INSTRUMENT_GL == 0 && mode != GLInstrumentMode::Off) {
+        state.SkipWithError("glw was built without GLW_INSTRUMENT_GL");
+        return;
+    }
+
+    set_gl_instrument_mode(mode);
+    for (auto _ : state) {
+        glBindVertexArray(0);
+    }
+    set_gl_instrument_mode(GLInstrumentMode::Off);
+}
+BENCHMARK(BM_InstrumentedCall)->DenseRange(0, 2);
+
+} // namespace
@@ -0,0 +1,48 @@
+#include "bench_context.hpp"
+
+#include "glw/capabilities.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+/*
+* Runs every registered scenario on the chosen backend:
+*   glw_bench [--glw_backend=null|egl] [--glw_fast_paths=false] [google benchmark flags]
+* --benchmark_format=json or --benchmark_out=<file> give results for regression tracking
+*/
+int main(int argc, char** argv) {
+    using namespace glw::bench;
+
+    Backend backend = Backend::Null;
+    bool fast_paths = true;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--glw_backend=egl") == 0) backend = Backend::Egl;
+        else if (std::strcmp(argv[i], "--glw_backend=null") == 0) backend = Backend::Null;
+        else if (std::strcmp(argv[i], "--glw_fast_paths=false") == 0) fast_paths = false;
+        else args.push_back(argv[i]);
+    }
+
+    int arg_count = static_cast<int>(args.size());
+    benchmark::Initialize(&arg_count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(arg_count, args.data())) return 1;
+
+    try {
+        init_backend(backend, fast_paths);
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    benchmark::AddCustomContext("glw_backend", to_string(backend));
+    benchmark::AddCustomContext("glw_fast_paths", fast_paths ? "true" : "false");
+    benchmark::AddCustomContext("gl_renderer", glw::get_capabilities().renderer);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -1,6 +1,37 @@
 #include "glw/buffer.hpp"
 #include "glw/glw.hpp"
 
+#include <cut/exception.hpp>
+
+namespace {
+
+using namespace glw;
+
+GLbitfield to_gl_storage_flags(BufferUsage usage) {
+    switch (usage) {
+    using enum BufferUsage;
+    case Dynamic:         return GL_DYNAMIC_STORAGE_BIT;
+    case Readback:        return GL_CLIENT_STORAGE_BIT;
+    case PersistentWrite: return GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    }
+
+    throw cut::Exception("Unhandled buffer usage!");
+    return {};
+}
+
+GLenum to_gl_enum(BufferBinding binding) {
+    switch (binding) {
+    using enum BufferBinding;
+    case Uniform:       return GL_UNIFORM_BUFFER;
+    case ShaderStorage: return GL_SHADER_STORAGE_BUFFER;
+    }
+
+    throw cut::Exception("Unhandled buffer binding!");
+    return {};
+}
+
+} // namespace
+
 namespace glw {
 
 Buffer::Buffer(std::span<const std::byte> bytes) :
@@ -13,18 +44,32 @@ Buffer::Buffer(std::span<const std::byte> bytes) :
     glNamedBufferStorage(handle, bytes.size(), bytes.data(), 0);
 }
 
-Buffer::Buffer(size_t size) :
+Buffer::Buffer(size_t size, BufferUsage usage) :
     handle_(0u, [](u32 handle) { glDeleteBuffers(1, &handle); })
 {
     GLuint handle;
     glCreateBuffers(1, &handle);
     handle_.reset(handle);
 
-    glNamedBufferStorage(handle, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(handle, size, nullptr, to_gl_storage_flags(usage));
+
+    if (usage == BufferUsage::PersistentWrite) {
+        void* mapping = glMapNamedBufferRange(handle, 0, size, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+        cut::ensure(mapping != nullptr, "Failed to map buffer!");
+        mapping_ = { static_cast<std::byte*>(mapping), size };
+    }
 }
 
 void Buffer::write(std::span<const std::byte> bytes) const {
     glNamedBufferSubData(handle_.get(), 0, bytes.size(), bytes.data());
 }
 
+void Buffer::read(std::span<std::byte> bytes, size_t offset) const {
+    glGetNamedBufferSubData(handle_.get(), offset, bytes.size(), bytes.data());
+}
+
+void Buffer::bind_range(BufferBinding binding, u32 index, size_t offset, size_t size) const {
+    glBindBufferRange(to_gl_enum(binding), index, handle_.get(), offset, size);
+}
+
 } // namespace glw
@@ -0,0 +1,111 @@
+#include "glw/capabilities.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+using namespace glw;
+
+Capabilities capabilities;
+
+std::string get_string(GLenum name) {
+    auto string = reinterpret_cast<const char*>(glGetString(name));
+    return string ? string : "";
+}
+
+u32 get_integer(GLenum name) {
+    GLint value = 0;
+    glGetIntegerv(name, &value);
+    return static_cast<u32>(std::max(value, 0));
+}
+
+// Block sizes may not fit a GLint
+u32 get_size(GLenum name) {
+    GLint64 value = 0;
+    glGetInteger64v(name, &value);
+    return static_cast<u32>(std::clamp<GLint64>(value, 0, std::numeric_limits<u32>::max()));
+}
+
+std::vector<std::string> get_extensions() {
+    std::vector<std::string> extensions;
+    u32 count = get_integer(GL_NUM_EXTENSIONS);
+    for (u32 i = 0; i < count; ++i) {
+        if (auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i))) extensions.emplace_back(name);
+    }
+    std::sort(extensions.begin(), extensions.end());
+    return extensions;
+}
+
+/*
+* Loaders may hand out pointers for anything, so only ask for entry points the context advertises
+*/
+template<typename T>
+bool load_optional(T& function, const char* name, GLWLoadFunc func) {
+    function = reinterpret_cast<T>(func(name));
+    return function != nullptr;
+}
+
+} // namespace
+
+namespace glw {
+
+bool Capabilities::has_extension(std::string_view name) const {
+    return std::binary_search(extensions.begin(), extensions.end(), name, std::less<>{});
+}
+
+void detect_capabilities(GLWLoadFunc func, bool fast_paths) {
+    capabilities = {};
+    capabilities.major_version = get_integer(GL_MAJOR_VERSION);
+    capabilities.minor_version = get_integer(GL_MINOR_VERSION);
+    capabilities.vendor = get_string(GL_VENDOR);
+    capabilities.renderer = get_string(GL_RENDERER);
+    capabilities.version = get_string(GL_VERSION);
+    capabilities.extensions = get_extensions();
+
+    capabilities.max_texture_units = get_integer(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS);
+    capabilities.max_fragment_texture_units = get_integer(GL_MAX_TEXTURE_IMAGE_UNITS);
+    capabilities.max_texture_size = get_integer(GL_MAX_TEXTURE_SIZE);
+    capabilities.max_array_texture_layers = get_integer(GL_MAX_ARRAY_TEXTURE_LAYERS);
+    capabilities.max_uniform_block_size = get_size(GL_MAX_UNIFORM_BLOCK_SIZE);
+    capabilities.max_shader_storage_block_size = get_size(GL_MAX_SHADER_STORAGE_BLOCK_SIZE);
+    capabilities.uniform_buffer_offset_alignment = get_integer(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT);
+    capabilities.shader_storage_buffer_offset_alignment = get_integer(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT);
+    capabilities.max_vertex_attribs = get_integer(GL_MAX_VERTEX_ATTRIBS);
+    capabilities.max_draw_buffers = get_integer(GL_MAX_DRAW_BUFFERS);
+
+#define RESET_OPTIONAL_FUNCTION(TYPE, NAME) NAME = nullptr;
+FOR_OPTIONAL_OPENGL_FUNCTIONS(RESET_OPTIONAL_FUNCTION)
+#undef RESET_OPTIONAL_FUNCTION
+
+    if (!fast_paths) return;
+
+    // The ARB and KHR versions share their entry point and enums
+    if (capabilities.has_extension("GL_KHR_parallel_shader_compile")) {
+        capabilities.parallel_compile = load_optional(glMaxShaderCompilerThreadsKHR, "glMaxShaderCompilerThreadsKHR", func);
+    }
+    else if (capabilities.has_extension("GL_ARB_parallel_shader_compile")) {
+        capabilities.parallel_compile = load_optional(glMaxShaderCompilerThreadsKHR, "glMaxShaderCompilerThreadsARB", func);
+    }
+    if (capabilities.parallel_compile) {
+        // Let the driver pick as many threads as it likes
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        capabilities.max_compiler_threads = get_integer(GL_MAX_SHADER_COMPILER_THREADS_KHR);
+    }
+
+    if (capabilities.has_version(4, 3) || capabilities.has_extension("GL_ARB_multi_draw_indirect")) {
+        capabilities.multi_draw_indirect = load_optional(glMultiDrawElementsIndirect, "glMultiDrawElementsIndirect", func);
+    }
+
+    if (capabilities.has_extension("GL_ARB_bindless_texture")) {
+        capabilities.bindless_textures = load_optional(glGetTextureHandleARB, "glGetTextureHandleARB", func) &&
+                                         load_optional(glMakeTextureHandleResidentARB, "glMakeTextureHandleResidentARB", func);
+    }
+}
+
+const Capabilities& get_capabilities() {
+    return capabilities;
+}
+
+} // namespace glw
@@ -0,0 +1,317 @@
+#include "glw/cluster.hpp"
+#include "glw/glw.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GLW_CULLING_X86
+#include <immintrin.h>
+#endif
+
+#if defined(GLW_CULLING_X86) && !defined(_MSC_VER)
+#define GLW_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define GLW_TARGET_AVX2
+#endif
+
+namespace {
+
+using namespace glw;
+
+glm::vec3 load_position(const MeshSource& source, u32 vertex) {
+    glm::vec3 position;
+    std::memcpy(&position, source.vertices.data() + static_cast<size_t>(vertex) * source.stride + source.position_offset, sizeof(glm::vec3));
+    return position;
+}
+
+/*
+* Ritter's sphere seeded by the most distant pair of axis extremes
+*/
+void add_sphere(ClusterBounds& bounds, std::span<const glm::vec3> points) {
+    u32 min_points[3] = { 0, 0, 0 };
+    u32 max_points[3] = { 0, 0, 0 };
+    for (u32 i = 1; i < points.size(); ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            if (points[i][axis] < points[min_points[axis]][axis]) min_points[axis] = i;
+            if (points[i][axis] > points[max_points[axis]][axis]) max_points[axis] = i;
+        }
+    }
+
+    int seed_axis = 0;
+    f32 seed_distance = 0.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        f32 distance = glm::distance(points[min_points[axis]], points[max_points[axis]]);
+        if (distance > seed_distance) {
+            seed_axis = axis;
+            seed_distance = distance;
+        }
+    }
+
+    glm::vec3 center = (points[min_points[seed_axis]] + points[max_points[seed_axis]]) * 0.5f;
+    f32 radius = seed_distance * 0.5f;
+    for (const auto& point : points) {
+        f32 distance = glm::distance(point, center);
+        if (distance > radius) {
+            f32 grown_radius = (radius + distance) * 0.5f;
+            center += (point - center) * ((grown_radius - radius) / distance);
+            radius = grown_radius;
+        }
+    }
+
+    bounds.center_x.push_back(center.x);
+    bounds.center_y.push_back(center.y);
+    bounds.center_z.push_back(center.z);
+    bounds.radius.push_back(radius);
+}
+
+void add_cone(ClusterBounds& bounds, std::span<const glm::vec3> normals) {
+    glm::vec3 axis{ 0.0f };
+    for (const auto& normal : normals) axis += normal;
+
+    f32 axis_length = glm::length(axis);
+    f32 min_cos = axis_length > 0.0f ? 1.0f : -1.0f;
+    if (axis_length > 0.0f) {
+        axis /= axis_length;
+        for (const auto& normal : normals) min_cos = std::min(min_cos, glm::dot(normal, axis));
+    }
+
+    // Cutoff is sin of the cone half angle widened by 90 degrees for the view vector
+    if (min_cos <= 0.0f) {
+        axis = glm::vec3{ 0.0f };
+        min_cos = 0.0f;
+    }
+    bounds.cone_axis_x.push_back(axis.x);
+    bounds.cone_axis_y.push_back(axis.y);
+    bounds.cone_axis_z.push_back(axis.z);
+    bounds.cone_cutoff.push_back(std::sqrt(1.0f - min_cos * min_cos));
+}
+
+struct CullParams {
+    glm::vec4 planes[6];
+    glm::vec3 camera;
+};
+
+bool is_visible(const ClusterBounds& bounds, size_t i, const CullParams& params) {
+    f32 x = bounds.center_x[i], y = bounds.center_y[i], z = bounds.center_z[i], r = bounds.radius[i];
+    for (const auto& plane : params.planes) {
+        if (!is_sphere_inside(plane, x, y, z, r)) return false;
+    }
+
+    f32 dx = x - params.camera.x, dy = y - params.camera.y, dz = z - params.camera.z;
+    f32 distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    f32 facing = dx * bounds.cone_axis_x[i] + dy * bounds.cone_axis_y[i] + dz * bounds.cone_axis_z[i];
+    return facing < bounds.cone_cutoff[i] * distance + r;
+}
+
+u32 visible_mask_scalar(const ClusterBounds& bounds, size_t i, const CullParams& params) {
+    return is_visible(bounds, i, params) ? 1 : 0;
+}
+
+#ifdef GLW_CULLING_X86
+
+u32 visible_mask_sse2(const ClusterBounds& bounds, size_t i, const CullParams& params) {
+    __m128 x = _mm_loadu_ps(&bounds.center_x[i]);
+    __m128 y = _mm_loadu_ps(&bounds.center_y[i]);
+    __m128 z = _mm_loadu_ps(&bounds.center_z[i]);
+    __m128 r = _mm_loadu_ps(&bounds.radius[i]);
+    __m128 negative_r = _mm_sub_ps(_mm_setzero_ps(), r);
+
+    __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (const auto& plane : params.planes) {
+        __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+            _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+        visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negative_r));
+    }
+
+    __m128 dx = _mm_sub_ps(x, _mm_set1_ps(params.camera.x));
+    __m128 dy = _mm_sub_ps(y, _mm_set1_ps(params.camera.y));
+    __m128 dz = _mm_sub_ps(z, _mm_set1_ps(params.camera.z));
+    __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+    __m128 facing = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(&bounds.cone_axis_x[i])), _mm_mul_ps(dy, _mm_loadu_ps(&bounds.cone_axis_y[i]))),
+        _mm_mul_ps(dz, _mm_loadu_ps(&bounds.cone_axis_z[i])));
+    __m128 limit = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&bounds.cone_cutoff[i]), distance), r);
+    visible = _mm_and_ps(visible, _mm_cmplt_ps(facing, limit));
+
+    return static_cast<u32>(_mm_movemask_ps(visible));
+}
+
+GLW_TARGET_AVX2
+u32 visible_mask_avx2(const ClusterBounds& bounds, size_t i, const CullParams& params) {
+    __m256 x = _mm256_loadu_ps(&bounds.center_x[i]);
+    __m256 y = _mm256_loadu_ps(&bounds.center_y[i]);
+    __m256 z = _mm256_loadu_ps(&bounds.center_z[i]);
+    __m256 r = _mm256_loadu_ps(&bounds.radius[i]);
+    __m256 negative_r = _mm256_sub_ps(_mm256_setzero_ps(), r);
+
+    __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (const auto& plane : params.planes) {
+        __m256 distance = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(y, _mm256_set1_ps(plane.y))),
+            _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+        visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negative_r, _CMP_GE_OQ));
+    }
+
+    __m256 dx = _mm256_sub_ps(x, _mm256_set1_ps(params.camera.x));
+    __m256 dy = _mm256_sub_ps(y, _mm256_set1_ps(params.camera.y));
+    __m256 dz = _mm256_sub_ps(z, _mm256_set1_ps(params.camera.z));
+    __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+    __m256 facing = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(dx, _mm256_loadu_ps(&bounds.cone_axis_x[i])), _mm256_mul_ps(dy, _mm256_loadu_ps(&bounds.cone_axis_y[i]))),
+        _mm256_mul_ps(dz, _mm256_loadu_ps(&bounds.cone_axis_z[i])));
+    __m256 limit = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&bounds.cone_cutoff[i]), distance), r);
+    visible = _mm256_and_ps(visible, _mm256_cmp_ps(facing, limit, _CMP_LT_OQ));
+
+    return static_cast<u32>(_mm256_movemask_ps(visible));
+}
+
+#endif // GLW_CULLING_X86
+
+struct MaskKernel {
+    u32 (*visible_mask)(const ClusterBounds&, size_t, const CullParams&);
+    size_t width;
+};
+
+MaskKernel to_mask_kernel(SimdLevel level) {
+    switch (level) {
+    using enum SimdLevel;
+#ifdef GLW_CULLING_X86
+    case AVX2:   return { visible_mask_avx2, 8 };
+    case SSE2:   return { visible_mask_sse2, 4 };
+#else
+    case AVX2:
+    case SSE2:
+#endif
+    case Scalar: return { visible_mask_scalar, 1 };
+    }
+
+    throw cut::Exception("Unhandled SIMD level!");
+    return {};
+}
+
+} // namespace
+
+namespace glw {
+
+ClusterSet build_clusters(const MeshSource& source, const ClusterDescription& desc) {
+    cut::ensure(source.stride > 0 && source.vertices.size() % source.stride == 0, "Vertex data doesn't match the stride!");
+    cut::ensure(source.indices.size() % 3 == 0, "Only triangle lists can be clustered!");
+    cut::ensure(desc.max_vertices >= 3 && desc.max_triangles >= 1, "Cluster limits can't fit a triangle!");
+
+    u32 vertex_count = cut::to_u32(source.vertices.size() / source.stride);
+    ClusterSet clusters;
+
+    // Stamp of the last cluster referencing each vertex, avoids clearing a set per cluster
+    std::vector<u32> vertex_cluster(vertex_count, ~0u);
+    std::vector<glm::vec3> points;
+    std::vector<glm::vec3> normals;
+    u32 cluster = 0;
+    u32 first_index = 0;
+
+    auto finish_cluster = [&](u32 end_index) {
+        clusters.ranges.push_back({ first_index, end_index - first_index });
+        add_sphere(clusters.bounds, points);
+        add_cone(clusters.bounds, normals);
+        points.clear();
+        normals.clear();
+        first_index = end_index;
+        cluster++;
+    };
+
+    for (u32 i = 0; i < source.indices.size(); i += 3) {
+        const u32* tri = &source.indices[i];
+        cut::ensure(tri[0] < vertex_count && tri[1] < vertex_count && tri[2] < vertex_count, "Index out of range!");
+
+        u32 new_vertices = 0;
+        for (u32 k = 0; k < 3; ++k) {
+            if (vertex_cluster[tri[k]] != cluster && std::find(tri, tri + k, tri[k]) == tri + k) new_vertices++;
+        }
+        u32 triangle_count = (i - first_index) / 3;
+        if (triangle_count > 0 && (points.size() + new_vertices > desc.max_vertices || triangle_count + 1 > desc.max_triangles)) {
+            finish_cluster(i);
+        }
+
+        glm::vec3 p[3];
+        for (u32 k = 0; k < 3; ++k) {
+            p[k] = load_position(source, tri[k]);
+            if (vertex_cluster[tri[k]] != cluster) {
+                vertex_cluster[tri[k]] = cluster;
+                points.push_back(p[k]);
+            }
+        }
+
+        glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+        f32 length = glm::length(normal);
+        if (length > 0.0f) normals.push_back(normal / length);
+    }
+    if (first_index < source.indices.size()) finish_cluster(cut::to_u32(source.indices.size()));
+
+    return clusters;
+}
+
+void ClusterDrawList::add(const ClusterRange& range) {
+    if (!ranges_.empty() && ranges_.back().first_index + ranges_.back().index_count == range.first_index) {
+        ranges_.back().index_count += range.index_count;
+        return;
+    }
+    ranges_.push_back(range);
+}
+
+void ClusterDrawList::draw(const Mesh& mesh) {
+    if (ranges_.empty()) return;
+
+    mesh.bind();
+    u32 index_type = Mesh::to_gl_enum(mesh.get_index_type());
+    u32 index_size = Mesh::to_size(mesh.get_index_type());
+    if (ranges_.size() == 1) {
+        glDrawElements(GL_TRIANGLES, static_cast<s32>(ranges_[0].index_count), index_type,
+                       reinterpret_cast<const void*>(static_cast<size_t>(ranges_[0].first_index) * index_size));
+        return;
+    }
+
+    counts_.clear();
+    offsets_.clear();
+    for (const auto& range : ranges_) {
+        counts_.push_back(static_cast<s32>(range.index_count));
+        offsets_.push_back(reinterpret_cast<const void*>(static_cast<size_t>(range.first_index) * index_size));
+    }
+    glMultiDrawElements(GL_TRIANGLES, counts_.data(), index_type, offsets_.data(), static_cast<s32>(counts_.size()));
+}
+
+u32 cull_clusters(const ClusterSet& clusters, const Frustum& frustum, const glm::vec3& camera_position, ClusterDrawList& draw_list,
+                  SimdLevel level) {
+    auto [visible_mask, simd_width] = to_mask_kernel(level);
+
+    CullParams params;
+    std::copy(frustum.planes.begin(), frustum.planes.end(), params.planes);
+    params.camera = camera_position;
+
+    draw_list.clear();
+    u32 visible_count = 0;
+    size_t count = clusters.bounds.get_size();
+    size_t i = 0;
+    for (; i + simd_width <= count; i += simd_width) {
+        u32 mask = visible_mask(clusters.bounds, i, params);
+        while (mask) {
+            u32 lane = std::countr_zero(mask);
+            mask &= mask - 1;
+            draw_list.add(clusters.ranges[i + lane]);
+            visible_count++;
+        }
+    }
+    for (; i < count; ++i) {
+        if (!is_visible(clusters.bounds, i, params)) continue;
+
+        draw_list.add(clusters.ranges[i]);
+        visible_count++;
+    }
+    return visible_count;
+}
+
+} // namespace glw
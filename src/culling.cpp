@@ -0,0 +1,231 @@
+#include "glw/culling.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GLW_CULLING_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(GLW_CULLING_X86) && !defined(_MSC_VER)
+#define GLW_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define GLW_TARGET_AVX2
+#endif
+
+namespace {
+
+using namespace glw;
+
+constexpr size_t chunk_size = 16384;
+
+// Below this waking the workers costs more than the culling they would take over
+constexpr size_t min_parallel_spheres = 4 * chunk_size;
+
+/*
+* Appends indices of set bits, lanes past count are padding and dropped
+*/
+u32* write_visible(u32 mask, size_t first, size_t count, u32* out) {
+    if (first + BoundingSpheres::block_size > count) mask &= (1u << (count - first)) - 1;
+    while (mask) {
+        *out++ = static_cast<u32>(first + std::countr_zero(mask));
+        mask &= mask - 1;
+    }
+    return out;
+}
+
+u32* cull_scalar(const BoundingSpheres& spheres, size_t begin, size_t end, const Frustum& frustum, u32* out) {
+    const f32* x = spheres.get_x();
+    const f32* y = spheres.get_y();
+    const f32* z = spheres.get_z();
+    const f32* radius = spheres.get_radius();
+    for (size_t i = begin; i < end; i += BoundingSpheres::block_size) {
+        u32 mask = 0;
+        for (u32 lane = 0; lane < BoundingSpheres::block_size; ++lane) {
+            size_t j = i + lane;
+            bool visible = true;
+            for (const auto& plane : frustum.planes) {
+                visible &= is_sphere_inside(plane, x[j], y[j], z[j], radius[j]);
+            }
+            mask |= static_cast<u32>(visible) << lane;
+        }
+        out = write_visible(mask, i, spheres.get_size(), out);
+    }
+    return out;
+}
+
+#ifdef GLW_CULLING_X86
+
+u32* cull_sse2(const BoundingSpheres& spheres, size_t begin, size_t end, const Frustum& frustum, u32* out) {
+    __m128 planes[6][4];
+    for (u32 p = 0; p < 6; ++p) {
+        for (u32 c = 0; c < 4; ++c) planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+    }
+
+    for (size_t i = begin; i < end; i += BoundingSpheres::block_size) {
+        u32 mask = 0;
+        for (size_t half = 0; half < BoundingSpheres::block_size; half += 4) {
+            size_t j = i + half;
+            __m128 x = _mm_load_ps(spheres.get_x() + j);
+            __m128 y = _mm_load_ps(spheres.get_y() + j);
+            __m128 z = _mm_load_ps(spheres.get_z() + j);
+            __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(spheres.get_radius() + j));
+
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const auto& plane : planes) {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, plane[0]), _mm_mul_ps(y, plane[1])),
+                                             _mm_add_ps(_mm_mul_ps(z, plane[2]), plane[3]));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negative_radius));
+            }
+            mask |= static_cast<u32>(_mm_movemask_ps(visible)) << half;
+        }
+        out = write_visible(mask, i, spheres.get_size(), out);
+    }
+    return out;
+}
+
+GLW_TARGET_AVX2
+u32* cull_avx2(const BoundingSpheres& spheres, size_t begin, size_t end, const Frustum& frustum, u32* out) {
+    __m256 planes[6][4];
+    for (u32 p = 0; p < 6; ++p) {
+        for (u32 c = 0; c < 4; ++c) planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+    }
+
+    for (size_t i = begin; i < end; i += BoundingSpheres::block_size) {
+        __m256 x = _mm256_load_ps(spheres.get_x() + i);
+        __m256 y = _mm256_load_ps(spheres.get_y() + i);
+        __m256 z = _mm256_load_ps(spheres.get_z() + i);
+        __m256 negative_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_load_ps(spheres.get_radius() + i));
+
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto& plane : planes) {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, plane[0]), _mm256_mul_ps(y, plane[1])),
+                                            _mm256_add_ps(_mm256_mul_ps(z, plane[2]), plane[3]));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negative_radius, _CMP_GE_OQ));
+        }
+        out = write_visible(static_cast<u32>(_mm256_movemask_ps(visible)), i, spheres.get_size(), out);
+    }
+    return out;
+}
+
+bool is_avx2_supported() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    // OS has to save YMM registers, checked through OSXSAVE and XCR0
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // GLW_CULLING_X86
+
+using CullFunc = u32* (*)(const BoundingSpheres&, size_t, size_t, const Frustum&, u32*);
+
+CullFunc to_cull_func(SimdLevel level) {
+    switch (level) {
+    using enum SimdLevel;
+#ifdef GLW_CULLING_X86
+    case AVX2:   return cull_avx2;
+    case SSE2:   return cull_sse2;
+#else
+    case AVX2:
+    case SSE2:
+#endif
+    case Scalar: return cull_scalar;
+    }
+
+    throw cut::Exception("Unhandled SIMD level!");
+    return {};
+}
+
+} // namespace
+
+namespace glw {
+
+SimdLevel get_supported_simd_level() {
+#ifdef GLW_CULLING_X86
+    static const SimdLevel level = is_avx2_supported() ? SimdLevel::AVX2 : SimdLevel::SSE2;
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+u32 BoundingSpheres::add(const glm::vec3& center, f32 radius) {
+    if (size_ % block_size == 0) {
+        x_.resize(size_ + block_size, 0.0f);
+        y_.resize(size_ + block_size, 0.0f);
+        z_.resize(size_ + block_size, 0.0f);
+        radius_.resize(size_ + block_size, 0.0f);
+    }
+
+    u32 index = size_++;
+    set(index, center, radius);
+    return index;
+}
+
+void BoundingSpheres::set(u32 index, const glm::vec3& center, f32 radius) {
+    x_[index] = center.x;
+    y_[index] = center.y;
+    z_[index] = center.z;
+    radius_[index] = radius;
+}
+
+void BoundingSpheres::clear() {
+    x_.clear();
+    y_.clear();
+    z_.clear();
+    radius_.clear();
+    size_ = 0;
+}
+
+u32 cull_spheres(const BoundingSpheres& spheres, const Frustum& frustum, std::vector<u32>& visible, SimdLevel level) {
+    visible.resize(spheres.get_size());
+    u32* end = to_cull_func(level)(spheres, 0, spheres.get_size(), frustum, visible.data());
+    visible.resize(end - visible.data());
+    return cut::to_u32(visible.size());
+}
+
+u32 cull_spheres(const BoundingSpheres& spheres, const Frustum& frustum, std::vector<u32>& visible,
+                 ThreadPool& thread_pool, SimdLevel level) {
+    size_t count = spheres.get_size();
+    if (count < min_parallel_spheres || thread_pool.get_thread_count() == 1) return cull_spheres(spheres, frustum, visible, level);
+
+    CullFunc cull = to_cull_func(level);
+    size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+
+    // Chunks write in place at their own offset, then get packed together in order
+    visible.resize(count);
+    std::vector<u32> chunk_visible(chunk_count);
+    thread_pool.parallel_for(chunk_count, 1, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            size_t first = chunk * chunk_size;
+            u32* out = visible.data() + first;
+            chunk_visible[chunk] = cut::to_u32(cull(spheres, first, std::min(first + chunk_size, count), frustum, out) - out);
+        }
+    });
+
+    size_t visible_count = 0;
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        std::copy_n(visible.begin() + chunk * chunk_size, chunk_visible[chunk], visible.begin() + visible_count);
+        visible_count += chunk_visible[chunk];
+    }
+    visible.resize(visible_count);
+    return cut::to_u32(visible_count);
+}
+
+} // namespace glw
@@ -0,0 +1,305 @@
+#include "glw/debug_output.hpp"
+
+#include <cut/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <print>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+using namespace glw;
+using cut::u32;
+
+constexpr u32 ring_capacity = 256;
+constexpr u32 max_message_length = 512;
+constexpr u32 rate_limit_buckets = 1024;
+constexpr u32 max_messages_per_window = 8;
+constexpr auto rate_limit_window = std::chrono::seconds(1);
+constexpr auto flush_interval = std::chrono::milliseconds(10);
+
+const char* to_source_string(GLenum source) {
+    switch (source) {
+    case GL_DEBUG_SOURCE_API: return "OGL API Call";
+    case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "Window System API Call";
+    case GL_DEBUG_SOURCE_SHADER_COMPILER: return "Shader Compiler";
+    case GL_DEBUG_SOURCE_THIRD_PARTY: return "Third Party";
+    case GL_DEBUG_SOURCE_APPLICATION: return "This Application";
+    case GL_DEBUG_SOURCE_OTHER: return "Unknown";
+    }
+    return "";
+}
+
+const char* to_type_string(GLenum type) {
+    switch (type) {
+    case GL_DEBUG_TYPE_ERROR: return "Error";
+    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated behavior";
+    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "Undefined behavior";
+    case GL_DEBUG_TYPE_PORTABILITY: return "Portability";
+    case GL_DEBUG_TYPE_PERFORMANCE: return "Performance";
+    case GL_DEBUG_TYPE_MARKER: return "Command stream annotation";
+    case GL_DEBUG_TYPE_PUSH_GROUP:
+    case GL_DEBUG_TYPE_POP_GROUP: return "User defined";
+    case GL_DEBUG_TYPE_OTHER: return "Unknown";
+    }
+    return "";
+}
+
+const char* to_severity_string(GLenum severity) {
+    switch (severity) {
+    case GL_DEBUG_SEVERITY_HIGH: return "High";
+    case GL_DEBUG_SEVERITY_MEDIUM: return "Medium";
+    case GL_DEBUG_SEVERITY_LOW: return "Low";
+    case GL_DEBUG_SEVERITY_NOTIFICATION: return "Notification";
+    }
+    return "";
+}
+
+void write_message(GLenum source, GLenum type, GLuint id, GLenum severity, const char* message) {
+    std::println(std::cerr, "GLWDebug: {} - {} {} ({}):\n{}",
+                 to_source_string(source), to_type_string(type), to_severity_string(severity), id, message);
+}
+
+bool is_ignored(GLuint id) {
+    switch (id) {
+    case 131185: return true; // Buffer detailed info
+    }
+    return false;
+}
+
+struct Counters {
+    std::array<std::atomic<std::uint64_t>, 4> severities{};
+    std::atomic<std::uint64_t> suppressed = 0;
+    std::atomic<std::uint64_t> dropped = 0;
+
+    void count(GLenum severity) {
+        u32 index = 3;
+        switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH: index = 0; break;
+        case GL_DEBUG_SEVERITY_MEDIUM: index = 1; break;
+        case GL_DEBUG_SEVERITY_LOW: index = 2; break;
+        }
+        severities[index].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+struct DebugMessage {
+    GLenum source;
+    GLenum type;
+    GLenum severity;
+    GLuint id;
+    char text[max_message_length];
+};
+
+/*
+* Bounded multi producer single consumer queue, drivers may call back from several threads
+* Each slot's sequence says whose turn it is, producers only contend on the head
+*/
+class MessageRing final {
+public:
+    MessageRing() {
+        for (u32 i = 0; i < ring_capacity; ++i) slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message) {
+        std::uint64_t position = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[position % ring_capacity];
+            auto difference = static_cast<std::int64_t>(slot.sequence.load(std::memory_order_acquire) - position);
+            if (difference < 0) return false;
+            if (difference > 0) {
+                position = head_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                DebugMessage& out = slot.message;
+                out.source = source;
+                out.type = type;
+                out.id = id;
+                out.severity = severity;
+                size_t size = length >= 0 ? static_cast<size_t>(length) : std::strlen(message);
+                size = std::min<size_t>(size, max_message_length - 1);
+                std::memcpy(out.text, message, size);
+                out.text[size] = '\0';
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    bool pop(DebugMessage& message) {
+        Slot& slot = slots_[tail_ % ring_capacity];
+        if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1) return false;
+        message = slot.message;
+        slot.sequence.store(tail_ + ring_capacity, std::memory_order_release);
+        tail_++;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> sequence;
+        DebugMessage message;
+    };
+
+    std::array<Slot, ring_capacity> slots_;
+    alignas(64) std::atomic<std::uint64_t> head_ = 0;
+    alignas(64) std::uint64_t tail_ = 0;
+};
+
+/*
+* Repeats of an id are written once per window with a count, past a small budget the
+* callback doesn't even queue them
+*/
+class AsyncSink final {
+public:
+    ~AsyncSink() { stop(); }
+
+    void start() {
+        if (thread_.joinable()) return;
+        thread_ = std::jthread([this](std::stop_token stop_token) {
+            while (!stop_token.stop_requested()) {
+                std::this_thread::sleep_for(flush_interval);
+                flush(false);
+            }
+            flush(true);
+        });
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        thread_.request_stop();
+        thread_.join();
+    }
+
+    void push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message) {
+        if (budgets_[id % rate_limit_buckets].fetch_add(1, std::memory_order_relaxed) >= max_messages_per_window) {
+            counters.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (!ring_.push(source, type, id, severity, length, message)) {
+            counters.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void flush(bool end_window) {
+        std::lock_guard lock{ mutex_ };
+
+        DebugMessage message;
+        while (ring_.pop(message)) {
+            auto [it, inserted] = repeats_.try_emplace(message.id, 0);
+            if (inserted) write_message(message.source, message.type, message.id, message.severity, message.text);
+            else it->second++;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!end_window && now - window_start_ < rate_limit_window) return;
+        window_start_ = now;
+
+        for (auto& [id, repeats] : repeats_) {
+            u32 queued = budgets_[id % rate_limit_buckets].exchange(0, std::memory_order_relaxed);
+            repeats += queued > max_messages_per_window ? queued - max_messages_per_window : 0;
+            if (repeats > 0) std::println(std::cerr, "GLWDebug: ({}) repeated {} more times", id, repeats);
+        }
+        for (auto& budget : budgets_) budget.store(0, std::memory_order_relaxed);
+        repeats_.clear();
+    }
+
+    Counters counters;
+
+private:
+    MessageRing ring_;
+    std::array<std::atomic<u32>, rate_limit_buckets> budgets_{};
+
+    // Only touched by whoever holds the mutex, never by the callback
+    std::mutex mutex_;
+    std::unordered_map<GLuint, u32> repeats_;
+    std::chrono::steady_clock::time_point window_start_ = std::chrono::steady_clock::now();
+
+    std::jthread thread_;
+};
+
+AsyncSink sink;
+DebugOutput current_output = DebugOutput::Off;
+
+void APIENTRY synchronous_callback(GLenum source,
+                                   GLenum type,
+                                   GLuint id,
+                                   GLenum severity,
+                                   GLsizei /*length*/,
+                                   const GLchar* message,
+                                   const void* /*user_param*/) {
+    if (is_ignored(id)) return;
+    sink.counters.count(severity);
+    write_message(source, type, id, severity, message);
+}
+
+void APIENTRY async_callback(GLenum source,
+                             GLenum type,
+                             GLuint id,
+                             GLenum severity,
+                             GLsizei length,
+                             const GLchar* message,
+                             const void* /*user_param*/) {
+    if (is_ignored(id)) return;
+    sink.counters.count(severity);
+    sink.push(source, type, id, severity, length, message);
+}
+
+} // namespace
+
+namespace glw {
+
+void set_debug_output(DebugOutput output) {
+    switch (output) {
+    using enum DebugOutput;
+    case Off:
+        glDisable(GL_DEBUG_OUTPUT);
+        glDebugMessageCallback(nullptr, nullptr);
+        break;
+    case Async:
+        sink.start();
+        glEnable(GL_DEBUG_OUTPUT);
+        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(async_callback, nullptr);
+        break;
+    case Synchronous:
+        glEnable(GL_DEBUG_OUTPUT);
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(synchronous_callback, nullptr);
+        break;
+    }
+
+    // Messages already queued still get written
+    if (output != DebugOutput::Async) sink.stop();
+    current_output = output;
+}
+
+DebugOutput get_debug_output() {
+    return current_output;
+}
+
+DebugMessageCounts get_debug_message_counts() {
+    const Counters& counters = sink.counters;
+    return {
+        counters.severities[0].load(std::memory_order_relaxed),
+        counters.severities[1].load(std::memory_order_relaxed),
+        counters.severities[2].load(std::memory_order_relaxed),
+        counters.severities[3].load(std::memory_order_relaxed),
+        counters.suppressed.load(std::memory_order_relaxed),
+        counters.dropped.load(std::memory_order_relaxed)
+    };
+}
+
+void flush_debug_output() {
+    sink.flush(true);
+}
+
+} // namespace glw
@@ -0,0 +1,99 @@
+#include "glw/draw_data_buffer.hpp"
+#include "glw/capabilities.hpp"
+#include "glw/glw.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+using namespace glw;
+
+/*
+* Runs before any member is built, so a bad description never allocates
+*/
+const DrawDataDescription& validate(const DrawDataDescription& desc) {
+    cut::ensure(desc.struct_size > 0 && desc.struct_size % 4 == 0, "Draw data size has to be a non zero multiple of 4!");
+    cut::ensure(desc.max_draws > 0, "Draw data needs at least one draw!");
+    cut::ensure(desc.frames_in_flight > 0, "Draw data needs at least one frame in flight!");
+
+    if (desc.binding == BufferBinding::Uniform) {
+        // std140 rounds array strides up to 16, anything else would be read at another stride than pushed
+        cut::ensure(desc.struct_size % 16 == 0, "Uniform draw data size has to be a multiple of 16!");
+        u32 max_block_size = get_capabilities().max_uniform_block_size;
+        cut::ensure(static_cast<size_t>(desc.struct_size) * desc.max_draws <= max_block_size,
+                    "Draw data exceeds max uniform block size {}!", max_block_size);
+    }
+    return desc;
+}
+
+/*
+* Region size rounded up to the binding offset alignment so every region can be bound
+*/
+size_t to_region_size(const DrawDataDescription& desc) {
+    const auto& capabilities = get_capabilities();
+    size_t alignment = std::max(desc.binding == BufferBinding::Uniform ? capabilities.uniform_buffer_offset_alignment
+                                                                       : capabilities.shader_storage_buffer_offset_alignment, 1u);
+    size_t size = static_cast<size_t>(desc.struct_size) * desc.max_draws;
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+namespace glw {
+
+DrawDataBuffer::DrawDataBuffer(const DrawDataDescription& desc) :
+    desc_{ validate(desc) },
+    region_size_{ to_region_size(desc) },
+    buffer_{ region_size_ * desc.frames_in_flight, BufferUsage::PersistentWrite },
+    fences_(desc.frames_in_flight) {}
+
+void DrawDataBuffer::begin_frame() {
+    region_ = (region_ + 1) % desc_.frames_in_flight;
+    draw_count_ = 0;
+
+    auto& fence = fences_[region_];
+    if (fence) {
+        fence->wait();
+        fence.reset();
+    }
+
+    buffer_.bind_range(desc_.binding, desc_.binding_index, region_ * region_size_, region_size_);
+}
+
+u32 DrawDataBuffer::push(std::span<const std::byte> data) {
+    cut::ensure(data.size() <= desc_.struct_size, "Draw data larger than struct size!");
+    cut::ensure(draw_count_ < desc_.max_draws, "Too many draws in a frame!");
+
+    std::byte* destination = buffer_.get_mapping().data() + region_ * region_size_ + static_cast<size_t>(draw_count_) * desc_.struct_size;
+    std::memcpy(destination, data.data(), data.size());
+    return draw_count_++;
+}
+
+void DrawDataBuffer::end_frame() {
+    fences_[region_].emplace();
+}
+
+void DrawDataBuffer::draw(const Mesh& mesh, u32 draw_index) {
+    draw(mesh, mesh.get_lods().front(), draw_index);
+}
+
+void DrawDataBuffer::draw(const Mesh& mesh, const LodLevel& lod, u32 draw_index) {
+    auto offset = static_cast<size_t>(lod.first_index) * Mesh::to_size(mesh.get_index_type());
+    mesh.bind();
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, static_cast<GLsizei>(lod.index_count),
+                                        Mesh::to_gl_enum(mesh.get_index_type()), reinterpret_cast<const void*>(offset), 1, draw_index);
+}
+
+void DrawDataBuffer::draw(const Shader& shader, const Mesh& mesh, u32 draw_index) {
+    draw(shader, mesh, mesh.get_lods().front(), draw_index);
+}
+
+void DrawDataBuffer::draw(const Shader& shader, const Mesh& mesh, const LodLevel& lod, u32 draw_index) {
+    shader.set_uniform_1i("glw_draw_index", static_cast<s32>(draw_index));
+    draw(mesh, lod, draw_index);
+}
+
+} // namespace glw
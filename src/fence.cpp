@@ -0,0 +1,28 @@
+#include "glw/fence.hpp"
+#include "glw/glw.hpp"
+
+#include <cut/exception.hpp>
+
+namespace glw {
+
+Fence::Fence() :
+    handle_(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+            [](void* handle) { glDeleteSync(static_cast<GLsync>(handle)); })
+{}
+
+bool Fence::is_signaled() const {
+    GLenum result = glClientWaitSync(static_cast<GLsync>(handle_.get()), GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    cut::ensure(result != GL_WAIT_FAILED, "Failed to query fence status!");
+    return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void Fence::wait() const {
+    constexpr GLuint64 timeout_ns = 1'000'000'000;
+    GLenum result;
+    do {
+        result = glClientWaitSync(static_cast<GLsync>(handle_.get()), GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+        cut::ensure(result != GL_WAIT_FAILED, "Failed to wait for fence!");
+    } while (result == GL_TIMEOUT_EXPIRED);
+}
+
+} // namespace glw
@@ -0,0 +1,30 @@
+#include "glw/frustum.hpp"
+
+namespace glw {
+
+Frustum::Frustum(const glm::mat4& view_projection) {
+    auto row = [&view_projection](int i) {
+        return glm::vec4{ view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i] };
+    };
+
+    planes = {
+        row(3) + row(0),
+        row(3) - row(0),
+        row(3) + row(1),
+        row(3) - row(1),
+        row(3) + row(2),
+        row(3) - row(2)
+    };
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3{ plane.x, plane.y, plane.z });
+    }
+}
+
+bool Frustum::intersects_sphere(const glm::vec3& center, f32 radius) const {
+    for (const auto& plane : planes) {
+        if (!is_sphere_inside(plane, center.x, center.y, center.z, radius)) return false;
+    }
+    return true;
+}
+
+} // namespace glw
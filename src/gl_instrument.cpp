@@ -0,0 +1,270 @@
+#include "glw/gl_instrument.hpp"
+#include "glw/gl_trace.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <numeric>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GLW_INSTRUMENT_RDTSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace {
+
+using namespace glw;
+
+const char* const function_names[] = {
+#define GL_FUNCTION_NAME(TYPE, NAME) #NAME,
+FOR_ALL_OPENGL_FUNCTIONS(GL_FUNCTION_NAME)
+#undef GL_FUNCTION_NAME
+};
+
+GLInstrumentMode mode = GLInstrumentMode::Off;
+GLFrameStats current_frame;
+GLFrameStats last_frame;
+
+// Call times are kept in ticks and converted once per frame against the steady clock
+std::uint64_t frame_start_ticks = 0;
+std::chrono::steady_clock::time_point frame_start_time;
+
+std::uint64_t read_ticks() {
+#ifdef GLW_INSTRUMENT_RDTSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void restart_frame_clock() {
+    frame_start_ticks = read_ticks();
+    frame_start_time = std::chrono::steady_clock::now();
+}
+
+u32 to_component_count(GLenum format) {
+    switch (format) {
+    case GL_RED:
+    case GL_RED_INTEGER:
+    case GL_DEPTH_COMPONENT:
+    case GL_STENCIL_INDEX:  return 1;
+    case GL_RG:
+    case GL_RG_INTEGER:
+    case GL_DEPTH_STENCIL:  return 2;
+    case GL_RGB:
+    case GL_BGR:
+    case GL_RGB_INTEGER:    return 3;
+    case GL_RGBA:
+    case GL_BGRA:
+    case GL_RGBA_INTEGER:   return 4;
+    }
+    return 0;
+}
+
+#if GLW_INSTRUMENT_GL
+
+/*
+* Bytes uploaded by a call, only defined for the entry points that take data
+*/
+template<GLFunction Function>
+struct UploadSize {};
+
+template<>
+struct UploadSize<GLFunction::glNamedBufferSubData> {
+    static std::uint64_t get(GLuint, GLintptr, GLsizeiptr size, const void*) { return static_cast<std::uint64_t>(size); }
+};
+
+template<>
+struct UploadSize<GLFunction::glNamedBufferStorage> {
+    static std::uint64_t get(GLuint, GLsizeiptr size, const void* data, GLbitfield) {
+        return data ? static_cast<std::uint64_t>(size) : 0;
+    }
+};
+
+template<>
+struct UploadSize<GLFunction::glTextureSubImage2D> {
+    static std::uint64_t get(GLuint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void*) {
+        return static_cast<std::uint64_t>(width) * height * to_gl_pixel_size(format, type);
+    }
+};
+
+template<>
+struct UploadSize<GLFunction::glTextureSubImage3D> {
+    static std::uint64_t get(GLuint, GLint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth,
+                             GLenum format, GLenum type, const void*) {
+        return static_cast<std::uint64_t>(width) * height * depth * to_gl_pixel_size(format, type);
+    }
+};
+
+struct CallTimer {
+    GLCallStats& stats;
+    std::uint64_t start = read_ticks();
+
+    ~CallTimer() { stats.time_ns += read_ticks() - start; }
+};
+
+/*
+* One thunk per entry point, keeps the loaded pointer and counts into the current frame
+*/
+template<GLFunction Function, typename T>
+struct Thunk;
+
+template<GLFunction Function, typename R, typename... Args>
+struct Thunk<Function, R (APIENTRY*)(Args...)> {
+    static inline R (APIENTRY* real)(Args...) = nullptr;
+
+    static R APIENTRY call(Args... args) {
+        GLCallStats& stats = current_frame.functions[static_cast<u32>(Function)];
+        stats.calls++;
+        if constexpr (requires { UploadSize<Function>::get(args...); }) {
+            stats.upload_bytes += UploadSize<Function>::get(args...);
+        }
+
+        if (mode != GLInstrumentMode::CountAndTime) return real(args...);
+        CallTimer timer{ stats };
+        return real(args...);
+    }
+};
+
+#define GL_THUNK(TYPE, NAME) Thunk<GLFunction::NAME, TYPE>
+
+// Optional entry points the context lacks stay nullptr
+void install_thunks() {
+#define INSTALL_GL_THUNK(TYPE, NAME) GL_THUNK(TYPE, NAME)::real = NAME; if (NAME) NAME = GL_THUNK(TYPE, NAME)::call;
+FOR_ALL_OPENGL_FUNCTIONS(INSTALL_GL_THUNK)
+#undef INSTALL_GL_THUNK
+}
+
+void remove_thunks() {
+#define REMOVE_GL_THUNK(TYPE, NAME) NAME = GL_THUNK(TYPE, NAME)::real;
+FOR_ALL_OPENGL_FUNCTIONS(REMOVE_GL_THUNK)
+#undef REMOVE_GL_THUNK
+}
+
+#undef GL_THUNK
+
+#endif // GLW_INSTRUMENT_GL
+
+/*
+* Functions that were called this frame, busiest first
+*/
+std::vector<u32> to_called_functions(const GLFrameStats& stats) {
+    std::vector<u32> order(gl_function_count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::erase_if(order, [&](u32 i) { return stats.functions[i].calls == 0; });
+    std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+        const auto& fa = stats.functions[a];
+        const auto& fb = stats.functions[b];
+        return fa.time_ns != fb.time_ns ? fa.time_ns > fb.time_ns : fa.calls > fb.calls;
+    });
+    return order;
+}
+
+} // namespace
+
+namespace glw {
+
+u32 to_gl_pixel_size(GLenum format, GLenum type) {
+    switch (type) {
+    case GL_UNSIGNED_BYTE:
+    case GL_BYTE:           return to_component_count(format);
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+    case GL_HALF_FLOAT:     return to_component_count(format) * 2;
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+    case GL_FLOAT:          return to_component_count(format) * 4;
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1: return 2;
+    case GL_UNSIGNED_INT_24_8:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+    case GL_UNSIGNED_INT_5_9_9_9_REV:
+    case GL_UNSIGNED_INT_8_8_8_8:
+    case GL_UNSIGNED_INT_8_8_8_8_REV: return 4;
+    }
+    return 0;
+}
+
+const char* get_gl_function_name(GLFunction function) {
+    cut::ensure(function < GLFunction::Count, "Invalid GL function!");
+    return function_names[static_cast<u32>(function)];
+}
+
+void set_gl_instrument_mode(GLInstrumentMode new_mode) {
+#if GLW_INSTRUMENT_GL
+    if (new_mode == mode) return;
+    // Swapping pointers under the capture thunks would unhook one of the two
+    cut::ensure(!is_gl_capture_active(), "GL instrument mode can't change while a GLCapture runs!");
+
+    if (mode == GLInstrumentMode::Off && new_mode != GLInstrumentMode::Off) {
+        install_thunks();
+        restart_frame_clock();
+    }
+    if (mode != GLInstrumentMode::Off && new_mode == GLInstrumentMode::Off) remove_thunks();
+    mode = new_mode;
+#else
+    cut::ensure(new_mode == GLInstrumentMode::Off, "glw was built without GLW_INSTRUMENT_GL!");
+#endif
+}
+
+GLInstrumentMode get_gl_instrument_mode() {
+    return mode;
+}
+
+void end_gl_stats_frame() {
+    std::uint64_t ticks = read_ticks() - frame_start_ticks;
+    double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - frame_start_time).count();
+    double ns_per_tick = ticks > 0 ? nanoseconds / ticks : 0.0;
+    restart_frame_clock();
+
+    GLCallStats total;
+    for (auto& function : current_frame.functions) {
+        function.time_ns = static_cast<std::uint64_t>(function.time_ns * ns_per_tick);
+        total.calls += function.calls;
+        total.time_ns += function.time_ns;
+        total.upload_bytes += function.upload_bytes;
+    }
+    current_frame.total = total;
+
+    last_frame = current_frame;
+    current_frame = {};
+    current_frame.frame = last_frame.frame + 1;
+}
+
+const GLFrameStats& get_gl_frame_stats() {
+    return last_frame;
+}
+
+void write_gl_stats_text(std::ostream& stream, const GLFrameStats& stats) {
+    stream << std::format("GL frame {}: {} calls, {:.3f} ms, {} bytes uploaded\n",
+                          stats.frame, stats.total.calls, stats.total.time_ns / 1e6, stats.total.upload_bytes);
+    for (u32 i : to_called_functions(stats)) {
+        const auto& function = stats.functions[i];
+        stream << std::format("  {:<40} {:>8} calls {:>10.3f} ms {:>12} bytes\n",
+                              function_names[i], function.calls, function.time_ns / 1e6, function.upload_bytes);
+    }
+}
+
+void write_gl_stats_json(std::ostream& stream, const GLFrameStats& stats) {
+    stream << std::format("{{\"frame\":{},\"calls\":{},\"time_ns\":{},\"upload_bytes\":{},\"functions\":[",
+                          stats.frame, stats.total.calls, stats.total.time_ns, stats.total.upload_bytes);
+    const char* separator = "";
+    for (u32 i : to_called_functions(stats)) {
+        const auto& function = stats.functions[i];
+        stream << std::format("{}\n{{\"name\":\"{}\",\"calls\":{},\"time_ns\":{},\"upload_bytes\":{}}}",
+                              separator, function_names[i], function.calls, function.time_ns, function.upload_bytes);
+        separator = ",";
+    }
+    stream << "\n]}\n";
+}
+
+} // namespace glw
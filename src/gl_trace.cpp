@@ -0,0 +1,1223 @@
+#include "glw/gl_trace.hpp"
+#include "glw/mapped_file.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace glw;
+using cut::u8;
+using cut::u16;
+
+/*
+* Trace layout: magic, version and the names of the captured entry points, then records until the end of the file
+* A record starts with a u16 tag, an index into the captured names or one of the tags below
+* Frames are written as their blobs, mapping writes and calls, so payloads always precede their first use
+* Blobs are referenced by hash and size together
+*/
+constexpr char trace_magic[4] = { 'G', 'L', 'W', 'T' };
+constexpr u32 trace_version = 2;
+
+constexpr u16 blob_tag = 0xFFF0;          // u64 hash, u64 size, bytes
+constexpr u16 mapping_write_tag = 0xFFF1; // u32 buffer, u64 offset, u64 blob hash, u64 blob size
+constexpr u16 frame_end_tag = 0xFFF2;
+
+constexpr size_t mapping_page_size = 64 * 1024;
+constexpr size_t output_size = 64 * 1024;
+
+/*
+* Calls that can read buffer memory. Mapping writes are snapshotted once per frame, replay holds them back
+* until the first of these so the fence waits ahead of it have returned, as they had when the frame was
+* captured. Waits between two such calls of one frame still see every write of the frame applied
+*/
+constexpr std::array<std::string_view, 7> mapping_reader_prefixes = {
+    "glDraw", "glMultiDraw", "glDispatch", "glCopy", "glFenceSync", "glTextureSubImage", "glGetNamedBufferSubData"
+};
+
+bool reads_mappings(std::string_view name) {
+    return std::ranges::any_of(mapping_reader_prefixes, [&](std::string_view prefix) { return name.starts_with(prefix); });
+}
+
+/*
+* How each argument is stored, one character per argument, optionally '>' and the kind of the result
+*   .  value as is                   o  pointer used as offset into a bound buffer
+*   c  zero terminated string        g  output, replayed into scratch memory
+*   y  sync object                   h  bindless texture handle
+*   b t f v p s m q  buffer, texture, framebuffer, vertex array, program, shader, sampler and query names
+*   *  entry point has its own Codec
+*/
+constexpr std::string_view to_signature(GLFunction function) {
+    switch (function) {
+    using enum GLFunction;
+    case glAttachShader:                      return "ps";
+    case glBeginConditionalRender:            return "q.";
+    case glBeginQuery:                        return ".q";
+    case glBindBuffer:                        return ".b";
+    case glBindBufferBase:                    return "..b";
+    case glBindBufferRange:                   return "..b..";
+    case glBindFramebuffer:                   return ".f";
+    case glBindSampler:                       return ".m";
+    case glBindTextureUnit:                   return ".t";
+    case glBindVertexArray:                   return "v";
+    case glBlendFunc:                         return "..";
+    case glBlendFuncSeparate:                 return "....";
+    case glBlitNamedFramebuffer:              return "ff..........";
+    case glCheckNamedFramebufferStatus:       return "f.";
+    case glClear:                             return ".";
+    case glClearColor:                        return "....";
+    case glClearNamedFramebufferfv:           return "*";
+    case glClearNamedFramebufferiv:           return "*";
+    case glClearTexImage:                     return "*";
+    case glClientWaitSync:                    return "y..";
+    case glColorMask:                         return "....";
+    case glCompileShader:                     return "s";
+    case glCopyImageSubData:                  return "t.....t........";
+    case glCreateBuffers:                     return "*";
+    case glCreateFramebuffers:                return "*";
+    case glCreateProgram:                     return ">p";
+    case glCreateQueries:                     return "*";
+    case glCreateSamplers:                    return "*";
+    case glCreateShader:                      return ".>s";
+    case glCreateTextures:                    return "*";
+    case glCreateVertexArrays:                return "*";
+    case glDebugMessageCallback:              return "*";
+    case glDepthFunc:                         return ".";
+    case glDepthMask:                         return ".";
+    case glDeleteBuffers:                     return "*";
+    case glDeleteFramebuffers:                return "*";
+    case glDeleteProgram:                     return "p";
+    case glDeleteQueries:                     return "*";
+    case glDeleteSamplers:                    return "*";
+    case glDeleteShader:                      return "s";
+    case glDeleteSync:                        return "y";
+    case glDeleteTextures:                    return "*";
+    case glDeleteVertexArrays:                return "*";
+    case glDetachShader:                      return "ps";
+    case glDisable:                           return ".";
+    case glDrawArrays:                        return "...";
+    case glDrawElements:                      return "...o";
+    case glDrawElementsBaseVertex:            return "...o.";
+    case glDrawElementsInstancedBaseInstance: return "...o..";
+    case glEnable:                            return ".";
+    case glEnableVertexArrayAttrib:           return "v.";
+    case glEndConditionalRender:              return "";
+    case glEndQuery:                          return ".";
+    case glFenceSync:                         return "..>y";
+    case glGenerateTextureMipmap:             return "t";
+    case glGetActiveUniform:                  return "p..gggg";
+    case glGetFloatv:                         return ".g";
+    case glGetInteger64v:                     return ".g";
+    case glGetIntegerv:                       return ".g";
+    case glGetNamedBufferSubData:             return "*";
+    case glGetProgramInfoLog:                 return "p.gg";
+    case glGetProgramiv:                      return "p.g";
+    case glGetQueryObjectui64v:               return "q.g";
+    case glGetShaderInfoLog:                  return "s.gg";
+    case glGetShaderiv:                       return "s.g";
+    case glGetString:                         return ".>.";
+    case glGetStringi:                        return "..>.";
+    case glGetTextureHandleARB:               return "t>h";
+    case glGetTextureImage:                   return "*";
+    case glGetUniformLocation:                return "pc>.";
+    case glIsEnabled:                         return ".>.";
+    case glLineWidth:                         return ".";
+    case glLinkProgram:                       return "p";
+    case glMakeTextureHandleResidentARB:      return "h";
+    case glMapNamedBufferRange:               return "*";
+    case glMaxShaderCompilerThreadsKHR:       return ".";
+    case glMultiDrawElements:                 return "*";
+    case glMultiDrawElementsBaseVertex:       return "*";
+    case glMultiDrawElementsIndirect:         return "..o..";
+    case glNamedBufferSubData:                return "*";
+    case glNamedBufferStorage:                return "*";
+    case glNamedFramebufferDrawBuffers:       return "*";
+    case glNamedFramebufferTexture:           return "f.t.";
+    case glPixelStorei:                       return "..";
+    case glProgramUniform1f:                  return "p..";
+    case glProgramUniform1i:                  return "p..";
+    case glProgramUniform3f:                  return "p....";
+    case glProgramUniform3fv:                 return "*";
+    case glProgramUniformMatrix3fv:           return "*";
+    case glProgramUniformMatrix4fv:           return "*";
+    case glQueryCounter:                      return "q.";
+    case glSamplerParameterf:                 return "m..";
+    case glSamplerParameteri:                 return "m..";
+    case glShaderSource:                      return "*";
+    case glTextureStorage2D:                  return "t....";
+    case glTextureStorage3D:                  return "t.....";
+    case glTextureSubImage2D:                 return "*";
+    case glTextureSubImage3D:                 return "*";
+    case glUseProgram:                        return "p";
+    case glVertexArrayAttribBinding:          return "v..";
+    case glVertexArrayAttribFormat:           return "v.....";
+    case glVertexArrayAttribIFormat:          return "v....";
+    case glVertexArrayElementBuffer:          return "vb";
+    case glVertexArrayVertexBuffer:           return "v.b..";
+    case glViewport:                          return "....";
+    case Count:                               break;
+    }
+    return {};
+}
+
+constexpr std::string_view name_kinds = "btfvpsmq";
+
+constexpr bool is_name_kind(char kind) {
+    return name_kinds.find(kind) != std::string_view::npos;
+}
+
+/*
+* Multiply-rotate over 8 byte words, the size is mixed in so only equal sized payloads can collide
+*/
+std::uint64_t hash_bytes(std::span<const std::byte> bytes) {
+    std::uint64_t hash = 0x9E3779B97F4A7C15ull ^ bytes.size();
+    size_t i = 0;
+    for (; i + 8 <= bytes.size(); i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, bytes.data() + i, sizeof(word));
+        hash = std::rotl((hash ^ word) * 0xBF58476D1CE4E5B9ull, 31);
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+    hash = (hash ^ tail) * 0x94D049BB133111EBull;
+    return hash ^ (hash >> 29);
+}
+
+/*
+* Size is part of the key, so payloads of different sizes never alias even if their hashes collide
+*/
+struct BlobKey {
+    std::uint64_t hash;
+    std::uint64_t size;
+
+    bool operator==(const BlobKey&) const = default;
+};
+
+struct BlobKeyHash {
+    size_t operator()(const BlobKey& key) const { return static_cast<size_t>(key.hash ^ std::rotl(key.size, 32)); }
+};
+
+template<typename T>
+void append(std::vector<std::byte>& bytes, const T& value) {
+    auto value_bytes = std::as_bytes(std::span{ &value, 1 });
+    bytes.insert(bytes.end(), value_bytes.begin(), value_bytes.end());
+}
+
+std::uint64_t to_pointer_value(const void* pointer) {
+    return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(pointer));
+}
+
+template<typename T>
+T to_pointer(std::uint64_t value) {
+    return reinterpret_cast<T>(static_cast<std::uintptr_t>(value));
+}
+
+} // namespace
+
+namespace glw {
+
+class GLTraceWriter final :
+    cut::NonCopyable {
+public:
+    explicit GLTraceWriter(const std::filesystem::path& path);
+
+    template<typename T>
+    void write(const T& value) { append(calls_, value); }
+    void write_bytes(std::span<const std::byte> bytes) { calls_.insert(calls_.end(), bytes.begin(), bytes.end()); }
+    void write_string(const char* string);
+    void write_blob(std::span<const std::byte> bytes) { write(add_blob(bytes)); }
+
+    void begin_call(GLFunction function) { write(static_cast<u16>(function)); }
+    void add_mapping(GLuint buffer, void* data, size_t size);
+    void remove_mapping(GLuint buffer) { mappings_.erase(buffer); }
+    void end_frame();
+    void finish();
+
+    u32 get_frame_count() const { return frame_count_; }
+    std::uint64_t get_blob_bytes() const { return blob_bytes_; }
+
+    // Client pixel state needed to size and locate texture data
+    GLuint unpack_buffer = 0;
+    GLuint pack_buffer = 0;
+    GLint unpack_alignment = 4;
+    GLint unpack_row_length = 0;
+    GLint unpack_image_height = 0;
+private:
+    struct Mapping {
+        std::byte* data = nullptr;
+        size_t size = 0;
+        std::vector<std::uint64_t> page_hashes;
+    };
+
+    BlobKey add_blob(std::span<const std::byte> bytes);
+    void write_mapping_changes(GLuint buffer, Mapping& mapping);
+
+    std::ofstream file_;
+    std::vector<std::byte> blobs_;
+    std::vector<std::byte> mapping_writes_;
+    std::vector<std::byte> calls_;
+    std::unordered_set<BlobKey, BlobKeyHash> written_blobs_;
+    std::unordered_map<GLuint, Mapping> mappings_;
+    u32 frame_count_ = 0;
+    std::uint64_t blob_bytes_ = 0;
+};
+
+class GLTraceReader final :
+    cut::NonCopyable {
+public:
+    explicit GLTraceReader(const std::filesystem::path& path);
+
+    template<typename T>
+    T read() {
+        T value;
+        std::memcpy(&value, read_bytes(sizeof(T)).data(), sizeof(T));
+        return value;
+    }
+
+    std::span<const std::byte> read_bytes(size_t size);
+    const char* read_string();
+    std::span<const std::byte> read_blob();
+
+    /*
+    * Scratch memory for outputs and aligned copies of arrays, one slot per argument so they never overlap
+    */
+    std::byte* get_output(u32 slot, size_t size);
+
+    template<typename T>
+    const T* read_array(u32 slot, size_t count) {
+        std::byte* data = get_output(slot, count * sizeof(T));
+        std::memcpy(data, read_bytes(count * sizeof(T)).data(), count * sizeof(T));
+        return reinterpret_cast<const T*>(data);
+    }
+
+    GLuint to_name(char kind, GLuint captured) const;
+    void add_name(char kind, GLuint captured, GLuint name);
+    GLsync to_sync(std::uint64_t captured) const;
+    void add_sync(std::uint64_t captured, GLsync sync) { syncs_[captured] = sync; }
+    GLuint64 to_handle(GLuint64 captured) const;
+    void add_handle(GLuint64 captured, GLuint64 handle) { handles_[captured] = handle; }
+    void add_mapping(GLuint buffer, void* data, size_t size);
+    void remove_mapping(GLuint buffer) { mappings_.erase(buffer); }
+
+    bool replay_frame();
+    const GLReplayFrame& get_last_frame() const { return last_frame_; }
+    std::span<const std::uint64_t> get_call_counts() const { return call_counts_; }
+private:
+    struct Mapping {
+        std::byte* data = nullptr;
+        size_t size = 0;
+    };
+
+    struct PendingWrite {
+        GLuint buffer;
+        std::uint64_t offset;
+        std::span<const std::byte> data;
+    };
+
+    void write_mapping(GLuint buffer, std::uint64_t offset, std::span<const std::byte> data);
+    void apply_frame_writes();
+
+    MappedFile file_;
+    std::span<const std::byte> bytes_;
+    size_t position_ = 0;
+    std::vector<GLFunction> functions_;
+    std::vector<std::string_view> function_names_;
+    std::vector<bool> reads_mappings_;     // Per captured entry point, see mapping_reader_prefixes
+    std::unordered_map<BlobKey, std::span<const std::byte>, BlobKeyHash> blobs_;
+    std::array<std::vector<GLuint>, name_kinds.size()> names_;
+    std::unordered_map<std::uint64_t, GLsync> syncs_;
+    std::unordered_map<GLuint64, GLuint64> handles_;
+    std::unordered_map<GLuint, Mapping> mappings_;
+    std::vector<PendingWrite> pending_writes_; // For buffers not mapped yet
+    std::vector<PendingWrite> frame_writes_;   // Of the current frame, not applied yet
+    std::array<std::vector<std::byte>, 16> outputs_;
+    GLReplayFrame last_frame_;
+    std::array<std::uint64_t, gl_function_count> call_counts_{};
+};
+
+} // namespace glw
+
+namespace {
+
+template<char Kind, typename T>
+void encode(GLTraceWriter& writer, T value) {
+    if constexpr (Kind == 'g') {
+        return;
+    } else if constexpr (Kind == 'c') {
+        writer.write_string(value);
+    } else if constexpr (Kind == 'o' || Kind == 'y') {
+        writer.write(to_pointer_value(value));
+    } else {
+        static_assert(!std::is_pointer_v<T>, "Pointer arguments need a pointer kind!");
+        writer.write(value);
+    }
+}
+
+template<char Kind, typename T, u32 Slot>
+T decode(GLTraceReader& reader) {
+    if constexpr (Kind == 'g') {
+        return reinterpret_cast<T>(reader.get_output(Slot, output_size));
+    } else if constexpr (Kind == 'c') {
+        return reader.read_string();
+    } else if constexpr (Kind == 'o') {
+        return to_pointer<T>(reader.read<std::uint64_t>());
+    } else if constexpr (Kind == 'y') {
+        return reader.to_sync(reader.read<std::uint64_t>());
+    } else if constexpr (Kind == 'h') {
+        return reader.to_handle(reader.read<GLuint64>());
+    } else if constexpr (is_name_kind(Kind)) {
+        return reader.to_name(Kind, reader.read<GLuint>());
+    } else {
+        return reader.read<T>();
+    }
+}
+
+template<typename R>
+struct Result {
+    R value;
+};
+
+template<>
+struct Result<void> {};
+
+/*
+* Stores the arguments of a call after it returned and issues it again from the trace
+* Results that name objects are recorded so replay can map the captured names to its own
+*/
+template<GLFunction Function, typename T>
+struct GenericCodec;
+
+template<GLFunction Function, typename R, typename... Args>
+struct GenericCodec<Function, R (APIENTRY*)(Args...)> {
+    static constexpr std::string_view signature = to_signature(Function);
+    static constexpr size_t result_position = std::min(signature.find('>'), signature.size());
+    static constexpr std::string_view arguments = signature.substr(0, result_position);
+    static constexpr char result_kind = result_position < signature.size() ? signature[result_position + 1] : '.';
+    static_assert(arguments.find('*') == std::string_view::npos, "Entry point needs its own Codec!");
+    static_assert(arguments.size() == sizeof...(Args), "Signature does not match the entry point!");
+
+    static void capture(GLTraceWriter& writer, [[maybe_unused]] Result<R> result, Args... args) {
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (encode<arguments[I]>(writer, args), ...);
+        }(std::index_sequence_for<Args...>{});
+
+        if constexpr (result_kind == 'y') writer.write(to_pointer_value(result.value));
+        else if constexpr (result_kind == 'h') writer.write(result.value);
+        else if constexpr (is_name_kind(result_kind)) writer.write(result.value);
+    }
+
+    static void replay(GLTraceReader& reader, R (APIENTRY* function)(Args...)) {
+        // Braced initialization decodes the arguments in order
+        auto args = [&]<size_t... I>(std::index_sequence<I...>) {
+            return std::tuple<Args...>{ decode<arguments[I], Args, I>(reader)... };
+        }(std::index_sequence_for<Args...>{});
+
+        if constexpr (std::is_void_v<R>) {
+            std::apply(function, args);
+        } else {
+            R result = std::apply(function, args);
+            if constexpr (result_kind == 'y') reader.add_sync(reader.read<std::uint64_t>(), result);
+            else if constexpr (result_kind == 'h') reader.add_handle(reader.read<GLuint64>(), result);
+            else if constexpr (is_name_kind(result_kind)) reader.add_name(result_kind, reader.read<GLuint>(), result);
+        }
+    }
+};
+
+template<GLFunction Function, typename T>
+struct Codec :
+    GenericCodec<Function, T> {};
+
+#define GL_CODEC(NAME) template<> struct Codec<GLFunction::NAME, decltype(::NAME)>
+
+template<char Kind>
+struct CreateNamesCodec {
+    static void capture(GLTraceWriter& writer, Result<void>, GLsizei count, GLuint* names) {
+        writer.write(count);
+        writer.write_bytes(std::as_bytes(std::span{ names, static_cast<size_t>(count) }));
+    }
+
+    static void replay(GLTraceReader& reader, void (APIENTRY* function)(GLsizei, GLuint*)) {
+        auto count = reader.read<GLsizei>();
+        auto names = reinterpret_cast<GLuint*>(reader.get_output(0, count * sizeof(GLuint)));
+        function(count, names);
+        for (GLsizei i = 0; i < count; ++i) reader.add_name(Kind, reader.read<GLuint>(), names[i]);
+    }
+};
+
+template<char Kind>
+struct CreateTargetNamesCodec {
+    static void capture(GLTraceWriter& writer, Result<void>, GLenum target, GLsizei count, GLuint* names) {
+        writer.write(target);
+        CreateNamesCodec<Kind>::capture(writer, {}, count, names);
+    }
+
+    static void replay(GLTraceReader& reader, void (APIENTRY* function)(GLenum, GLsizei, GLuint*)) {
+        auto target = reader.read<GLenum>();
+        auto count = reader.read<GLsizei>();
+        auto names = reinterpret_cast<GLuint*>(reader.get_output(0, count * sizeof(GLuint)));
+        function(target, count, names);
+        for (GLsizei i = 0; i < count; ++i) reader.add_name(Kind, reader.read<GLuint>(), names[i]);
+    }
+};
+
+template<char Kind>
+struct DeleteNamesCodec {
+    static void capture(GLTraceWriter& writer, Result<void>, GLsizei count, const GLuint* names) {
+        writer.write(count);
+        writer.write_bytes(std::as_bytes(std::span{ names, static_cast<size_t>(count) }));
+        if constexpr (Kind == 'b') {
+            for (GLsizei i = 0; i < count; ++i) writer.remove_mapping(names[i]);
+        }
+    }
+
+    static void replay(GLTraceReader& reader, void (APIENTRY* function)(GLsizei, const GLuint*)) {
+        auto count = reader.read<GLsizei>();
+        auto names = reinterpret_cast<GLuint*>(reader.get_output(0, count * sizeof(GLuint)));
+        for (GLsizei i = 0; i < count; ++i) {
+            auto captured = reader.read<GLuint>();
+            names[i] = reader.to_name(Kind, captured);
+            if constexpr (Kind == 'b') reader.remove_mapping(captured);
+        }
+        function(count, names);
+    }
+};
+
+GL_CODEC(glCreateBuffers) : CreateNamesCodec<'b'> {};
+GL_CODEC(glCreateFramebuffers) : CreateNamesCodec<'f'> {};
+GL_CODEC(glCreateQueries) : CreateTargetNamesCodec<'q'> {};
+GL_CODEC(glCreateSamplers) : CreateNamesCodec<'m'> {};
+GL_CODEC(glCreateTextures) : CreateTargetNamesCodec<'t'> {};
+GL_CODEC(glCreateVertexArrays) : CreateNamesCodec<'v'> {};
+GL_CODEC(glDeleteBuffers) : DeleteNamesCodec<'b'> {};
+GL_CODEC(glDeleteFramebuffers) : DeleteNamesCodec<'f'> {};
+GL_CODEC(glDeleteQueries) : DeleteNamesCodec<'q'> {};
+GL_CODEC(glDeleteSamplers) : DeleteNamesCodec<'m'> {};
+GL_CODEC(glDeleteTextures) : DeleteNamesCodec<'t'> {};
+GL_CODEC(glDeleteVertexArrays) : DeleteNamesCodec<'v'> {};
+
+// The replaying process has no use for the captured callback
+GL_CODEC(glDebugMessageCallback) {
+    static void capture(GLTraceWriter&, Result<void>, GLDEBUGPROC, const void*) {}
+    static void replay(GLTraceReader&, PFNGLDEBUGMESSAGECALLBACKPROC) {}
+};
+
+GL_CODEC(glBindBuffer) : GenericCodec<GLFunction::glBindBuffer, PFNGLBINDBUFFERPROC> {
+    static void capture(GLTraceWriter& writer, Result<void> result, GLenum target, GLuint buffer) {
+        GenericCodec::capture(writer, result, target, buffer);
+        if (target == GL_PIXEL_UNPACK_BUFFER) writer.unpack_buffer = buffer;
+        if (target == GL_PIXEL_PACK_BUFFER) writer.pack_buffer = buffer;
+    }
+};
+
+GL_CODEC(glPixelStorei) : GenericCodec<GLFunction::glPixelStorei, PFNGLPIXELSTOREIPROC> {
+    static void capture(GLTraceWriter& writer, Result<void> result, GLenum name, GLint value) {
+        GenericCodec::capture(writer, result, name, value);
+        switch (name) {
+        case GL_UNPACK_ALIGNMENT:    writer.unpack_alignment = value; break;
+        case GL_UNPACK_ROW_LENGTH:   writer.unpack_row_length = value; break;
+        case GL_UNPACK_IMAGE_HEIGHT: writer.unpack_image_height = value; break;
+        }
+    }
+};
+
+size_t to_clear_value_count(GLenum buffer) {
+    return buffer == GL_COLOR ? 4 : 1;
+}
+
+template<typename T>
+struct ClearFramebufferCodec {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint framebuffer, GLenum buffer, GLint draw_buffer, const T* value) {
+        writer.write(framebuffer);
+        writer.write(buffer);
+        writer.write(draw_buffer);
+        writer.write_bytes(std::as_bytes(std::span{ value, to_clear_value_count(buffer) }));
+    }
+
+    static void replay(GLTraceReader& reader, void (APIENTRY* function)(GLuint, GLenum, GLint, const T*)) {
+        auto framebuffer = reader.to_name('f', reader.read<GLuint>());
+        auto buffer = reader.read<GLenum>();
+        auto draw_buffer = reader.read<GLint>();
+        function(framebuffer, buffer, draw_buffer, reader.read_array<T>(0, to_clear_value_count(buffer)));
+    }
+};
+
+GL_CODEC(glClearNamedFramebufferfv) : ClearFramebufferCodec<GLfloat> {};
+GL_CODEC(glClearNamedFramebufferiv) : ClearFramebufferCodec<GLint> {};
+
+// A single texel of client memory, a null value clears to zero
+GL_CODEC(glClearTexImage) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint texture, GLint level, GLenum format, GLenum type, const void* data) {
+        writer.write(texture);
+        writer.write(level);
+        writer.write(format);
+        writer.write(type);
+        u32 size = data ? to_gl_pixel_size(format, type) : 0;
+        cut::ensure(!data || size > 0, "Can not capture texture clear with format {:#x} and type {:#x}!", format, type);
+        writer.write(size);
+        writer.write_bytes({ static_cast<const std::byte*>(data), size });
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLCLEARTEXIMAGEPROC function) {
+        auto texture = reader.to_name('t', reader.read<GLuint>());
+        auto level = reader.read<GLint>();
+        auto format = reader.read<GLenum>();
+        auto type = reader.read<GLenum>();
+        auto size = reader.read<u32>();
+        function(texture, level, format, type, size > 0 ? reader.read_array<std::byte>(0, size) : nullptr);
+    }
+};
+
+GL_CODEC(glNamedBufferStorage) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags) {
+        writer.write(buffer);
+        writer.write(size);
+        writer.write(flags);
+        writer.write(static_cast<u8>(data != nullptr));
+        if (data) writer.write_blob({ static_cast<const std::byte*>(data), static_cast<size_t>(size) });
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLNAMEDBUFFERSTORAGEPROC function) {
+        auto buffer = reader.to_name('b', reader.read<GLuint>());
+        auto size = reader.read<GLsizeiptr>();
+        auto flags = reader.read<GLbitfield>();
+        const void* data = reader.read<u8>() ? reader.read_blob().data() : nullptr;
+        function(buffer, size, data, flags);
+    }
+};
+
+GL_CODEC(glNamedBufferSubData) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data) {
+        writer.write(buffer);
+        writer.write(offset);
+        writer.write(size);
+        writer.write_blob({ static_cast<const std::byte*>(data), static_cast<size_t>(size) });
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLNAMEDBUFFERSUBDATAPROC function) {
+        auto buffer = reader.to_name('b', reader.read<GLuint>());
+        auto offset = reader.read<GLintptr>();
+        auto size = reader.read<GLsizeiptr>();
+        function(buffer, offset, size, reader.read_blob().data());
+    }
+};
+
+GL_CODEC(glGetNamedBufferSubData) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint buffer, GLintptr offset, GLsizeiptr size, void*) {
+        writer.write(buffer);
+        writer.write(offset);
+        writer.write(size);
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLGETNAMEDBUFFERSUBDATAPROC function) {
+        auto buffer = reader.to_name('b', reader.read<GLuint>());
+        auto offset = reader.read<GLintptr>();
+        auto size = reader.read<GLsizeiptr>();
+        function(buffer, offset, size, reader.get_output(0, static_cast<size_t>(size)));
+    }
+};
+
+/*
+* Mapped ranges are snapshotted at the end of every frame, replay applies the changed pages to its own mapping
+* right before the first call of the frame that can read them, see mapping_reader_prefixes
+*/
+GL_CODEC(glMapNamedBufferRange) {
+    static void capture(GLTraceWriter& writer, Result<void*> result, GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+        writer.write(buffer);
+        writer.write(offset);
+        writer.write(length);
+        writer.write(access);
+        if (result.value && (access & GL_MAP_WRITE_BIT)) writer.add_mapping(buffer, result.value, static_cast<size_t>(length));
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLMAPNAMEDBUFFERRANGEPROC function) {
+        auto captured = reader.read<GLuint>();
+        auto offset = reader.read<GLintptr>();
+        auto length = reader.read<GLsizeiptr>();
+        auto access = reader.read<GLbitfield>();
+        void* data = function(reader.to_name('b', captured), offset, length, access);
+        if (data && (access & GL_MAP_WRITE_BIT)) reader.add_mapping(captured, data, static_cast<size_t>(length));
+    }
+};
+
+template<bool BaseVertex>
+struct MultiDrawElementsCodec {
+    static void capture(GLTraceWriter& writer, GLenum mode, const GLsizei* counts, GLenum type, const void* const* offsets,
+                        GLsizei draw_count, const GLint* base_vertices) {
+        writer.write(mode);
+        writer.write(type);
+        writer.write(draw_count);
+        writer.write_bytes(std::as_bytes(std::span{ counts, static_cast<size_t>(draw_count) }));
+        for (GLsizei i = 0; i < draw_count; ++i) writer.write(to_pointer_value(offsets[i]));
+        if constexpr (BaseVertex) writer.write_bytes(std::as_bytes(std::span{ base_vertices, static_cast<size_t>(draw_count) }));
+    }
+
+    struct Draws {
+        GLenum mode = 0;
+        GLenum type = 0;
+        GLsizei draw_count = 0;
+        const GLsizei* counts = nullptr;
+        const void* const* offsets = nullptr;
+        const GLint* base_vertices = nullptr;
+    };
+
+    static Draws read(GLTraceReader& reader) {
+        Draws draws;
+        draws.mode = reader.read<GLenum>();
+        draws.type = reader.read<GLenum>();
+        draws.draw_count = reader.read<GLsizei>();
+        auto count = static_cast<size_t>(draws.draw_count);
+        draws.counts = reader.read_array<GLsizei>(0, count);
+        auto offsets = reinterpret_cast<const void**>(reader.get_output(1, count * sizeof(void*)));
+        for (size_t i = 0; i < count; ++i) offsets[i] = to_pointer<const void*>(reader.read<std::uint64_t>());
+        draws.offsets = offsets;
+        if constexpr (BaseVertex) draws.base_vertices = reader.read_array<GLint>(2, count);
+        return draws;
+    }
+};
+
+GL_CODEC(glMultiDrawElements) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLenum mode, const GLsizei* counts, GLenum type,
+                        const void* const* offsets, GLsizei draw_count) {
+        MultiDrawElementsCodec<false>::capture(writer, mode, counts, type, offsets, draw_count, nullptr);
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLMULTIDRAWELEMENTSPROC function) {
+        auto draws = MultiDrawElementsCodec<false>::read(reader);
+        function(draws.mode, draws.counts, draws.type, draws.offsets, draws.draw_count);
+    }
+};
+
+GL_CODEC(glMultiDrawElementsBaseVertex) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLenum mode, const GLsizei* counts, GLenum type,
+                        const void* const* offsets, GLsizei draw_count, const GLint* base_vertices) {
+        MultiDrawElementsCodec<true>::capture(writer, mode, counts, type, offsets, draw_count, base_vertices);
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC function) {
+        auto draws = MultiDrawElementsCodec<true>::read(reader);
+        function(draws.mode, draws.counts, draws.type, draws.offsets, draws.draw_count, draws.base_vertices);
+    }
+};
+
+GL_CODEC(glNamedFramebufferDrawBuffers) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint framebuffer, GLsizei count, const GLenum* buffers) {
+        writer.write(framebuffer);
+        writer.write(count);
+        writer.write_bytes(std::as_bytes(std::span{ buffers, static_cast<size_t>(count) }));
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLNAMEDFRAMEBUFFERDRAWBUFFERSPROC function) {
+        auto framebuffer = reader.to_name('f', reader.read<GLuint>());
+        auto count = reader.read<GLsizei>();
+        function(framebuffer, count, reader.read_array<GLenum>(0, static_cast<size_t>(count)));
+    }
+};
+
+template<size_t Components>
+struct UniformVectorCodec {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint program, GLint location, GLsizei count, const GLfloat* value) {
+        writer.write(program);
+        writer.write(location);
+        writer.write(count);
+        writer.write_bytes(std::as_bytes(std::span{ value, count * Components }));
+    }
+
+    static void replay(GLTraceReader& reader, void (APIENTRY* function)(GLuint, GLint, GLsizei, const GLfloat*)) {
+        auto program = reader.to_name('p', reader.read<GLuint>());
+        auto location = reader.read<GLint>();
+        auto count = reader.read<GLsizei>();
+        function(program, location, count, reader.read_array<GLfloat>(0, count * Components));
+    }
+};
+
+template<size_t Components>
+struct UniformMatrixCodec {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint program, GLint location, GLsizei count, GLboolean transpose,
+                        const GLfloat* value) {
+        writer.write(program);
+        writer.write(location);
+        writer.write(count);
+        writer.write(transpose);
+        writer.write_bytes(std::as_bytes(std::span{ value, count * Components }));
+    }
+
+    static void replay(GLTraceReader& reader, void (APIENTRY* function)(GLuint, GLint, GLsizei, GLboolean, const GLfloat*)) {
+        auto program = reader.to_name('p', reader.read<GLuint>());
+        auto location = reader.read<GLint>();
+        auto count = reader.read<GLsizei>();
+        auto transpose = reader.read<GLboolean>();
+        function(program, location, count, transpose, reader.read_array<GLfloat>(0, count * Components));
+    }
+};
+
+GL_CODEC(glProgramUniform3fv) : UniformVectorCodec<3> {};
+GL_CODEC(glProgramUniformMatrix3fv) : UniformMatrixCodec<9> {};
+GL_CODEC(glProgramUniformMatrix4fv) : UniformMatrixCodec<16> {};
+
+GL_CODEC(glShaderSource) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint shader, GLsizei count, const GLchar* const* strings,
+                        const GLint* lengths) {
+        writer.write(shader);
+        writer.write(count);
+        for (GLsizei i = 0; i < count; ++i) {
+            auto length = lengths && lengths[i] >= 0 ? static_cast<u32>(lengths[i]) : cut::to_u32(std::strlen(strings[i]));
+            writer.write(length);
+            writer.write_bytes(std::as_bytes(std::span{ strings[i], length }));
+        }
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLSHADERSOURCEPROC function) {
+        auto shader = reader.to_name('s', reader.read<GLuint>());
+        auto count = reader.read<GLsizei>();
+        auto strings = reinterpret_cast<const GLchar**>(reader.get_output(0, count * sizeof(GLchar*)));
+        auto lengths = reinterpret_cast<GLint*>(reader.get_output(1, count * sizeof(GLint)));
+        for (GLsizei i = 0; i < count; ++i) {
+            auto length = reader.read<u32>();
+            strings[i] = reinterpret_cast<const GLchar*>(reader.read_bytes(length).data());
+            lengths[i] = static_cast<GLint>(length);
+        }
+        function(shader, count, strings, lengths);
+    }
+};
+
+/*
+* Client pixel data read by a texture upload, rows follow the unpack alignment and row length
+*/
+size_t to_client_image_size(const GLTraceWriter& writer, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type) {
+    size_t pixel_size = to_gl_pixel_size(format, type);
+    cut::ensure(pixel_size > 0, "Can not capture texture upload with format {:#x} and type {:#x}!", format, type);
+    if (width == 0 || height == 0 || depth == 0) return 0;
+
+    auto alignment = static_cast<size_t>(writer.unpack_alignment);
+    size_t row_pixels = writer.unpack_row_length > 0 ? writer.unpack_row_length : width;
+    size_t row_size = (row_pixels * pixel_size + alignment - 1) / alignment * alignment;
+    size_t image_rows = writer.unpack_image_height > 0 ? writer.unpack_image_height : height;
+    return row_size * (image_rows * (depth - 1) + height - 1) + width * pixel_size;
+}
+
+/*
+* Pixels come from the bound unpack buffer as an offset or from client memory as a blob
+*/
+void write_pixels(GLTraceWriter& writer, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type,
+                  const void* pixels) {
+    writer.write(format);
+    writer.write(type);
+    writer.write(static_cast<u8>(writer.unpack_buffer != 0));
+    if (writer.unpack_buffer != 0) {
+        writer.write(to_pointer_value(pixels));
+        return;
+    }
+    writer.write_blob({ static_cast<const std::byte*>(pixels), to_client_image_size(writer, width, height, depth, format, type) });
+}
+
+struct Pixels {
+    GLenum format;
+    GLenum type;
+    const void* data;
+};
+
+Pixels read_pixels(GLTraceReader& reader) {
+    Pixels pixels{ reader.read<GLenum>(), reader.read<GLenum>(), nullptr };
+    pixels.data = reader.read<u8>() ? to_pointer<const void*>(reader.read<std::uint64_t>()) : reader.read_blob().data();
+    return pixels;
+}
+
+GL_CODEC(glTextureSubImage2D) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint texture, GLint level, GLint x, GLint y, GLsizei width,
+                        GLsizei height, GLenum format, GLenum type, const void* pixels) {
+        for (GLint value : { static_cast<GLint>(texture), level, x, y, width, height }) writer.write(value);
+        write_pixels(writer, width, height, 1, format, type, pixels);
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLTEXTURESUBIMAGE2DPROC function) {
+        auto texture = reader.to_name('t', reader.read<GLuint>());
+        std::array<GLint, 5> values;
+        for (auto& value : values) value = reader.read<GLint>();
+        auto pixels = read_pixels(reader);
+        function(texture, values[0], values[1], values[2], values[3], values[4], pixels.format, pixels.type, pixels.data);
+    }
+};
+
+GL_CODEC(glTextureSubImage3D) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint texture, GLint level, GLint x, GLint y, GLint z, GLsizei width,
+                        GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels) {
+        for (GLint value : { static_cast<GLint>(texture), level, x, y, z, width, height, depth }) writer.write(value);
+        write_pixels(writer, width, height, depth, format, type, pixels);
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLTEXTURESUBIMAGE3DPROC function) {
+        auto texture = reader.to_name('t', reader.read<GLuint>());
+        std::array<GLint, 7> values;
+        for (auto& value : values) value = reader.read<GLint>();
+        auto pixels = read_pixels(reader);
+        function(texture, values[0], values[1], values[2], values[3], values[4], values[5], values[6], pixels.format, pixels.type,
+                 pixels.data);
+    }
+};
+
+// Reads back into the bound pack buffer at an offset or into client memory
+GL_CODEC(glGetTextureImage) {
+    static void capture(GLTraceWriter& writer, Result<void>, GLuint texture, GLint level, GLenum format, GLenum type, GLsizei size,
+                        void* pixels) {
+        writer.write(texture);
+        writer.write(level);
+        writer.write(format);
+        writer.write(type);
+        writer.write(size);
+        writer.write(static_cast<u8>(writer.pack_buffer != 0));
+        if (writer.pack_buffer != 0) writer.write(to_pointer_value(pixels));
+    }
+
+    static void replay(GLTraceReader& reader, PFNGLGETTEXTUREIMAGEPROC function) {
+        auto texture = reader.to_name('t', reader.read<GLuint>());
+        auto level = reader.read<GLint>();
+        auto format = reader.read<GLenum>();
+        auto type = reader.read<GLenum>();
+        auto size = reader.read<GLsizei>();
+        void* pixels = reader.read<u8>() ? to_pointer<void*>(reader.read<std::uint64_t>()) : reader.get_output(0, static_cast<size_t>(size));
+        function(texture, level, format, type, size, pixels);
+    }
+};
+
+#undef GL_CODEC
+
+using ReplayFunction = void (*)(GLTraceReader&);
+
+const ReplayFunction replay_functions[] = {
+#define REPLAY_GL_FUNCTION(TYPE, NAME) [](GLTraceReader& reader) {                                 \
+        cut::ensure(NAME != nullptr, "GL trace calls {} which this context does not support!", #NAME); \
+        Codec<GLFunction::NAME, TYPE>::replay(reader, NAME);                                           \
+    },
+FOR_ALL_OPENGL_FUNCTIONS(REPLAY_GL_FUNCTION)
+#undef REPLAY_GL_FUNCTION
+};
+
+#if GLW_INSTRUMENT_GL
+
+GLTraceWriter* active_writer = nullptr;
+
+/*
+* One thunk per entry point, calls the loaded pointer and records the call into the active capture
+*/
+template<GLFunction Function, typename T>
+struct CaptureThunk;
+
+template<GLFunction Function, typename R, typename... Args>
+struct CaptureThunk<Function, R (APIENTRY*)(Args...)> {
+    static inline R (APIENTRY* real)(Args...) = nullptr;
+
+    static R APIENTRY call(Args... args) {
+        using FunctionCodec = Codec<Function, R (APIENTRY*)(Args...)>;
+        active_writer->begin_call(Function);
+        if constexpr (std::is_void_v<R>) {
+            real(args...);
+            FunctionCodec::capture(*active_writer, {}, args...);
+        } else {
+            R result = real(args...);
+            FunctionCodec::capture(*active_writer, { result }, args...);
+            return result;
+        }
+    }
+};
+
+#define CAPTURE_THUNK(TYPE, NAME) CaptureThunk<GLFunction::NAME, TYPE>
+
+void install_capture_thunks() {
+#define INSTALL_CAPTURE_THUNK(TYPE, NAME) CAPTURE_THUNK(TYPE, NAME)::real = NAME; if (NAME) NAME = CAPTURE_THUNK(TYPE, NAME)::call;
+FOR_ALL_OPENGL_FUNCTIONS(INSTALL_CAPTURE_THUNK)
+#undef INSTALL_CAPTURE_THUNK
+}
+
+// Entries something else replaced since install keep their pointer instead of going back to a stale one
+void remove_capture_thunks() {
+#define REMOVE_CAPTURE_THUNK(TYPE, NAME) if (NAME == CAPTURE_THUNK(TYPE, NAME)::call) NAME = CAPTURE_THUNK(TYPE, NAME)::real;
+FOR_ALL_OPENGL_FUNCTIONS(REMOVE_CAPTURE_THUNK)
+#undef REMOVE_CAPTURE_THUNK
+}
+
+#undef CAPTURE_THUNK
+
+#endif // GLW_INSTRUMENT_GL
+
+} // namespace
+
+namespace glw {
+
+GLTraceWriter::GLTraceWriter(const std::filesystem::path& path) :
+    file_(path, std::ios::binary) {
+    cut::ensure(file_.good(), "Could not create GL trace {}!", path.string());
+
+    std::vector<std::byte> header;
+    header.insert(header.end(), reinterpret_cast<const std::byte*>(trace_magic), reinterpret_cast<const std::byte*>(trace_magic) + 4);
+    append(header, trace_version);
+    append(header, gl_function_count);
+    for (u32 i = 0; i < gl_function_count; ++i) {
+        std::string_view name = get_gl_function_name(static_cast<GLFunction>(i));
+        append(header, static_cast<u8>(name.size()));
+        header.insert(header.end(), reinterpret_cast<const std::byte*>(name.data()), reinterpret_cast<const std::byte*>(name.data()) + name.size());
+    }
+    file_.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+}
+
+void GLTraceWriter::write_string(const char* string) {
+    auto length = cut::to_u32(std::strlen(string));
+    write(length);
+    // The terminator is kept so replay can point into the trace
+    write_bytes(std::as_bytes(std::span{ string, length + 1 }));
+}
+
+BlobKey GLTraceWriter::add_blob(std::span<const std::byte> bytes) {
+    BlobKey key{ hash_bytes(bytes), bytes.size() };
+    if (written_blobs_.insert(key).second) {
+        append(blobs_, blob_tag);
+        append(blobs_, key.hash);
+        append(blobs_, key.size);
+        blobs_.insert(blobs_.end(), bytes.begin(), bytes.end());
+        blob_bytes_ += bytes.size();
+    }
+    return key;
+}
+
+void GLTraceWriter::add_mapping(GLuint buffer, void* data, size_t size) {
+    // Pages start unhashed so the first end_frame stores the whole range
+    size_t page_count = (size + mapping_page_size - 1) / mapping_page_size;
+    mappings_[buffer] = { static_cast<std::byte*>(data), size, std::vector<std::uint64_t>(page_count, 0) };
+}
+
+void GLTraceWriter::write_mapping_changes(GLuint buffer, Mapping& mapping) {
+    for (size_t page = 0; page < mapping.page_hashes.size(); ++page) {
+        size_t offset = page * mapping_page_size;
+        std::span<const std::byte> bytes{ mapping.data + offset, std::min(mapping_page_size, mapping.size - offset) };
+        std::uint64_t hash = hash_bytes(bytes);
+        if (hash == mapping.page_hashes[page]) continue;
+
+        mapping.page_hashes[page] = hash;
+        BlobKey key = add_blob(bytes);
+        append(mapping_writes_, mapping_write_tag);
+        append(mapping_writes_, buffer);
+        append(mapping_writes_, static_cast<std::uint64_t>(offset));
+        append(mapping_writes_, key);
+    }
+}
+
+void GLTraceWriter::end_frame() {
+    for (auto& [buffer, mapping] : mappings_) write_mapping_changes(buffer, mapping);
+    append(calls_, frame_end_tag);
+
+    for (const auto* bytes : { &blobs_, &mapping_writes_, &calls_ }) {
+        file_.write(reinterpret_cast<const char*>(bytes->data()), static_cast<std::streamsize>(bytes->size()));
+    }
+    blobs_.clear();
+    mapping_writes_.clear();
+    calls_.clear();
+    frame_count_++;
+}
+
+void GLTraceWriter::finish() {
+    if (!calls_.empty()) end_frame();
+    file_.flush();
+}
+
+GLTraceReader::GLTraceReader(const std::filesystem::path& path) :
+    file_(path),
+    bytes_(file_.get_bytes()) {
+    cut::ensure(bytes_.size() >= sizeof(trace_magic) && std::memcmp(bytes_.data(), trace_magic, sizeof(trace_magic)) == 0,
+                "{} is not a GL trace!", path.string());
+    position_ = sizeof(trace_magic);
+    auto version = read<u32>();
+    cut::ensure(version == trace_version, "GL trace version {} is not supported!", version);
+
+    // Captured entry points are matched by name, so traces survive changes to FOR_OPENGL_FUNCTIONS
+    auto count = read<u32>();
+    cut::ensure(count < blob_tag, "GL trace has too many entry points!");
+    for (u32 i = 0; i < count; ++i) {
+        auto length = read<u8>();
+        auto name_bytes = read_bytes(length);
+        std::string_view name{ reinterpret_cast<const char*>(name_bytes.data()), length };
+        GLFunction function = GLFunction::Count;
+        for (u32 j = 0; j < gl_function_count; ++j) {
+            if (name == get_gl_function_name(static_cast<GLFunction>(j))) function = static_cast<GLFunction>(j);
+        }
+        functions_.push_back(function);
+        function_names_.push_back(name);
+        reads_mappings_.push_back(reads_mappings(name));
+    }
+}
+
+std::span<const std::byte> GLTraceReader::read_bytes(size_t size) {
+    cut::ensure(size <= bytes_.size() - position_, "GL trace is truncated!");
+    auto bytes = bytes_.subspan(position_, size);
+    position_ += size;
+    return bytes;
+}
+
+const char* GLTraceReader::read_string() {
+    auto length = read<u32>();
+    return reinterpret_cast<const char*>(read_bytes(length + 1).data());
+}
+
+std::span<const std::byte> GLTraceReader::read_blob() {
+    auto key = read<BlobKey>();
+    auto blob = blobs_.find(key);
+    cut::ensure(blob != blobs_.end(), "GL trace references unknown blob {:#x}!", key.hash);
+    return blob->second;
+}
+
+std::byte* GLTraceReader::get_output(u32 slot, size_t size) {
+    auto& output = outputs_[slot];
+    if (output.size() < size) output.resize(size);
+    return output.data();
+}
+
+GLuint GLTraceReader::to_name(char kind, GLuint captured) const {
+    const auto& names = names_[name_kinds.find(kind)];
+    // Names the trace never created, like the default framebuffer, are used as they are
+    return captured < names.size() && names[captured] != 0 ? names[captured] : captured;
+}
+
+void GLTraceReader::add_name(char kind, GLuint captured, GLuint name) {
+    cut::ensure(captured < (1u << 24), "GL trace uses unexpectedly large object name {}!", captured);
+    auto& names = names_[name_kinds.find(kind)];
+    if (names.size() <= captured) names.resize(captured + 1, 0);
+    names[captured] = name;
+}
+
+GLsync GLTraceReader::to_sync(std::uint64_t captured) const {
+    auto sync = syncs_.find(captured);
+    return sync != syncs_.end() ? sync->second : nullptr;
+}
+
+GLuint64 GLTraceReader::to_handle(GLuint64 captured) const {
+    auto handle = handles_.find(captured);
+    return handle != handles_.end() ? handle->second : captured;
+}
+
+void GLTraceReader::add_mapping(GLuint buffer, void* data, size_t size) {
+    mappings_[buffer] = { static_cast<std::byte*>(data), size };
+    std::erase_if(pending_writes_, [&](const PendingWrite& pending) {
+        if (pending.buffer != buffer) return false;
+        write_mapping(pending.buffer, pending.offset, pending.data);
+        return true;
+    });
+}
+
+void GLTraceReader::write_mapping(GLuint buffer, std::uint64_t offset, std::span<const std::byte> data) {
+    auto mapping = mappings_.find(buffer);
+    if (mapping == mappings_.end()) {
+        // The capture mapped the buffer before this frame's calls, replay maps it while issuing them
+        pending_writes_.push_back({ buffer, offset, data });
+        return;
+    }
+    cut::ensure(offset + data.size() <= mapping->second.size, "GL trace writes past mapped buffer {}!", buffer);
+    std::memcpy(mapping->second.data + offset, data.data(), data.size());
+}
+
+void GLTraceReader::apply_frame_writes() {
+    for (const auto& write : frame_writes_) write_mapping(write.buffer, write.offset, write.data);
+    frame_writes_.clear();
+}
+
+bool GLTraceReader::replay_frame() {
+    if (position_ == bytes_.size()) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    u32 calls = 0;
+    while (true) {
+        auto tag = read<u16>();
+        if (tag == frame_end_tag) {
+            apply_frame_writes();
+            break;
+        }
+
+        if (tag == blob_tag) {
+            auto key = read<BlobKey>();
+            blobs_[key] = read_bytes(key.size);
+        } else if (tag == mapping_write_tag) {
+            auto buffer = read<GLuint>();
+            auto offset = read<std::uint64_t>();
+            frame_writes_.push_back({ buffer, offset, read_blob() });
+        } else {
+            cut::ensure(tag < functions_.size(), "GL trace is corrupt!");
+            if (!frame_writes_.empty() && reads_mappings_[tag]) apply_frame_writes();
+            GLFunction function = functions_[tag];
+            cut::ensure(function != GLFunction::Count, "GL trace calls {} which glw does not load!", function_names_[tag]);
+            replay_functions[static_cast<u32>(function)](*this);
+            call_counts_[static_cast<u32>(function)]++;
+            calls++;
+        }
+    }
+
+    last_frame_ = { calls, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() };
+    return true;
+}
+
+bool is_gl_capture_active() {
+#if GLW_INSTRUMENT_GL
+    return active_writer != nullptr;
+#else
+    return false;
+#endif
+}
+
+GLCapture::GLCapture([[maybe_unused]] const std::filesystem::path& path) {
+#if GLW_INSTRUMENT_GL
+    cut::ensure(active_writer == nullptr, "Only one GLCapture can run at a time!");
+    writer_ = std::make_unique<GLTraceWriter>(path);
+    active_writer = writer_.get();
+    install_capture_thunks();
+#else
+    throw cut::Exception("glw was built without GLW_INSTRUMENT_GL!");
+#endif
+}
+
+GLCapture::~GLCapture() {
+#if GLW_INSTRUMENT_GL
+    remove_capture_thunks();
+    active_writer = nullptr;
+    writer_->finish();
+#endif
+}
+
+void GLCapture::end_frame() {
+    writer_->end_frame();
+}
+
+u32 GLCapture::get_frame_count() const {
+    return writer_->get_frame_count();
+}
+
+std::uint64_t GLCapture::get_blob_bytes() const {
+    return writer_->get_blob_bytes();
+}
+
+GLReplay::GLReplay(const std::filesystem::path& path) :
+    reader_(std::make_unique<GLTraceReader>(path)) {}
+
+GLReplay::~GLReplay() = default;
+
+bool GLReplay::replay_frame() {
+    return reader_->replay_frame();
+}
+
+const GLReplayFrame& GLReplay::get_last_frame() const {
+    return reader_->get_last_frame();
+}
+
+std::span<const std::uint64_t> GLReplay::get_call_counts() const {
+    return reader_->get_call_counts();
+}
+
+} // namespace glw
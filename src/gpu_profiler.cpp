@@ -0,0 +1,180 @@
+#include "glw/gpu_profiler.hpp"
+#include "glw/glw.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <format>
+
+namespace {
+
+using namespace glw;
+
+constexpr u32 invalid_scope = ~0u;
+
+// Control characters aren't allowed raw inside JSON strings
+void write_json_string(std::ostream& stream, const char* text) {
+    constexpr char hex_digits[] = "0123456789abcdef";
+    stream << '"';
+    for (; *text; ++text) {
+        auto c = static_cast<unsigned char>(*text);
+        if (c < 0x20) {
+            stream << "\\u00" << hex_digits[c >> 4] << hex_digits[c & 0xF];
+            continue;
+        }
+        if (c == '"' || c == '\\') stream << '\\';
+        stream << *text;
+    }
+    stream << '"';
+}
+
+void write_event(std::ostream& stream, const char* name, u32 track, double begin_ms, double end_ms) {
+    stream << ",\n{\"name\":";
+    write_json_string(stream, name);
+    stream << std::format(",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                          track, begin_ms * 1000.0, (end_ms - begin_ms) * 1000.0);
+}
+
+} // namespace
+
+namespace glw {
+
+GpuProfiler::GpuProfiler(const GpuProfilerDescription& desc) :
+    desc_{ desc },
+    queries_(static_cast<size_t>(desc.frame_latency) * desc.max_scopes_per_frame * 2),
+    frames_(desc.frame_latency),
+    start_time_{ std::chrono::steady_clock::now() }
+{
+    cut::ensure(desc.frame_latency > 0 && desc.max_scopes_per_frame > 0, "GPU profiler needs frames and scopes!");
+
+    glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(queries_.size()), queries_.data());
+
+    // GPU timestamps count from an arbitrary origin, line them up with the CPU clock once
+    GLint64 gpu_time = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_time);
+    gpu_offset_ms_ = to_cpu_ms(std::chrono::steady_clock::now()) - gpu_time / 1e6;
+}
+
+GpuProfiler::~GpuProfiler() {
+    glDeleteQueries(static_cast<GLsizei>(queries_.size()), queries_.data());
+}
+
+void GpuProfiler::begin_frame() {
+    auto start = std::chrono::steady_clock::now();
+    u32 latency = desc_.frame_latency;
+
+    // Oldest first, timestamps complete in order so the first unfinished frame ends the search
+    for (u32 age = std::min(frame_index_, latency); age >= 1; --age) {
+        u32 slot = (frame_index_ - age) % latency;
+        if (frames_[slot].pending && !try_resolve(slot)) break;
+    }
+
+    Frame& frame = frames_[frame_index_ % latency];
+    if (frame.pending) {
+        frame.pending = false;
+        stats_.dropped_frames++;
+    }
+    frame.scopes.clear();
+    scope_stack_.clear();
+    recording_ = true;
+
+    stats_.cpu_overhead_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void GpuProfiler::end_frame() {
+    cut::ensure(scope_stack_.empty(), "GPU profiler frame ended inside a scope!");
+
+    Frame& frame = frames_[frame_index_ % desc_.frame_latency];
+    frame.pending = !frame.scopes.empty();
+    recording_ = false;
+    frame_index_++;
+}
+
+void GpuProfiler::begin_scope(const char* name) {
+    auto start = std::chrono::steady_clock::now();
+    u32 slot = frame_index_ % desc_.frame_latency;
+    Frame& frame = frames_[slot];
+
+    if (!recording_ || frame.scopes.size() >= desc_.max_scopes_per_frame) {
+        if (recording_) stats_.dropped_scopes++;
+        scope_stack_.push_back(invalid_scope);
+        return;
+    }
+
+    u32 index = cut::to_u32(frame.scopes.size());
+    glQueryCounter(queries_[(static_cast<size_t>(slot) * desc_.max_scopes_per_frame + index) * 2], GL_TIMESTAMP);
+
+    u32 parent = scope_stack_.empty() ? invalid_scope : scope_stack_.back();
+    frame.scopes.push_back({ name, cut::to_u32(scope_stack_.size()), parent, to_cpu_ms(start), 0.0, 0.0, 0.0 });
+    scope_stack_.push_back(index);
+
+    stats_.cpu_overhead_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void GpuProfiler::end_scope() {
+    auto start = std::chrono::steady_clock::now();
+    cut::ensure(!scope_stack_.empty(), "GPU profiler scope ended without beginning!");
+
+    u32 index = scope_stack_.back();
+    scope_stack_.pop_back();
+    if (index == invalid_scope) return;
+
+    u32 slot = frame_index_ % desc_.frame_latency;
+    glQueryCounter(queries_[(static_cast<size_t>(slot) * desc_.max_scopes_per_frame + index) * 2 + 1], GL_TIMESTAMP);
+    frames_[slot].scopes[index].cpu_end_ms = to_cpu_ms(start);
+
+    stats_.cpu_overhead_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::span<const GpuScope> GpuProfiler::get_latest_frame() const {
+    if (history_.empty()) return {};
+    return history_.back();
+}
+
+void GpuProfiler::write_chrome_trace(std::ostream& stream) const {
+    stream << "{\"traceEvents\":[\n"
+              "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n"
+              "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+    for (const auto& scopes : history_) {
+        for (const auto& scope : scopes) {
+            write_event(stream, scope.name, 0, scope.cpu_begin_ms, scope.cpu_end_ms);
+            write_event(stream, scope.name, 1, scope.gpu_begin_ms, scope.gpu_end_ms);
+        }
+    }
+    stream << "\n]}\n";
+}
+
+double GpuProfiler::to_cpu_ms(std::chrono::steady_clock::time_point time) const {
+    return std::chrono::duration<double, std::milli>(time - start_time_).count();
+}
+
+bool GpuProfiler::try_resolve(u32 slot) {
+    Frame& frame = frames_[slot];
+    const u32* queries = &queries_[static_cast<size_t>(slot) * desc_.max_scopes_per_frame * 2];
+
+    // End of the last root scope is the last timestamp issued in the frame
+    u32 last_root = cut::to_u32(frame.scopes.size()) - 1;
+    while (frame.scopes[last_root].depth != 0) last_root--;
+
+    GLuint64 available = 0;
+    glGetQueryObjectui64v(queries[last_root * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+
+    for (u32 i = 0; i < frame.scopes.size(); ++i) {
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(queries[i * 2], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        frame.scopes[i].gpu_begin_ms = begin / 1e6 + gpu_offset_ms_;
+        frame.scopes[i].gpu_end_ms = end / 1e6 + gpu_offset_ms_;
+    }
+
+    history_.push_back(frame.scopes);
+    while (history_.size() > desc_.max_history_frames) history_.pop_front();
+
+    frame.pending = false;
+    stats_.resolved_frames++;
+    return true;
+}
+
+} // namespace glw
@@ -9,6 +9,17 @@ namespace glw {
 
 using cut::u32;
 
+enum class BufferUsage {
+    Dynamic,
+    Readback,
+    PersistentWrite
+};
+
+enum class BufferBinding {
+    Uniform,
+    ShaderStorage
+};
+
 class Buffer final :
     cut::NonCopyable {
 public:
@@ -18,15 +29,30 @@ public:
     explicit Buffer(std::span<const std::byte> bytes);
 
     /*
-    * Creates writable Buffer with a given size
+    * Creates Buffer with a given size
+    * Dynamic buffers are written from the CPU, Readback buffers are written by the GPU and read back
+    * PersistentWrite buffers stay mapped coherently for their whole lifetime, see get_mapping
     */
-    explicit Buffer(size_t size);
+    explicit Buffer(size_t size, BufferUsage usage = BufferUsage::Dynamic);
 
     void write(std::span<const std::byte> bytes) const;
+    void read(std::span<std::byte> bytes, size_t offset = 0) const;
+
+    /*
+    * Binds part of the Buffer to an indexed uniform or shader storage binding point
+    */
+    void bind_range(BufferBinding binding, u32 index, size_t offset, size_t size) const;
+
+    /*
+    * Mapped bytes of a PersistentWrite Buffer, empty for other usages
+    * Writes are visible to commands issued after them, the caller has to fence regions the GPU still reads
+    */
+    std::span<std::byte> get_mapping() const { return mapping_; }
 
     u32 get_native_handle() const { return handle_.get(); }
 private:
     cut::AutoRelease<u32> handle_;
+    std::span<std::byte> mapping_;
 };
 
 } // namespace glw
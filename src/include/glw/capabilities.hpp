@@ -0,0 +1,52 @@
+#pragma once
+#include "glw/glw.hpp"
+
+#include <cut/types.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+
+struct Capabilities {
+    u32 major_version = 0;
+    u32 minor_version = 0;
+    std::string vendor;
+    std::string renderer;
+    std::string version;
+    std::vector<std::string> extensions; // Sorted
+
+    // Limits
+    u32 max_texture_units = 0;        // Combined over all stages
+    u32 max_fragment_texture_units = 0;
+    u32 max_texture_size = 0;
+    u32 max_array_texture_layers = 0;
+    u32 max_uniform_block_size = 0;
+    u32 max_shader_storage_block_size = 0;
+    u32 uniform_buffer_offset_alignment = 0;
+    u32 shader_storage_buffer_offset_alignment = 0;
+    u32 max_vertex_attribs = 0;
+    u32 max_draw_buffers = 0;
+    u32 max_compiler_threads = 0;     // 0 without parallel_compile
+
+    // Fast paths, each one also has its entry points from FOR_OPTIONAL_OPENGL_FUNCTIONS loaded
+    bool parallel_compile = false;    // KHR_parallel_shader_compile, ShaderStage defers its status check to linking
+    bool multi_draw_indirect = false; // GL 4.3 or ARB_multi_draw_indirect, StaticBatch draws from an indirect buffer
+    bool bindless_textures = false;   // ARB_bindless_texture, see Texture::get_bindless_handle
+
+    bool has_version(u32 major, u32 minor) const { return major_version > major || (major_version == major && minor_version >= minor); }
+    bool has_extension(std::string_view name) const;
+};
+
+/*
+* Queries the current context and loads the optional entry points it supports, init calls it
+* Without fast_paths every fast path stays off and the optional entry points nullptr
+*/
+void detect_capabilities(GLWLoadFunc func, bool fast_paths);
+
+const Capabilities& get_capabilities();
+
+} // namespace glw
@@ -0,0 +1,85 @@
+#pragma once
+#include "glw/culling.hpp"
+#include "glw/frustum.hpp"
+#include "glw/mesh.hpp"
+#include "glw/mesh_optimizer.hpp"
+
+#include <cut/types.hpp>
+
+#include <span>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+using cut::s32;
+using cut::f32;
+
+struct ClusterDescription {
+    u32 max_vertices = 64;
+    u32 max_triangles = 124;
+};
+
+struct ClusterRange {
+    u32 first_index;
+    u32 index_count;
+};
+
+/*
+* Per-cluster bounding sphere and normal cone, one array per component so culling can run several clusters per instruction
+* A cluster is backfacing when dot(center - camera, cone_axis) >= cone_cutoff * length(center - camera) + radius,
+* clusters whose normals span a half space or more have zero axis and cutoff of one
+*/
+struct ClusterBounds {
+    std::vector<f32> center_x;
+    std::vector<f32> center_y;
+    std::vector<f32> center_z;
+    std::vector<f32> radius;
+    std::vector<f32> cone_axis_x;
+    std::vector<f32> cone_axis_y;
+    std::vector<f32> cone_axis_z;
+    std::vector<f32> cone_cutoff;
+
+    u32 get_size() const { return cut::to_u32(radius.size()); }
+};
+
+struct ClusterSet {
+    std::vector<ClusterRange> ranges;
+    ClusterBounds bounds;
+};
+
+/*
+* Splits triangle list into runs of consecutive triangles within description limits
+* Triangles are not reordered, so ranges address the index buffer of a Mesh built from the same indices,
+* running optimize_vertex_cache beforehand keeps clusters compact
+*/
+ClusterSet build_clusters(const MeshSource& source, const ClusterDescription& desc = {});
+
+/*
+* Index ranges of one Mesh, adjacent ranges are merged as they are added
+*/
+class ClusterDrawList final {
+public:
+    void clear() { ranges_.clear(); }
+    void add(const ClusterRange& range);
+
+    /*
+    * Binds mesh and draws all ranges as triangles with a single multi draw
+    */
+    void draw(const Mesh& mesh);
+
+    std::span<const ClusterRange> get_ranges() const { return ranges_; }
+private:
+    std::vector<ClusterRange> ranges_;
+    std::vector<s32> counts_;
+    std::vector<const void*> offsets_;
+};
+
+/*
+* Frustum and backface cone culling, replaces draw_list contents with the visible clusters
+* Returns visible cluster count
+*/
+u32 cull_clusters(const ClusterSet& clusters, const Frustum& frustum, const glm::vec3& camera_position, ClusterDrawList& draw_list,
+                  SimdLevel level = get_supported_simd_level());
+
+} // namespace glw
@@ -0,0 +1,80 @@
+#pragma once
+#include "glw/frustum.hpp"
+#include "glw/thread_pool.hpp"
+
+#include <cut/types.hpp>
+
+#include <glm/glm.hpp>
+
+#include <new>
+#include <span>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+using cut::f32;
+
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+/*
+* Highest level both compiled in and supported by the running CPU
+*/
+SimdLevel get_supported_simd_level();
+
+template<typename T>
+struct SimdAllocator {
+    using value_type = T;
+    static constexpr std::align_val_t alignment{ 32 };
+
+    SimdAllocator() = default;
+    template<typename U> SimdAllocator(const SimdAllocator<U>&) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(::operator new(count * sizeof(T), alignment)); }
+    void deallocate(T* pointer, size_t) { ::operator delete(pointer, alignment); }
+
+    template<typename U> bool operator==(const SimdAllocator<U>&) const { return true; }
+};
+
+/*
+* World space bounding spheres, one 32 byte aligned array per component padded to a multiple of 8
+*/
+class BoundingSpheres final {
+public:
+    static constexpr u32 block_size = 8;
+
+    u32 add(const glm::vec3& center, f32 radius);
+    void set(u32 index, const glm::vec3& center, f32 radius);
+    void clear();
+
+    u32 get_size() const { return size_; }
+    const f32* get_x() const { return x_.data(); }
+    const f32* get_y() const { return y_.data(); }
+    const f32* get_z() const { return z_.data(); }
+    const f32* get_radius() const { return radius_.data(); }
+private:
+    std::vector<f32, SimdAllocator<f32>> x_;
+    std::vector<f32, SimdAllocator<f32>> y_;
+    std::vector<f32, SimdAllocator<f32>> z_;
+    std::vector<f32, SimdAllocator<f32>> radius_;
+    u32 size_ = 0;
+};
+
+/*
+* Replaces visible with ascending indices of spheres intersecting the frustum, returns their count
+*/
+u32 cull_spheres(const BoundingSpheres& spheres, const Frustum& frustum, std::vector<u32>& visible,
+                 SimdLevel level = get_supported_simd_level());
+
+/*
+* Same as above with blocks of spheres spread across thread_pool
+* Culls on the calling thread alone below 65536 spheres or with a single thread pool
+*/
+u32 cull_spheres(const BoundingSpheres& spheres, const Frustum& frustum, std::vector<u32>& visible,
+                 ThreadPool& thread_pool, SimdLevel level = get_supported_simd_level());
+
+} // namespace glw
@@ -0,0 +1,33 @@
+#pragma once
+#include "glw/glw.hpp"
+
+#include <cstdint>
+
+namespace glw {
+
+struct DebugMessageCounts {
+    std::uint64_t high = 0;
+    std::uint64_t medium = 0;
+    std::uint64_t low = 0;
+    std::uint64_t notification = 0;
+    std::uint64_t suppressed = 0; // Over the per message rate limit
+    std::uint64_t dropped = 0;    // Async queue was full
+};
+
+/*
+* Switches how GL debug messages are reported, init sets it from InitOptions
+*/
+void set_debug_output(DebugOutput output);
+DebugOutput get_debug_output();
+
+/*
+* Every message received since init, counted before deduplication
+*/
+DebugMessageCounts get_debug_message_counts();
+
+/*
+* Writes out everything queued in async mode, repeats included
+*/
+void flush_debug_output();
+
+} // namespace glw
@@ -0,0 +1,102 @@
+#pragma once
+#include "glw/buffer.hpp"
+#include "glw/fence.hpp"
+#include "glw/mesh.hpp"
+#include "glw/shader.hpp"
+
+#include <cut/non_copyable.hpp>
+#include <cut/types.hpp>
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+
+/*
+* struct_size is the array stride of the shader side DrawData struct, a multiple of 16 for uniform
+* buffers under std140. Under std430 shader storage it's a multiple of the largest member alignment,
+* which is 16 as soon as the struct holds a vec3, vec4 or matrix
+*/
+struct DrawDataDescription {
+    u32 struct_size = 0;
+    u32 max_draws = 16384; // Per frame
+    u32 frames_in_flight = 3;
+    BufferBinding binding = BufferBinding::ShaderStorage;
+    u32 binding_index = 0;
+};
+
+/*
+* Per-draw structs appended to a persistently mapped ring with one region per frame in flight
+* Each draw passes only its index, as base instance or a single int uniform, see glsl_source
+*/
+class DrawDataBuffer final :
+    cut::NonCopyable {
+public:
+    explicit DrawDataBuffer(const DrawDataDescription& desc);
+
+    /*
+    * Waits until the GPU is done with the next region and binds it, usually returns right away
+    */
+    void begin_frame();
+
+    /*
+    * Copies data into the current region, returns the index to draw with
+    */
+    u32 push(std::span<const std::byte> data);
+
+    template<typename T>
+    u32 push(const T& data) { return push(std::as_bytes(std::span{ &data, 1 })); }
+
+    /*
+    * Fences the current region, call after the last draw reading it
+    */
+    void end_frame();
+
+    u32 get_draw_count() const { return draw_count_; }
+
+    /*
+    * Draws mesh as triangles with draw_index as its base instance, the first LOD level unless given one
+    */
+    static void draw(const Mesh& mesh, u32 draw_index);
+    static void draw(const Mesh& mesh, const LodLevel& lod, u32 draw_index);
+
+    /*
+    * Same draws for shaders built with GLW_DRAW_INDEX_UNIFORM, sets their glw_draw_index uniform first
+    */
+    static void draw(const Shader& shader, const Mesh& mesh, u32 draw_index);
+    static void draw(const Shader& shader, const Mesh& mesh, const LodLevel& lod, u32 draw_index);
+
+    /*
+    * Expects DrawData struct, GLW_DRAW_DATA_BINDING and, for uniform buffers, GLW_DRAW_DATA_UBO
+    * with GLW_MAX_DRAWS to be defined first. glw_draw_index reads gl_BaseInstanceARB, which needs
+    * glsl_extension right after #version and exists in vertex shaders only; defining
+    * GLW_DRAW_INDEX_UNIFORM turns it into a uniform set once per draw by the draw overloads taking the Shader
+    */
+    static constexpr std::string_view glsl_extension = "#extension GL_ARB_shader_draw_parameters : require\n";
+    static constexpr std::string_view glsl_source = R"(
+#ifdef GLW_DRAW_DATA_UBO
+layout(std140, binding = GLW_DRAW_DATA_BINDING) uniform GlwDrawData { DrawData glw_draw_data[GLW_MAX_DRAWS]; };
+#else
+layout(std430, binding = GLW_DRAW_DATA_BINDING) readonly buffer GlwDrawData { DrawData glw_draw_data[]; };
+#endif
+
+#ifdef GLW_DRAW_INDEX_UNIFORM
+uniform int glw_draw_index;
+#else
+#define glw_draw_index gl_BaseInstanceARB
+#endif
+)";
+private:
+    DrawDataDescription desc_;
+    size_t region_size_;
+    Buffer buffer_;
+    std::vector<std::optional<Fence>> fences_;
+    u32 region_ = 0;
+    u32 draw_count_ = 0;
+};
+
+} // namespace glw
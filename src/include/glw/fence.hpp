@@ -0,0 +1,28 @@
+#pragma once
+#include <cut/auto_release.hpp>
+#include <cut/non_copyable.hpp>
+
+namespace glw {
+
+class Fence final :
+    cut::NonCopyable {
+public:
+    /*
+    * Inserts a fence into the command stream
+    */
+    Fence();
+
+    /*
+    * Checks if all commands issued before the fence have completed, never blocks
+    */
+    bool is_signaled() const;
+
+    /*
+    * Blocks until all commands issued before the fence have completed
+    */
+    void wait() const;
+private:
+    cut::AutoRelease<void*> handle_;
+};
+
+} // namespace glw
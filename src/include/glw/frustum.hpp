@@ -0,0 +1,35 @@
+#pragma once
+#include <cut/types.hpp>
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace glw {
+
+using cut::f32;
+
+/*
+* View frustum planes with normals pointing inside, xyz normalized so w is a signed distance
+*/
+struct Frustum {
+    std::array<glm::vec4, 6> planes; // Left, right, bottom, top, near, far
+
+    Frustum() = default;
+
+    /*
+    * Extracts planes from a GL clip space (-w <= z <= w) view projection matrix
+    */
+    explicit Frustum(const glm::mat4& view_projection);
+
+    bool intersects_sphere(const glm::vec3& center, f32 radius) const;
+};
+
+/*
+* True if part of the sphere lies on the inner side of a plane from Frustum, scalar reference for the SIMD kernels
+*/
+inline bool is_sphere_inside(const glm::vec4& plane, f32 x, f32 y, f32 z, f32 radius) {
+    return plane.x * x + plane.y * y + plane.z * z + plane.w >= -radius;
+}
+
+} // namespace glw
@@ -0,0 +1,68 @@
+#pragma once
+#include "glw/glw.hpp"
+
+#include <cut/types.hpp>
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#ifndef GLW_INSTRUMENT_GL
+#define GLW_INSTRUMENT_GL 0
+#endif
+
+namespace glw {
+
+using cut::u32;
+
+enum class GLFunction : u32 {
+#define DECLARE_GL_FUNCTION_ENUM(TYPE, NAME) NAME,
+FOR_ALL_OPENGL_FUNCTIONS(DECLARE_GL_FUNCTION_ENUM)
+#undef DECLARE_GL_FUNCTION_ENUM
+    Count
+};
+
+constexpr u32 gl_function_count = static_cast<u32>(GLFunction::Count);
+
+enum class GLInstrumentMode {
+    Off,         // GL pointers call the driver directly
+    Count,       // Calls and upload bytes
+    CountAndTime // Also CPU time spent inside each call
+};
+
+struct GLCallStats {
+    std::uint64_t calls = 0;
+    std::uint64_t time_ns = 0;
+    std::uint64_t upload_bytes = 0; // Buffer and texture data handed to the driver
+};
+
+struct GLFrameStats {
+    std::uint64_t frame = 0;
+    std::array<GLCallStats, gl_function_count> functions{};
+    GLCallStats total;
+};
+
+const char* get_gl_function_name(GLFunction function);
+
+/*
+* Bytes per pixel of client pixel data in format and type, 0 for unknown combinations
+*/
+u32 to_gl_pixel_size(GLenum format, GLenum type);
+
+/*
+* Swaps the GL pointers between the loaded entry points and counting thunks, call after init
+* Only available when built with GLW_INSTRUMENT_GL, Off never costs anything per call
+*/
+void set_gl_instrument_mode(GLInstrumentMode mode);
+GLInstrumentMode get_gl_instrument_mode();
+
+/*
+* Closes the frame being counted, its stats become get_gl_frame_stats()
+*/
+void end_gl_stats_frame();
+const GLFrameStats& get_gl_frame_stats();
+
+void write_gl_stats_text(std::ostream& stream, const GLFrameStats& stats);
+void write_gl_stats_json(std::ostream& stream, const GLFrameStats& stats);
+
+} // namespace glw
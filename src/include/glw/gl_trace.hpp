@@ -0,0 +1,76 @@
+#pragma once
+#include "glw/gl_instrument.hpp"
+
+#include <cut/non_copyable.hpp>
+#include <cut/types.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace glw {
+
+using cut::u32;
+
+class GLTraceWriter;
+class GLTraceReader;
+
+/*
+* Records every GL call with its arguments into a binary trace until destroyed
+* Buffer, texture and persistently mapped data is stored once per content hash and size
+* Start it before creating the objects the trace should replay with, only available with GLW_INSTRUMENT_GL
+* Set the instrument mode before starting it, the two can't change places while it runs
+*/
+class GLCapture final :
+    cut::NonCopyable {
+public:
+    explicit GLCapture(const std::filesystem::path& path);
+    ~GLCapture();
+
+    /*
+    * Closes the frame, persistently mapped ranges written since the last frame get stored
+    */
+    void end_frame();
+
+    u32 get_frame_count() const;
+    std::uint64_t get_blob_bytes() const; // Unique payload bytes written so far
+private:
+    std::unique_ptr<GLTraceWriter> writer_;
+};
+
+/*
+* Instrument mode changes and init throw while a capture runs, its thunks sit on top of theirs
+*/
+bool is_gl_capture_active();
+
+struct GLReplayFrame {
+    u32 calls = 0;
+    double cpu_ms = 0.0;
+};
+
+/*
+* Plays a GLCapture trace back on the current context, object names get remapped to fresh ones
+*/
+class GLReplay final :
+    cut::NonCopyable {
+public:
+    explicit GLReplay(const std::filesystem::path& path);
+    ~GLReplay();
+
+    /*
+    * Issues the calls of the next frame, false once the trace is over
+    */
+    bool replay_frame();
+
+    const GLReplayFrame& get_last_frame() const;
+
+    /*
+    * Calls per entry point over all replayed frames, indexed by GLFunction
+    */
+    std::span<const std::uint64_t> get_call_counts() const;
+private:
+    std::unique_ptr<GLTraceReader> reader_;
+};
+
+} // namespace glw
@@ -10,81 +10,122 @@
 
 #include <GL/glcorearb.h>
 
-#define FOR_OPENGL_FUNCTIONS(DO)                                            \
-    DO(PFNGLATTACHSHADERPROC,                glAttachShader)                \
-    DO(PFNGLBINDBUFFERBASEPROC,              glBindBufferBase)              \
-    DO(PFNGLBINDFRAMEBUFFERPROC,             glBindFramebuffer)             \
-    DO(PFNGLBINDSAMPLERPROC,                 glBindSampler)                 \
-    DO(PFNGLBINDTEXTUREUNITPROC,             glBindTextureUnit)             \
-    DO(PFNGLBINDVERTEXARRAYPROC,             glBindVertexArray)             \
-    DO(PFNGLBLITNAMEDFRAMEBUFFERPROC,        glBlitNamedFramebuffer)        \
-    DO(PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC, glCheckNamedFramebufferStatus) \
-    DO(PFNGLCLEARPROC,                       glClear)                       \
-    DO(PFNGLCLEARCOLORPROC,                  glClearColor)                  \
-    DO(PFNGLCLEARNAMEDFRAMEBUFFERFVPROC,     glClearNamedFramebufferfv)     \
-    DO(PFNGLCLEARNAMEDFRAMEBUFFERIVPROC,     glClearNamedFramebufferiv)     \
-    DO(PFNGLCOMPILESHADERPROC,               glCompileShader)               \
-    DO(PFNGLCREATEBUFFERSPROC,               glCreateBuffers)               \
-    DO(PFNGLCREATEFRAMEBUFFERSPROC,          glCreateFramebuffers)          \
-    DO(PFNGLCREATEPROGRAMPROC,               glCreateProgram)               \
-    DO(PFNGLCREATESAMPLERSPROC,              glCreateSamplers)              \
-    DO(PFNGLCREATESHADERPROC,                glCreateShader)                \
-    DO(PFNGLCREATETEXTURESPROC,              glCreateTextures)              \
-    DO(PFNGLCREATEVERTEXARRAYSPROC,          glCreateVertexArrays)          \
-    DO(PFNGLDEBUGMESSAGECALLBACKPROC,        glDebugMessageCallback)        \
-    DO(PFNGLDEPTHFUNCPROC,                   glDepthFunc)                   \
-    DO(PFNGLDEPTHMASKPROC,                   glDepthMask)                   \
-    DO(PFNGLDELETEBUFFERSPROC,               glDeleteBuffers)               \
-    DO(PFNGLDELETEFRAMEBUFFERSPROC,          glDeleteFramebuffers)          \
-    DO(PFNGLDELETEPROGRAMPROC,               glDeleteProgram)               \
-    DO(PFNGLDELETESAMPLERSPROC,              glDeleteSamplers)              \
-    DO(PFNGLDELETESHADERPROC,                glDeleteShader)                \
-    DO(PFNGLDELETETEXTURESPROC,              glDeleteTextures)              \
-    DO(PFNGLDELETEVERTEXARRAYSPROC,          glDeleteVertexArrays)          \
-    DO(PFNGLDETACHSHADERPROC,                glDetachShader)                \
-    DO(PFNGLDISABLEPROC,                     glDisable)                     \
-    DO(PFNGLDRAWARRAYSPROC,                  glDrawArrays)                  \
-    DO(PFNGLDRAWELEMENTSPROC,                glDrawElements)                \
-    DO(PFNGLENABLEPROC,                      glEnable)                      \
-    DO(PFNGLENABLEVERTEXARRAYATTRIBPROC,     glEnableVertexArrayAttrib)     \
-    DO(PFNGLGENERATETEXTUREMIPMAPPROC,       glGenerateTextureMipmap)       \
-    DO(PFNGLGETACTIVEUNIFORMPROC,            glGetActiveUniform)            \
-    DO(PFNGLGETFLOATVPROC,                   glGetFloatv)                   \
-    DO(PFNGLGETINTEGERVPROC,                 glGetIntegerv)                 \
-    DO(PFNGLGETPROGRAMINFOLOGPROC,           glGetProgramInfoLog)           \
-    DO(PFNGLGETPROGRAMIVPROC,                glGetProgramiv)                \
-    DO(PFNGLGETSHADERINFOLOGPROC,            glGetShaderInfoLog)            \
-    DO(PFNGLGETSHADERIVPROC,                 glGetShaderiv)                 \
-    DO(PFNGLGETSTRINGIPROC,                  glGetStringi)                  \
-    DO(PFNGLGETUNIFORMLOCATIONPROC,          glGetUniformLocation)          \
-    DO(PFNGLLINEWIDTHPROC,                   glLineWidth)                   \
-    DO(PFNGLLINKPROGRAMPROC,                 glLinkProgram)                 \
-    DO(PFNGLNAMEDBUFFERSUBDATAPROC,          glNamedBufferSubData)          \
-    DO(PFNGLNAMEDBUFFERSTORAGEPROC,          glNamedBufferStorage)          \
-    DO(PFNGLNAMEDFRAMEBUFFERDRAWBUFFERSPROC, glNamedFramebufferDrawBuffers) \
-    DO(PFNGLNAMEDFRAMEBUFFERTEXTUREPROC,     glNamedFramebufferTexture)     \
-    DO(PFNGLPROGRAMUNIFORM1FPROC,            glProgramUniform1f)            \
-    DO(PFNGLPROGRAMUNIFORM1IPROC,            glProgramUniform1i)            \
-    DO(PFNGLPROGRAMUNIFORM3FPROC,            glProgramUniform3f)            \
-    DO(PFNGLPROGRAMUNIFORM3FVPROC,           glProgramUniform3fv)           \
-    DO(PFNGLPROGRAMUNIFORMMATRIX3FVPROC,     glProgramUniformMatrix3fv)     \
-    DO(PFNGLPROGRAMUNIFORMMATRIX4FVPROC,     glProgramUniformMatrix4fv)     \
-    DO(PFNGLSAMPLERPARAMETERFPROC,           glSamplerParameterf)           \
-    DO(PFNGLSAMPLERPARAMETERIPROC,           glSamplerParameteri)           \
-    DO(PFNGLSHADERSOURCEPROC,                glShaderSource)                \
-    DO(PFNGLTEXTURESTORAGE2DPROC,            glTextureStorage2D)            \
-    DO(PFNGLTEXTURESUBIMAGE2DPROC,           glTextureSubImage2D)           \
-    DO(PFNGLTEXTURESUBIMAGE3DPROC,           glTextureSubImage3D)           \
-    DO(PFNGLUSEPROGRAMPROC,                  glUseProgram)                  \
-    DO(PFNGLVERTEXARRAYATTRIBBINDINGPROC,    glVertexArrayAttribBinding)    \
-    DO(PFNGLVERTEXARRAYATTRIBFORMATPROC,     glVertexArrayAttribFormat)     \
-    DO(PFNGLVERTEXARRAYATTRIBIFORMATPROC,    glVertexArrayAttribIFormat)    \
-    DO(PFNGLVERTEXARRAYELEMENTBUFFERPROC,    glVertexArrayElementBuffer)    \
-    DO(PFNGLVERTEXARRAYVERTEXBUFFERPROC,     glVertexArrayVertexBuffer)     \
-    DO(PFNGLVIEWPORTPROC,                    glViewport)
+#define FOR_OPENGL_FUNCTIONS(DO)                                                        \
+    DO(PFNGLATTACHSHADERPROC,                      glAttachShader)                      \
+    DO(PFNGLBEGINCONDITIONALRENDERPROC,            glBeginConditionalRender)            \
+    DO(PFNGLBEGINQUERYPROC,                        glBeginQuery)                        \
+    DO(PFNGLBINDBUFFERPROC,                        glBindBuffer)                        \
+    DO(PFNGLBINDBUFFERBASEPROC,                    glBindBufferBase)                    \
+    DO(PFNGLBINDBUFFERRANGEPROC,                   glBindBufferRange)                   \
+    DO(PFNGLBINDFRAMEBUFFERPROC,                   glBindFramebuffer)                   \
+    DO(PFNGLBINDSAMPLERPROC,                       glBindSampler)                       \
+    DO(PFNGLBINDTEXTUREUNITPROC,                   glBindTextureUnit)                   \
+    DO(PFNGLBINDVERTEXARRAYPROC,                   glBindVertexArray)                   \
+    DO(PFNGLBLENDFUNCPROC,                         glBlendFunc)                         \
+    DO(PFNGLBLENDFUNCSEPARATEPROC,                 glBlendFuncSeparate)                 \
+    DO(PFNGLBLITNAMEDFRAMEBUFFERPROC,              glBlitNamedFramebuffer)              \
+    DO(PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC,       glCheckNamedFramebufferStatus)       \
+    DO(PFNGLCLEARPROC,                             glClear)                             \
+    DO(PFNGLCLEARCOLORPROC,                        glClearColor)                        \
+    DO(PFNGLCLEARNAMEDFRAMEBUFFERFVPROC,           glClearNamedFramebufferfv)           \
+    DO(PFNGLCLEARNAMEDFRAMEBUFFERIVPROC,           glClearNamedFramebufferiv)           \
+    DO(PFNGLCLEARTEXIMAGEPROC,                     glClearTexImage)                     \
+    DO(PFNGLCLIENTWAITSYNCPROC,                    glClientWaitSync)                    \
+    DO(PFNGLCOLORMASKPROC,                         glColorMask)                         \
+    DO(PFNGLCOMPILESHADERPROC,                     glCompileShader)                     \
+    DO(PFNGLCOPYIMAGESUBDATAPROC,                  glCopyImageSubData)                  \
+    DO(PFNGLCREATEBUFFERSPROC,                     glCreateBuffers)                     \
+    DO(PFNGLCREATEFRAMEBUFFERSPROC,                glCreateFramebuffers)                \
+    DO(PFNGLCREATEPROGRAMPROC,                     glCreateProgram)                     \
+    DO(PFNGLCREATEQUERIESPROC,                     glCreateQueries)                     \
+    DO(PFNGLCREATESAMPLERSPROC,                    glCreateSamplers)                    \
+    DO(PFNGLCREATESHADERPROC,                      glCreateShader)                      \
+    DO(PFNGLCREATETEXTURESPROC,                    glCreateTextures)                    \
+    DO(PFNGLCREATEVERTEXARRAYSPROC,                glCreateVertexArrays)                \
+    DO(PFNGLDEBUGMESSAGECALLBACKPROC,              glDebugMessageCallback)              \
+    DO(PFNGLDEPTHFUNCPROC,                         glDepthFunc)                         \
+    DO(PFNGLDEPTHMASKPROC,                         glDepthMask)                         \
+    DO(PFNGLDELETEBUFFERSPROC,                     glDeleteBuffers)                     \
+    DO(PFNGLDELETEFRAMEBUFFERSPROC,                glDeleteFramebuffers)                \
+    DO(PFNGLDELETEPROGRAMPROC,                     glDeleteProgram)                     \
+    DO(PFNGLDELETEQUERIESPROC,                     glDeleteQueries)                     \
+    DO(PFNGLDELETESAMPLERSPROC,                    glDeleteSamplers)                    \
+    DO(PFNGLDELETESHADERPROC,                      glDeleteShader)                      \
+    DO(PFNGLDELETESYNCPROC,                        glDeleteSync)                        \
+    DO(PFNGLDELETETEXTURESPROC,                    glDeleteTextures)                    \
+    DO(PFNGLDELETEVERTEXARRAYSPROC,                glDeleteVertexArrays)                \
+    DO(PFNGLDETACHSHADERPROC,                      glDetachShader)                      \
+    DO(PFNGLDISABLEPROC,                           glDisable)                           \
+    DO(PFNGLDRAWARRAYSPROC,                        glDrawArrays)                        \
+    DO(PFNGLDRAWELEMENTSPROC,                      glDrawElements)                      \
+    DO(PFNGLDRAWELEMENTSBASEVERTEXPROC,            glDrawElementsBaseVertex)            \
+    DO(PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC, glDrawElementsInstancedBaseInstance) \
+    DO(PFNGLENABLEPROC,                            glEnable)                            \
+    DO(PFNGLENABLEVERTEXARRAYATTRIBPROC,           glEnableVertexArrayAttrib)           \
+    DO(PFNGLENDCONDITIONALRENDERPROC,              glEndConditionalRender)              \
+    DO(PFNGLENDQUERYPROC,                          glEndQuery)                          \
+    DO(PFNGLFENCESYNCPROC,                         glFenceSync)                         \
+    DO(PFNGLGENERATETEXTUREMIPMAPPROC,             glGenerateTextureMipmap)             \
+    DO(PFNGLGETACTIVEUNIFORMPROC,                  glGetActiveUniform)                  \
+    DO(PFNGLGETFLOATVPROC,                         glGetFloatv)                         \
+    DO(PFNGLGETINTEGER64VPROC,                     glGetInteger64v)                     \
+    DO(PFNGLGETINTEGERVPROC,                       glGetIntegerv)                       \
+    DO(PFNGLGETNAMEDBUFFERSUBDATAPROC,             glGetNamedBufferSubData)             \
+    DO(PFNGLGETPROGRAMINFOLOGPROC,                 glGetProgramInfoLog)                 \
+    DO(PFNGLGETPROGRAMIVPROC,                      glGetProgramiv)                      \
+    DO(PFNGLGETQUERYOBJECTUI64VPROC,               glGetQueryObjectui64v)               \
+    DO(PFNGLGETSHADERINFOLOGPROC,                  glGetShaderInfoLog)                  \
+    DO(PFNGLGETSHADERIVPROC,                       glGetShaderiv)                       \
+    DO(PFNGLGETSTRINGPROC,                         glGetString)                         \
+    DO(PFNGLGETSTRINGIPROC,                        glGetStringi)                        \
+    DO(PFNGLGETTEXTUREIMAGEPROC,                   glGetTextureImage)                   \
+    DO(PFNGLGETUNIFORMLOCATIONPROC,                glGetUniformLocation)                \
+    DO(PFNGLISENABLEDPROC,                         glIsEnabled)                         \
+    DO(PFNGLLINEWIDTHPROC,                         glLineWidth)                         \
+    DO(PFNGLLINKPROGRAMPROC,                       glLinkProgram)                       \
+    DO(PFNGLMAPNAMEDBUFFERRANGEPROC,               glMapNamedBufferRange)               \
+    DO(PFNGLMULTIDRAWELEMENTSPROC,                 glMultiDrawElements)                 \
+    DO(PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC,       glMultiDrawElementsBaseVertex)       \
+    DO(PFNGLNAMEDBUFFERSUBDATAPROC,                glNamedBufferSubData)                \
+    DO(PFNGLNAMEDBUFFERSTORAGEPROC,                glNamedBufferStorage)                \
+    DO(PFNGLNAMEDFRAMEBUFFERDRAWBUFFERSPROC,       glNamedFramebufferDrawBuffers)       \
+    DO(PFNGLNAMEDFRAMEBUFFERTEXTUREPROC,           glNamedFramebufferTexture)           \
+    DO(PFNGLPIXELSTOREIPROC,                       glPixelStorei)                       \
+    DO(PFNGLPROGRAMUNIFORM1FPROC,                  glProgramUniform1f)                  \
+    DO(PFNGLPROGRAMUNIFORM1IPROC,                  glProgramUniform1i)                  \
+    DO(PFNGLPROGRAMUNIFORM3FPROC,                  glProgramUniform3f)                  \
+    DO(PFNGLPROGRAMUNIFORM3FVPROC,                 glProgramUniform3fv)                 \
+    DO(PFNGLPROGRAMUNIFORMMATRIX3FVPROC,           glProgramUniformMatrix3fv)           \
+    DO(PFNGLPROGRAMUNIFORMMATRIX4FVPROC,           glProgramUniformMatrix4fv)           \
+    DO(PFNGLQUERYCOUNTERPROC,                      glQueryCounter)                      \
+    DO(PFNGLSAMPLERPARAMETERFPROC,                 glSamplerParameterf)                 \
+    DO(PFNGLSAMPLERPARAMETERIPROC,                 glSamplerParameteri)                 \
+    DO(PFNGLSHADERSOURCEPROC,                      glShaderSource)                      \
+    DO(PFNGLTEXTURESTORAGE2DPROC,                  glTextureStorage2D)                  \
+    DO(PFNGLTEXTURESTORAGE3DPROC,                  glTextureStorage3D)                  \
+    DO(PFNGLTEXTURESUBIMAGE2DPROC,                 glTextureSubImage2D)                 \
+    DO(PFNGLTEXTURESUBIMAGE3DPROC,                 glTextureSubImage3D)                 \
+    DO(PFNGLUSEPROGRAMPROC,                        glUseProgram)                        \
+    DO(PFNGLVERTEXARRAYATTRIBBINDINGPROC,          glVertexArrayAttribBinding)          \
+    DO(PFNGLVERTEXARRAYATTRIBFORMATPROC,           glVertexArrayAttribFormat)           \
+    DO(PFNGLVERTEXARRAYATTRIBIFORMATPROC,          glVertexArrayAttribIFormat)          \
+    DO(PFNGLVERTEXARRAYELEMENTBUFFERPROC,          glVertexArrayElementBuffer)          \
+    DO(PFNGLVERTEXARRAYVERTEXBUFFERPROC,           glVertexArrayVertexBuffer)           \
+    DO(PFNGLVIEWPORTPROC,                          glViewport)
+
+// Fast paths, loaded only when the version or extension providing them is present, nullptr otherwise
+#define FOR_OPTIONAL_OPENGL_FUNCTIONS(DO)                                               \
+    DO(PFNGLGETTEXTUREHANDLEARBPROC,               glGetTextureHandleARB)               \
+    DO(PFNGLMAKETEXTUREHANDLERESIDENTARBPROC,      glMakeTextureHandleResidentARB)      \
+    DO(PFNGLMAXSHADERCOMPILERTHREADSKHRPROC,       glMaxShaderCompilerThreadsKHR)       \
+    DO(PFNGLMULTIDRAWELEMENTSINDIRECTPROC,         glMultiDrawElementsIndirect)
+
+#define FOR_ALL_OPENGL_FUNCTIONS(DO) \
+    FOR_OPENGL_FUNCTIONS(DO)         \
+    FOR_OPTIONAL_OPENGL_FUNCTIONS(DO)
 
 #define DECLARE_OPENGL_FUNCTION(TYPE, NAME) inline TYPE NAME = nullptr;
-FOR_OPENGL_FUNCTIONS(DECLARE_OPENGL_FUNCTION)
+FOR_ALL_OPENGL_FUNCTIONS(DECLARE_OPENGL_FUNCTION)
 #undef DECLARE_OPENGL_FUNCTION
 
 namespace glw {
@@ -92,6 +133,17 @@ namespace glw {
 typedef void (*GLWApiProc)(void);
 typedef GLWApiProc(*GLWLoadFunc)(const char* name);
 
-void init(GLWLoadFunc func);
+enum class DebugOutput {
+    Off,
+    Async,      // Callback only queues, messages get deduplicated and written on a background thread
+    Synchronous // Written from inside the offending GL call, so a debugger has the call stack
+};
+
+struct InitOptions {
+    DebugOutput debug_output = DebugOutput::Synchronous;
+    bool fast_paths = true; // Off keeps every subsystem on the baseline GL 4.5 path, see Capabilities
+};
+
+void init(GLWLoadFunc func, const InitOptions& options = {});
 
 } // namespace glw
@@ -0,0 +1,115 @@
+#pragma once
+#include <cut/non_copyable.hpp>
+#include <cut/types.hpp>
+
+#include <chrono>
+#include <deque>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#ifndef GLW_GPU_PROFILER
+#define GLW_GPU_PROFILER 1
+#endif
+
+namespace glw {
+
+using cut::u32;
+
+struct GpuProfilerDescription {
+    u32 max_scopes_per_frame = 256;
+    u32 frame_latency = 4;        // Frames between issuing timestamps and reading them back
+    u32 max_history_frames = 300; // Resolved frames kept for trace export
+};
+
+/*
+* Timed scope of one frame, scopes are stored in pre-order so children follow their parent
+* Times are milliseconds since profiler creation, GPU ones shifted onto the CPU clock
+*/
+struct GpuScope {
+    const char* name;
+    u32 depth;
+    u32 parent;
+    double cpu_begin_ms;
+    double cpu_end_ms;
+    double gpu_begin_ms;
+    double gpu_end_ms;
+
+    double get_gpu_duration_ms() const { return gpu_end_ms - gpu_begin_ms; }
+};
+
+struct GpuProfilerStats {
+    u32 resolved_frames = 0;
+    u32 dropped_frames = 0; // Not ready by the time their queries had to be reused
+    u32 dropped_scopes = 0; // Over max_scopes_per_frame
+    double cpu_overhead_ms = 0.0;
+};
+
+/*
+* Nested GPU timestamp scopes from a pooled ring of queries, read back frame_latency frames later
+* Results that aren't available by then are dropped, so reading never stalls the pipeline
+*/
+class GpuProfiler final :
+    cut::NonCopyable {
+public:
+    class Scope final :
+        cut::NonCopyable {
+    public:
+        Scope(GpuProfiler& profiler, const char* name) : profiler_{ profiler } { profiler_.begin_scope(name); }
+        ~Scope() { profiler_.end_scope(); }
+    private:
+        GpuProfiler& profiler_;
+    };
+
+    explicit GpuProfiler(const GpuProfilerDescription& desc = {});
+    ~GpuProfiler();
+
+    /*
+    * Resolves finished frames and starts recording a new one
+    */
+    void begin_frame();
+    void end_frame();
+
+    /*
+    * Name has to outlive the profiler, string literals are expected
+    */
+    void begin_scope(const char* name);
+    void end_scope();
+
+    std::span<const GpuScope> get_latest_frame() const;
+    const GpuProfilerStats& get_stats() const { return stats_; }
+
+    /*
+    * Writes resolved frames as Chrome trace events, CPU and GPU scopes on separate tracks
+    */
+    void write_chrome_trace(std::ostream& stream) const;
+private:
+    struct Frame {
+        std::vector<GpuScope> scopes;
+        bool pending = false;
+    };
+
+    double to_cpu_ms(std::chrono::steady_clock::time_point time) const;
+    bool try_resolve(u32 slot);
+
+    GpuProfilerDescription desc_;
+    std::vector<u32> queries_;
+    std::vector<Frame> frames_;
+    std::vector<u32> scope_stack_;
+    std::deque<std::vector<GpuScope>> history_;
+    std::chrono::steady_clock::time_point start_time_;
+    double gpu_offset_ms_ = 0.0;
+    u32 frame_index_ = 0;
+    bool recording_ = false;
+    GpuProfilerStats stats_;
+};
+
+} // namespace glw
+
+#if GLW_GPU_PROFILER
+#define GLW_GPU_SCOPE_CONCAT_IMPL(a, b) a##b
+#define GLW_GPU_SCOPE_CONCAT(a, b) GLW_GPU_SCOPE_CONCAT_IMPL(a, b)
+#define GLW_GPU_SCOPE(profiler, name) ::glw::GpuProfiler::Scope GLW_GPU_SCOPE_CONCAT(glw_gpu_scope_, __COUNTER__){ profiler, name }
+#else
+#define GLW_GPU_SCOPE(profiler, name) ((void)0)
+#endif
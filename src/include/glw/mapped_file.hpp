@@ -0,0 +1,24 @@
+#pragma once
+#include <cut/non_copyable.hpp>
+
+#include <filesystem>
+#include <span>
+
+namespace glw {
+
+/*
+* Read-only memory mapping of a whole file, pages are loaded by the OS on first access
+*/
+class MappedFile final :
+    cut::NonCopyable {
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    std::span<const std::byte> get_bytes() const { return { data_, size_ }; }
+private:
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace glw
@@ -1,12 +1,26 @@
 #pragma once
 #include "glw/buffer.hpp"
+#include "glw/mesh_lod.hpp"
 #include "glw/vertex_array.hpp"
 
 #include <cut/types.hpp>
 
+#include <array>
+#include <optional>
+#include <vector>
+
 namespace glw {
 
 using cut::u32;
+using cut::f32;
+
+/*
+* Vertex buffer contents with the format of its attributes
+*/
+struct VertexStream {
+    std::span<const std::byte> vertices;
+    VertexFormat format;
+};
 
 class Mesh :
     cut::NonCopyable {
@@ -17,18 +31,60 @@ public:
     Mesh(ByteView vertices, ByteView indices, IndexType index_type,
          std::initializer_list<VertexArray::DataType> vertex_layout);
 
-    void bind() const { vao_.bind(); }
+    /*
+    * Creates Mesh sharing VertexArray with every other Mesh of the same vertex format
+    * Binding such Mesh rebinds only its vertex and index buffers
+    */
+    Mesh(ByteView vertices, ByteView indices, IndexType index_type,
+         const VertexFormat& vertex_format, VertexArrayCache& vertex_array_cache);
+
+    /*
+    * Creates Mesh reading attributes from several vertex buffers, stream i is bound at binding i
+    * Keeping positions alone in the first stream lets depth only passes skip fetching the rest
+    */
+    Mesh(std::span<const VertexStream> streams, ByteView indices, IndexType index_type,
+         VertexArrayCache& vertex_array_cache);
+
+    void bind() const;
+
+    /*
+    * Binds VertexArray reading only the first stream, or only the first attribute of an interleaved Mesh
+    * An interleaved Mesh still binds its buffer at the full stride, so fetches pull in whole vertices and
+    * only the attribute setup is saved, use the streams constructor where depth passes matter
+    * Meshes owning their VertexArray bind all attributes
+    */
+    void bind_positions() const;
+
+    /*
+    * Uses ranges of the index buffer as LOD levels, like the back to back levels of a LodChain
+    * Without them the whole index buffer is the only level
+    */
+    void set_lods(std::span<const LodLevel> lods);
+    std::span<const LodLevel> get_lods() const { return lods_; }
+
+    /*
+    * Coarsest level whose error projected to the screen stays under threshold_pixels, see select_lod
+    */
+    const LodLevel& get_lod(f32 distance, f32 fov_y, f32 viewport_height, f32 threshold_pixels = 1.0f) const;
 
-    u32 get_index_count() const { return index_count_; }
+    /*
+    * Indices of the first level, which is drawn when no LOD is picked
+    */
+    u32 get_index_count() const { return lods_.front().index_count; }
     IndexType get_index_type() const { return index_type_; }
 
     static u32 to_gl_enum(IndexType type);
+    static u32 to_size(IndexType type);
 private:
-    glw::Buffer vbo_;
+    std::array<std::optional<glw::Buffer>, max_vertex_streams> vbos_;
     glw::Buffer ibo_;
-    glw::VertexArray vao_;
-    u32 index_count_;
+    std::optional<glw::VertexArray> vao_;
+    glw::VertexArray* shared_vao_ = nullptr;
+    glw::VertexArray* position_vao_ = nullptr;
+    u32 stream_count_ = 1;
+    u32 index_count_; // Whole index buffer, over all LOD levels
     IndexType index_type_;
+    std::vector<LodLevel> lods_;
 };
 
 } // namespace glw
@@ -0,0 +1,66 @@
+#pragma once
+#include "glw/mapped_file.hpp"
+#include "glw/mesh.hpp"
+#include "glw/mesh_lod.hpp"
+#include "glw/vertex_array.hpp"
+
+#include <cut/non_copyable.hpp>
+#include <cut/types.hpp>
+
+#include <glm/glm.hpp>
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+
+/*
+* Interleaved vertices with their layout, indices and optional LOD ranges into them
+* Scales and offsets dequantize normalized positions and UVs, see QuantizedMesh
+*/
+struct MeshFileData {
+    std::span<const std::byte> vertices;
+    u32 stride;
+    std::span<const VertexAttribute> attributes;
+    std::span<const std::byte> indices;
+    Mesh::IndexType index_type;
+    std::span<const LodLevel> lods;
+    glm::vec3 position_scale{ 1.0f };
+    glm::vec3 position_offset{ 0.0f };
+    glm::vec2 uv_scale{ 1.0f };
+    glm::vec2 uv_offset{ 0.0f };
+};
+
+/*
+* Writes header, attributes and LOD ranges followed by vertex and index blobs aligned to 64 bytes
+* Everything is stored in host byte order, which is little endian on every supported platform
+*/
+void write_mesh_file(const std::filesystem::path& path, const MeshFileData& data);
+
+/*
+* Memory mapped mesh file, data spans point into the mapping and live as long as MeshFile
+* Blobs, attributes and LOD ranges are checked against each other when opening, before anything is uploaded
+*/
+class MeshFile final :
+    cut::NonCopyable {
+public:
+    explicit MeshFile(const std::filesystem::path& path);
+
+    const MeshFileData& get_data() const { return data_; }
+    VertexFormat get_format() const;
+
+    /*
+    * Uploads vertex and index blobs into Buffer storage straight from the mapped pages, LOD ranges go to Mesh::set_lods
+    */
+    Mesh create_mesh(VertexArrayCache& vertex_array_cache) const;
+private:
+    MappedFile file_;
+    std::vector<VertexAttribute> attributes_;
+    std::vector<LodLevel> lods_;
+    MeshFileData data_;
+};
+
+} // namespace glw
@@ -0,0 +1,69 @@
+#pragma once
+#include "glw/thread_pool.hpp"
+
+#include <cut/types.hpp>
+
+#include <span>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+using cut::f32;
+
+/*
+* Float vertex attribute whose change along a collapse is added to the collapse cost
+*/
+struct LodAttribute {
+    u32 offset;
+    u32 count;
+    f32 weight = 1.0f;
+};
+
+struct LodSource {
+    std::span<const std::byte> vertices;
+    std::span<const u32> indices;
+    u32 stride;
+    u32 position_offset = 0;
+    std::span<const LodAttribute> attributes;
+};
+
+struct LodDescription {
+    u32 max_levels = 8;
+    f32 reduction = 0.5f;         // Target index count of each level relative to the previous one
+    f32 max_relative_error = 0.05f; // Relative to mesh bounding box diagonal
+};
+
+/*
+* Range of the shared index buffer with geometric error in object space units
+*/
+struct LodLevel {
+    u32 first_index;
+    u32 index_count;
+    f32 error;
+};
+
+struct LodChain {
+    std::vector<u32> indices;
+    std::vector<LodLevel> levels;
+};
+
+/*
+* Quadric error metric edge collapse onto existing vertices, border and attribute seam vertices stay locked
+* Returns simplified triangle list, never longer than target_index_count unless target_error was reached
+*/
+std::vector<u32> simplify(const LodSource& source, std::span<const u32> indices,
+                          u32 target_index_count, f32 target_error, f32* result_error = nullptr);
+
+/*
+* Builds progressively simplified levels stored back to back in one index list, level 0 being the source
+*/
+LodChain build_lod_chain(const LodSource& source, const LodDescription& desc = {});
+std::vector<LodChain> build_lod_chains(std::span<const LodSource> sources, const LodDescription& desc, ThreadPool& thread_pool);
+
+/*
+* Picks coarsest level whose error projected to the screen stays under threshold_pixels
+*/
+u32 select_lod(std::span<const LodLevel> levels, f32 distance, f32 fov_y, f32 viewport_height, f32 threshold_pixels = 1.0f);
+
+} // namespace glw
@@ -0,0 +1,71 @@
+#pragma once
+#include "glw/mesh.hpp"
+#include "glw/thread_pool.hpp"
+
+#include <cut/types.hpp>
+
+#include <span>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+using cut::f32;
+
+struct VertexCacheStats {
+    f32 acmr = 0.0f; // Average cache miss ratio, transformed vertices per triangle
+    f32 atvr = 0.0f; // Average transformed vertex ratio, transformed vertices per unique vertex
+};
+
+/*
+* Simulates a FIFO post-transform cache of a given size over a triangle list
+*/
+VertexCacheStats analyze_vertex_cache(std::span<const u32> indices, u32 vertex_count, u32 cache_size = 16);
+
+/*
+* Reorders triangles for post-transform cache locality (Forsyth)
+*/
+void optimize_vertex_cache(std::span<u32> indices, u32 vertex_count);
+
+/*
+* Reorders clusters of cache optimized triangles so outward facing ones come first
+* Positions are F32_3 at position_offset inside each vertex
+*/
+void optimize_overdraw(std::span<u32> indices, std::span<const std::byte> vertices, u32 stride, u32 position_offset);
+
+/*
+* Reorders vertices in order of first use by the indices and drops unreferenced ones
+* Returns new vertex count, vertices past it are left unspecified
+*/
+u32 optimize_vertex_fetch(std::span<std::byte> vertices, u32 stride, std::span<u32> indices);
+
+Mesh::IndexType to_smallest_index_type(u32 vertex_count);
+std::vector<std::byte> narrow_indices(std::span<const u32> indices, Mesh::IndexType index_type);
+
+struct MeshSource {
+    std::span<const std::byte> vertices;
+    std::span<const u32> indices;
+    u32 stride;
+    u32 position_offset = 0;
+};
+
+struct OptimizedMesh {
+    std::vector<std::byte> vertices;
+    std::vector<std::byte> indices;
+    Mesh::IndexType index_type;
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+/*
+* Runs vertex cache, overdraw and vertex fetch optimizations and narrows indices,
+* the result can be passed straight to the Mesh constructor
+*/
+OptimizedMesh optimize_mesh(const MeshSource& source);
+
+/*
+* Optimizes many meshes in parallel
+*/
+std::vector<OptimizedMesh> optimize_meshes(std::span<const MeshSource> sources, ThreadPool& thread_pool);
+
+} // namespace glw
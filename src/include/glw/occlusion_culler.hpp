@@ -0,0 +1,106 @@
+#pragma once
+#include "glw/buffer.hpp"
+#include "glw/fence.hpp"
+#include "glw/shader.hpp"
+#include "glw/vertex_array.hpp"
+
+#include <cut/non_copyable.hpp>
+#include <cut/types.hpp>
+
+#include <glm/glm.hpp>
+
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+using cut::f32;
+
+struct OcclusionCullerDescription {
+    u32 max_objects = 4096;
+    u32 frame_latency = 3;    // Frames a result may take to arrive before its query is reused
+    u32 visible_frames = 8;   // Frames an object found visible is drawn without querying it again
+    f32 near_plane = 0.1f;    // Bounds closer than this to the camera are always visible
+    bool conservative = true; // GL_ANY_SAMPLES_PASSED_CONSERVATIVE, GL_ANY_SAMPLES_PASSED otherwise
+};
+
+struct OcclusionBounds {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct OcclusionStats {
+    u32 objects = 0;         // Passed to the last query
+    u32 queries = 0;         // Proxies drawn by the last query, the others were assumed visible
+    u32 occluded = 0;        // Results read by the last begin_frame that found no samples
+    u32 dropped_results = 0; // Still unavailable after their region's fence, over all frames
+};
+
+/*
+* Occlusion queries against proxy bounds, each one guarding the real draws of its object through
+* conditional rendering in no-wait mode. Objects found visible skip their queries for a few frames,
+* results are only read back once available. The only wait is on the fence of the region being reused,
+* frame_latency frames old
+*/
+class OcclusionCuller final :
+    cut::NonCopyable {
+public:
+    class Scope final :
+        cut::NonCopyable {
+    public:
+        Scope(OcclusionCuller& culler, u32 object) : culler_{ culler } { culler_.begin_conditional(object); }
+        ~Scope() { culler_.end_conditional(); }
+    private:
+        OcclusionCuller& culler_;
+    };
+
+    explicit OcclusionCuller(const OcclusionCullerDescription& desc = {});
+    ~OcclusionCuller();
+
+    /*
+    * Waits until the GPU is done with the next proxy region, then reads back available results
+    * Results of the region's queries always are by then, only the other regions' may stay pending
+    */
+    void begin_frame();
+
+    /*
+    * Draws the bounds of every object not assumed visible into its own query, call after drawing
+    * the occluders to depth. Color and depth writes are turned off meanwhile and back on afterwards
+    * Objects are identified by their index, which has to stay the same from frame to frame
+    */
+    void query(std::span<const OcclusionBounds> objects, const glm::mat4& view_projection, const glm::vec3& camera_position);
+
+    /*
+    * Draws in between are skipped by the GPU if this frame's query of object found no samples
+    */
+    void begin_conditional(u32 object);
+    void end_conditional();
+
+    /*
+    * Fences the current proxy region, call after the last query
+    */
+    void end_frame();
+
+    bool is_queried(u32 object) const { return query_frames_[object] == frame_index_ + 1; }
+    const OcclusionStats& get_stats() const { return stats_; }
+private:
+    void resolve(u32 slot);
+
+    OcclusionCullerDescription desc_;
+    std::vector<u32> queries_;
+    std::vector<std::vector<u32>> pending_; // Queried objects per frame slot
+    std::vector<u32> visible_until_;        // Frame up to which an object is drawn without a query
+    std::vector<u32> query_frames_;         // Frame of the last query plus one
+    Shader shader_;
+    Buffer index_buffer_;
+    Buffer vertex_buffer_;
+    VertexArray vertex_array_;
+    std::vector<std::optional<Fence>> fences_;
+    u32 frame_index_ = 0;
+    bool conditional_ = false;
+    OcclusionStats stats_;
+};
+
+} // namespace glw
@@ -20,6 +20,10 @@ class ShaderStage final :
 public:
     enum class Type { Vertex, Fragment };
 
+    /*
+    * Compile errors throw right away, or from the Shader linking it when the driver compiles in parallel
+    * Create every stage before linking any of them to let those compiles overlap
+    */
     ShaderStage(Type type, std::span<const std::string_view> sources);
 
     u32 get_native_handle() const { return handle_.get(); }
@@ -0,0 +1,107 @@
+#pragma once
+#include "glw/buffer.hpp"
+#include "glw/fence.hpp"
+#include "glw/shader.hpp"
+#include "glw/texture.hpp"
+#include "glw/vertex_array.hpp"
+
+#include <cut/non_copyable.hpp>
+#include <cut/types.hpp>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <optional>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+using cut::f32;
+
+struct SpriteBatchDescription {
+    u32 max_quads = 65536;       // Per frame, over all flushes
+    u32 max_texture_slots = 16;  // Clamped to Capabilities::max_fragment_texture_units
+    u32 frames_in_flight = 3;
+    SamplerDescription sampler = { .wrap_mode = TextureWrapMode::ClampToEdge };
+    bool alpha_blending = true;  // Straight alpha, the previous blend state is restored after each flush
+};
+
+struct Sprite {
+    glm::vec2 position{ 0.0f };          // Corner with uv_min
+    glm::vec2 size{ 1.0f };
+    glm::vec4 uv_rect{ 0.0f, 0.0f, 1.0f, 1.0f }; // uv_min xy, uv_max zw
+    u32 color = 0xFFFFFFFF;              // RGBA8, red in the lowest byte
+    const Texture* texture = nullptr;    // nullptr draws color only
+};
+
+struct SpriteVertex {
+    glm::vec2 position;
+    glm::vec2 uv;
+    u32 color;
+    u32 texture_slot;
+};
+
+using SpriteLayout = VertexLayout<glm::vec2, glm::vec2, VertexAttributeType<VertexDataType::U8_4_Norm>, u32>;
+
+/*
+* Quads accumulated on the CPU and drawn with one upload and one draw per flush
+* Textures are picked per vertex by slot, a flush happens when the slots or the arena run out,
+* on flush and on end_frame. Slots bind to texture units 0 to max_texture_slots
+*/
+class SpriteBatch final :
+    cut::NonCopyable {
+public:
+    explicit SpriteBatch(const SpriteBatchDescription& desc = {});
+
+    /*
+    * Waits until the GPU is done with the next region, usually returns right away
+    */
+    void begin_frame(const glm::mat4& view_projection);
+
+    void draw(const Sprite& sprite);
+
+    /*
+    * Quad from corners in winding order, the first one gets uv_min, the third one uv_max
+    */
+    void draw_quad(const std::array<glm::vec2, 4>& corners, const glm::vec4& uv_rect, u32 color, const Texture* texture);
+
+    /*
+    * Uploads and draws the pending quads, call before changing state the batch depends on
+    */
+    void flush();
+
+    /*
+    * Flushes and fences the current region, call after the last draw
+    */
+    void end_frame();
+
+    u32 get_texture_slot_count() const { return slot_count_; }
+    u32 get_quad_count() const { return frame_quads_ + pending_quads_; }
+    u32 get_draw_count() const { return draw_count_; }
+
+    /*
+    * Quads drawn by a single flush, bounded by the U16 shared index buffer
+    */
+    static constexpr u32 max_quads_per_draw = 16384;
+private:
+    u32 to_texture_slot(const Texture* texture);
+
+    SpriteBatchDescription desc_;
+    u32 slot_count_;
+    u32 arena_quads_;
+    Shader shader_;
+    Sampler sampler_;
+    Buffer index_buffer_;
+    Buffer vertex_buffer_;
+    VertexArray vertex_array_;
+    std::vector<SpriteVertex> arena_;
+    std::vector<const Texture*> slots_;
+    std::vector<std::optional<Fence>> fences_;
+    u32 region_ = 0;
+    u32 frame_quads_ = 0;
+    u32 pending_quads_ = 0;
+    u32 draw_count_ = 0;
+};
+
+} // namespace glw
@@ -0,0 +1,110 @@
+#pragma once
+#include "glw/buffer.hpp"
+#include "glw/fence.hpp"
+#include "glw/mesh.hpp"
+#include "glw/vertex_array.hpp"
+
+#include <cut/non_copyable.hpp>
+#include <cut/types.hpp>
+
+#include <glm/glm.hpp>
+
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+using cut::s32;
+
+struct StaticBatchMesh {
+    std::span<const std::byte> vertices;
+    std::span<const u32> indices;
+    glm::mat4 transform{ 1.0f };
+};
+
+/*
+* F32_3 attributes rewritten by the mesh transform, normals with its inverse transpose
+*/
+struct StaticBatchDescription {
+    u32 position_offset = 0;
+    std::optional<u32> normal_offset;
+    u32 indirect_regions = 4; // Indirect command regions draws cycle through, each fenced until the GPU is done with it
+};
+
+/*
+* Index range of one merged mesh with its world space bounds
+*/
+struct StaticBatchSubMesh {
+    u32 first_index;
+    u32 index_count;
+    s32 base_vertex;
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max;
+};
+
+/*
+* Meshes sharing a vertex format and material pre-transformed into one vertex and index Buffer pair
+* Vertices are split into segments addressable by the index type of the largest mesh, each drawn
+* with its own base vertex, so neighbouring visible meshes of a segment merge into one range
+*/
+class StaticBatch final :
+    cut::NonCopyable {
+public:
+    StaticBatch(const VertexFormat& vertex_format, std::span<const StaticBatchMesh> meshes,
+                VertexArrayCache& vertex_array_cache, const StaticBatchDescription& desc = {});
+
+    /*
+    * Draws every mesh, one range per segment
+    */
+    void draw();
+
+    /*
+    * Draws given sub meshes, which have to be strictly ascending, with one glMultiDrawElementsBaseVertex
+    * or glMultiDrawElementsIndirect when Capabilities::multi_draw_indirect, whose commands are written
+    * into the next region of a persistently mapped ring, waiting only if the GPU still reads it
+    * GL_DRAW_INDIRECT_BUFFER is unbound again afterwards
+    */
+    void draw(std::span<const u32> visible_sub_meshes);
+
+    const Mesh& get_mesh() const { return mesh_; }
+    std::span<const StaticBatchSubMesh> get_sub_meshes() const { return sub_meshes_; }
+    u32 get_last_range_count() const { return cut::to_u32(counts_.size()); }
+private:
+    // Layout glMultiDrawElementsIndirect reads
+    struct IndirectCommand {
+        u32 count;
+        u32 instance_count;
+        u32 first_index;
+        s32 base_vertex;
+        u32 base_instance;
+    };
+
+    struct Geometry {
+        std::vector<std::byte> vertices;
+        std::vector<std::byte> indices;
+        Mesh::IndexType index_type;
+        std::vector<StaticBatchSubMesh> sub_meshes;
+    };
+
+    StaticBatch(Geometry geometry, const VertexFormat& vertex_format, VertexArrayCache& vertex_array_cache, u32 indirect_regions);
+
+    static Geometry merge(const VertexFormat& vertex_format, std::span<const StaticBatchMesh> meshes, const StaticBatchDescription& desc);
+
+    void add_range(const StaticBatchSubMesh& sub_mesh);
+    void submit();
+
+    Mesh mesh_;
+    std::vector<StaticBatchSubMesh> sub_meshes_;
+    std::vector<s32> counts_;
+    std::vector<u32> first_indices_;
+    std::vector<const void*> offsets_; // first_indices_ in bytes, as glMultiDrawElementsBaseVertex takes them
+    std::vector<s32> base_vertices_;
+    std::optional<Buffer> indirect_commands_;
+    size_t indirect_region_size_ = 0;
+    std::vector<std::optional<Fence>> indirect_fences_;
+    u32 indirect_region_ = 0;
+};
+
+} // namespace glw
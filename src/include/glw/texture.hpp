@@ -1,9 +1,15 @@
 #pragma once
+#include "glw/buffer.hpp"
+#include "glw/fence.hpp"
+
 #include <cut/auto_release.hpp>
 #include <cut/non_copyable.hpp>
 #include <cut/types.hpp>
 
+#include <cstdint>
+#include <optional>
 #include <span>
+#include <vector>
 
 namespace glw {
 
@@ -39,7 +45,10 @@ private:
 
 enum class TextureType {
     Texture2D,
-    Cubemap
+    Texture2DArray,
+    Texture3D,
+    Cubemap,
+    CubemapArray
 };
 
 enum class TextureFormat {
@@ -60,6 +69,41 @@ struct TextureDescription {
     TextureFormat format = TextureFormat::RGBA8;
     u16 width = 1;
     u16 height = 1;
+    u16 layers = 1; // Array layers, cubes of a CubemapArray or depth of a Texture3D
+    u16 levels = 1;
+};
+
+/*
+* Persistently mapped upload buffer kept across Texture::set_pixels calls, split into a ring of regions
+* each fenced until the GPU has copied out of it. Back to back uploads take the next region, so mapping
+* only waits once the ring wraps onto an upload still in flight. Regions grow to the largest upload
+*/
+class TextureStaging final :
+    cut::NonCopyable {
+public:
+    explicit TextureStaging(size_t region_size = 0, u32 region_count = 3);
+
+    /*
+    * First size bytes of the next region, free to overwrite
+    */
+    std::span<std::byte> map(size_t size);
+
+    /*
+    * Fences the uploads issued from the last mapping, call after the last one
+    */
+    void fence();
+
+    /*
+    * Offset of the last mapping into the buffer, as pixel unpack offsets take it
+    */
+    size_t get_offset() const { return static_cast<size_t>(region_) * region_size_; }
+
+    u32 get_native_handle() const { return buffer_->get_native_handle(); }
+private:
+    std::optional<Buffer> buffer_;
+    size_t region_size_ = 0;
+    std::vector<std::optional<Fence>> fences_;
+    u32 region_ = 0;
 };
 
 class Texture final :
@@ -68,16 +112,31 @@ public:
     explicit Texture(const TextureDescription& desc);
 
     void set_pixels_2d(std::span<const std::byte> pixels, u16 channels, u16 x_offset = 0, u16 y_offset = 0, u16 width = 0, u16 height = 0) const;
-    void set_pixels_3d(std::span<const std::byte> pixels, u16 channels, u16 x_offset = 0, u16 y_offset = 0, u16 z_offset = 0, u16 width = 0, u16 height = 0) const;
+    void set_pixels_3d(std::span<const std::byte> pixels, u16 channels, u16 x_offset = 0, u16 y_offset = 0, u16 z_offset = 0, u16 width = 0, u16 height = 0, u16 depth = 1) const;
+
+    /*
+    * Uploads every layer (or cubemap face) of every level through staging
+    * Pixels are tightly packed, level by level starting from the base one
+    */
+    void set_pixels(std::span<const std::byte> pixels, u16 channels, TextureStaging& staging) const;
     
     void generate_mipmaps() const;
 
     void bind(u32 unit) const;
 
+    /*
+    * Handle shaders sample through without binding, made resident on first use
+    * Needs Capabilities::bindless_textures, storage and sampling state can't change afterwards
+    */
+    std::uint64_t get_bindless_handle();
+
+    const TextureDescription& get_description() const { return desc_; }
+
     u32 get_native_handle() const { return handle_.get(); }
 private:
     cut::AutoRelease<u32> handle_;
     TextureDescription desc_;
+    std::uint64_t bindless_handle_ = 0;
 };
 
 } // namespace glw
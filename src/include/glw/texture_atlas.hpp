@@ -0,0 +1,127 @@
+#pragma once
+#include "glw/texture.hpp"
+
+#include <cut/non_copyable.hpp>
+#include <cut/types.hpp>
+
+#include <array>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace glw {
+
+using cut::u16;
+using cut::u32;
+using cut::f32;
+
+struct AtlasRect {
+    u16 x;
+    u16 y;
+    u16 width;
+    u16 height;
+};
+
+/*
+* Skyline bottom-left rectangle packer
+* Space wasted below the skyline and freed rectangles are kept in free lists and reused first,
+* bucketed by log2 of their shorter side so slivers are never scanned for bigger requests
+*/
+class AtlasPacker final {
+public:
+    AtlasPacker(u16 width, u16 height);
+
+    std::optional<AtlasRect> insert(u16 width, u16 height);
+    void free(const AtlasRect& rect);
+    void clear();
+
+    u16 get_width() const { return width_; }
+    u16 get_height() const { return height_; }
+    u32 get_used_area() const { return used_area_; }
+    f32 get_occupancy() const { return static_cast<f32>(used_area_) / (static_cast<u32>(width_) * height_); }
+private:
+    struct SkylineNode {
+        u16 x;
+        u16 y;
+        u16 width;
+    };
+
+    std::optional<AtlasRect> insert_free(u16 width, u16 height);
+    std::optional<AtlasRect> insert_skyline(u16 width, u16 height);
+    void add_free_rect(AtlasRect rect);
+    void merge_free_rect(AtlasRect rect);
+
+    static constexpr size_t free_bucket_count = 16;
+
+    u16 width_;
+    u16 height_;
+    u32 used_area_ = 0;
+    std::vector<SkylineNode> skyline_;
+    std::array<std::vector<AtlasRect>, free_bucket_count> free_rects_;
+};
+
+struct TextureAtlasDescription {
+    TextureFormat format = TextureFormat::RGBA8;
+    u16 page_width = 2048;
+    u16 page_height = 2048;
+    u16 padding = 1;
+    u32 max_pages = 8;
+};
+
+struct AtlasUVRect {
+    f32 u0;
+    f32 v0;
+    f32 u1;
+    f32 v1;
+};
+
+/*
+* Packs many small images into few 2D texture pages so draws using them can share bindings
+*/
+class TextureAtlas final :
+    cut::NonCopyable {
+public:
+    using Handle = u32;
+
+    explicit TextureAtlas(const TextureAtlasDescription& desc);
+
+    /*
+    * Packs and uploads an image, returns nothing if no page has room left
+    * Width and height must not be zero, the space is given back if the upload throws
+    */
+    std::optional<Handle> insert(std::span<const std::byte> pixels, u16 channels, u16 width, u16 height);
+    void remove(Handle handle);
+
+    /*
+    * Packs all live images again from scratch, moving pixels with GPU side copies
+    * Handles stay valid, their pages and UV rects may change
+    * Returns false and leaves the atlas as it was if the images no longer fit max_pages in the new order
+    */
+    bool repack();
+
+    void bind(u32 first_unit) const;
+
+    u32 get_page(Handle handle) const { return entries_[handle].page; }
+    AtlasRect get_rect(Handle handle) const { return entries_[handle].rect; }
+    AtlasUVRect get_uv_rect(Handle handle) const;
+
+    std::span<const Texture> get_pages() const { return pages_; }
+    f32 get_occupancy() const;
+private:
+    struct Entry {
+        u32 page;
+        AtlasRect rect;
+        bool alive;
+    };
+
+    std::optional<Entry> pack(std::vector<AtlasPacker>& packers, u16 width, u16 height) const;
+    void release(const Entry& entry);
+
+    TextureAtlasDescription desc_;
+    std::vector<AtlasPacker> packers_;
+    std::vector<Texture> pages_;
+    std::vector<Entry> entries_;
+    std::vector<Handle> free_handles_;
+};
+
+} // namespace glw
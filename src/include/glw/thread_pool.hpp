@@ -0,0 +1,55 @@
+#pragma once
+#include <cut/non_copyable.hpp>
+#include <cut/types.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace glw {
+
+using cut::u32;
+
+class ThreadPool final :
+    cut::NonCopyable {
+public:
+    using RangeFunc = std::function<void(size_t begin, size_t end)>;
+
+    /*
+    * Spawns thread_count - 1 workers, the thread calling parallel_for is the last one
+    */
+    explicit ThreadPool(u32 thread_count = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    /*
+    * Splits [0, count) into chunks of chunk_size and runs func on them across all threads
+    * Returns once every chunk is done, rethrows the first exception thrown by func
+    * Throws if called from inside func or while another thread's call is running, either would deadlock
+    */
+    void parallel_for(size_t count, size_t chunk_size, const RangeFunc& func);
+
+    u32 get_thread_count() const { return cut::to_u32(workers_.size()) + 1; }
+private:
+    void worker_loop();
+    void run_chunks();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    const RangeFunc* func_ = nullptr;
+    size_t count_ = 0;
+    size_t chunk_size_ = 1;
+    std::atomic<size_t> next_{ 0 };
+    std::atomic<bool> running_{ false };
+    u32 generation_ = 0;
+    u32 busy_workers_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr exception_;
+};
+
+} // namespace glw
@@ -1,36 +1,239 @@
 #pragma once
 #include <cut/auto_release.hpp>
+#include <cut/exception.hpp>
 #include <cut/non_copyable.hpp>
 #include <cut/types.hpp>
 
+#include <glm/fwd.hpp>
+
+#include <array>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
 namespace glw {
 
 using cut::u32;
+using cut::s32;
 
 class Buffer;
 
+enum class VertexDataType {
+    U8_4,
+    U16_2, U16_4,
+    S16_2, S16_4,
+    U32, U32_2, U32_3, U32_4,
+    S32, S32_2, S32_3, S32_4,
+    U8_4_Norm,
+    S8_4_Norm,
+    U16_2_Norm, U16_4_Norm,
+    S16_2_Norm, S16_4_Norm,
+    U32_Norm, U32_2_Norm, U32_3_Norm, U32_4_Norm,
+    S32_Norm, S32_2_Norm, S32_3_Norm, S32_4_Norm,
+    U10_10_10_2_Norm,
+    S10_10_10_2_Norm,
+    F16_2, F16_4,
+    F32, F32_2, F32_3, F32_4
+};
+
+struct VertexAttributeFormat {
+    u32 size;
+    s32 count;
+    bool integer;
+    bool normalized;
+};
+
+constexpr VertexAttributeFormat to_attribute_format(VertexDataType type) {
+    switch (type) {
+    using enum VertexDataType;
+    case U8_4:             return { 4,  4, true,  false };
+    case U16_2:            return { 4,  2, true,  false };
+    case U16_4:            return { 8,  4, true,  false };
+    case S16_2:            return { 4,  2, true,  false };
+    case S16_4:            return { 8,  4, true,  false };
+    case U32:              return { 4,  1, true,  false };
+    case U32_2:            return { 8,  2, true,  false };
+    case U32_3:            return { 12, 3, true,  false };
+    case U32_4:            return { 16, 4, true,  false };
+    case S32:              return { 4,  1, true,  false };
+    case S32_2:            return { 8,  2, true,  false };
+    case S32_3:            return { 12, 3, true,  false };
+    case S32_4:            return { 16, 4, true,  false };
+    case U8_4_Norm:        return { 4,  4, false, true  };
+    case S8_4_Norm:        return { 4,  4, false, true  };
+    case U16_2_Norm:       return { 4,  2, false, true  };
+    case U16_4_Norm:       return { 8,  4, false, true  };
+    case S16_2_Norm:       return { 4,  2, false, true  };
+    case S16_4_Norm:       return { 8,  4, false, true  };
+    case U32_Norm:         return { 4,  1, false, true  };
+    case U32_2_Norm:       return { 8,  2, false, true  };
+    case U32_3_Norm:       return { 12, 3, false, true  };
+    case U32_4_Norm:       return { 16, 4, false, true  };
+    case S32_Norm:         return { 4,  1, false, true  };
+    case S32_2_Norm:       return { 8,  2, false, true  };
+    case S32_3_Norm:       return { 12, 3, false, true  };
+    case S32_4_Norm:       return { 16, 4, false, true  };
+    case U10_10_10_2_Norm: return { 4,  4, false, true  };
+    case S10_10_10_2_Norm: return { 4,  4, false, true  };
+    case F16_2:            return { 4,  2, false, false };
+    case F16_4:            return { 8,  4, false, false };
+    case F32:              return { 4,  1, false, false };
+    case F32_2:            return { 8,  2, false, false };
+    case F32_3:            return { 12, 3, false, false };
+    case F32_4:            return { 16, 4, false, false };
+    }
+
+    throw cut::Exception("Unhandled vertex data type!");
+    return {};
+}
+
+/*
+* Component type glVertexArrayAttribFormat takes for an attribute of type
+*/
+u32 to_gl_enum(VertexDataType type);
+
+struct VertexAttribute {
+    VertexDataType type;
+    u32 offset;
+
+    bool operator==(const VertexAttribute&) const = default;
+};
+
+constexpr u32 hash_vertex_attributes(std::span<const VertexAttribute> attributes) {
+    // FNV-1a
+    u32 hash = 2166136261u;
+    for (const auto& attribute : attributes) {
+        hash = (hash ^ static_cast<u32>(attribute.type)) * 16777619u;
+        hash = (hash ^ attribute.offset) * 16777619u;
+    }
+    return hash;
+}
+
+/*
+* Non-owning view of an interleaved vertex layout, attributes go to consecutive locations
+*/
+struct VertexFormat {
+    std::span<const VertexAttribute> attributes;
+    u32 stride;
+    u32 hash;
+};
+
+constexpr u32 max_vertex_streams = 4;
+
+constexpr u32 hash_vertex_streams(std::span<const VertexFormat> streams) {
+    u32 hash = streams.empty() ? 2166136261u : streams[0].hash;
+    for (size_t i = 1; i < streams.size(); ++i) {
+        hash = (hash ^ streams[i].hash) * 16777619u;
+        hash = (hash ^ streams[i].stride) * 16777619u;
+    }
+    return hash;
+}
+
+/*
+* Tag selecting a data type explicitly inside VertexLayout, e.g. for normalized attributes
+*/
+template<VertexDataType Type>
+struct VertexAttributeType {};
+
+template<typename T>
+struct VertexAttributeTraits;
+
+template<VertexDataType Type>
+struct VertexAttributeTraits<VertexAttributeType<Type>> { static constexpr VertexDataType type = Type; };
+
+template<> struct VertexAttributeTraits<cut::f32> { static constexpr VertexDataType type = VertexDataType::F32; };
+template<> struct VertexAttributeTraits<u32>      { static constexpr VertexDataType type = VertexDataType::U32; };
+template<> struct VertexAttributeTraits<s32>      { static constexpr VertexDataType type = VertexDataType::S32; };
+
+template<glm::length_t L, glm::qualifier Q>
+struct VertexAttributeTraits<glm::vec<L, cut::f32, Q>> {
+    static constexpr VertexDataType type = L == 2 ? VertexDataType::F32_2 : L == 3 ? VertexDataType::F32_3 : VertexDataType::F32_4;
+};
+
+template<glm::length_t L, glm::qualifier Q>
+struct VertexAttributeTraits<glm::vec<L, u32, Q>> {
+    static constexpr VertexDataType type = L == 2 ? VertexDataType::U32_2 : L == 3 ? VertexDataType::U32_3 : VertexDataType::U32_4;
+};
+
+template<glm::length_t L, glm::qualifier Q>
+struct VertexAttributeTraits<glm::vec<L, s32, Q>> {
+    static constexpr VertexDataType type = L == 2 ? VertexDataType::S32_2 : L == 3 ? VertexDataType::S32_3 : VertexDataType::S32_4;
+};
+
+/*
+* Interleaved vertex layout with stride, offsets and hash computed at compile time
+* Ts are attribute C++ types (f32, glm vectors) or VertexAttributeType tags
+*/
+template<typename... Ts>
+struct VertexLayout {
+    static_assert(sizeof...(Ts) > 0, "VertexLayout needs at least one attribute!");
+
+    static constexpr std::array<VertexAttribute, sizeof...(Ts)> attributes = [] {
+        std::array<VertexAttribute, sizeof...(Ts)> result{};
+        VertexDataType types[] = { VertexAttributeTraits<Ts>::type... };
+        u32 offset = 0;
+        for (size_t i = 0; i < sizeof...(Ts); ++i) {
+            result[i] = { types[i], offset };
+            offset += to_attribute_format(types[i]).size;
+        }
+        return result;
+    }();
+    static constexpr u32 stride = (to_attribute_format(VertexAttributeTraits<Ts>::type).size + ... + 0);
+    static constexpr u32 hash = hash_vertex_attributes(attributes);
+
+    static constexpr VertexFormat get_format() { return { attributes, stride, hash }; }
+};
+
 class VertexArray final :
     cut::NonCopyable {
 public:
-    enum class DataType {
-        U8_4,
-        U16_2,
-        U32, U32_2, U32_3, U32_4,
-        S32, S32_2, S32_3, S32_4,
-        U8_4_Norm,
-        U16_2_Norm,
-        U32_Norm, U32_2_Norm, U32_3_Norm, U32_4_Norm,
-        S32_Norm, S32_2_Norm, S32_3_Norm, S32_4_Norm,
-        F32, F32_2, F32_3, F32_4
-    };
+    using DataType = VertexDataType;
 
     VertexArray(const Buffer& vertex_buffer, std::initializer_list<DataType> layout);
 
+    /*
+    * Creates VertexArray without buffers, to be shared by all meshes with the same format
+    */
+    explicit VertexArray(const VertexFormat& format);
+
+    /*
+    * Creates VertexArray reading stream i from vertex buffer binding i
+    * Attribute locations continue from one stream to the next
+    */
+    explicit VertexArray(std::span<const VertexFormat> streams);
+
+    void set_vertex_buffer(const Buffer& vertex_buffer, u32 binding = 0);
     void set_index_buffer(const Buffer& index_buffer);
 
     void bind() const;
 private:
     cut::AutoRelease<u32> handle_;
+    std::array<u32, max_vertex_streams> strides_{};
+};
+
+/*
+* Per context VertexArray storage keyed by vertex format
+*/
+class VertexArrayCache final :
+    cut::NonCopyable {
+public:
+    VertexArray& get(const VertexFormat& format);
+    VertexArray& get(std::span<const VertexFormat> streams);
+
+    size_t get_size() const { return entries_.size(); }
+private:
+    struct Entry {
+        explicit Entry(std::span<const VertexFormat> streams);
+
+        bool matches(std::span<const VertexFormat> streams) const;
+
+        std::vector<VertexAttribute> attributes;
+        std::vector<u32> attribute_counts;
+        std::vector<u32> strides;
+        VertexArray vertex_array;
+    };
+
+    std::unordered_multimap<u32, Entry> entries_;
 };
 
 } // namespace glw
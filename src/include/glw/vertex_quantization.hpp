@@ -0,0 +1,80 @@
+#pragma once
+#include "glw/vertex_array.hpp"
+
+#include <cut/types.hpp>
+
+#include <glm/glm.hpp>
+
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace glw {
+
+using cut::u16;
+using cut::u32;
+using cut::f32;
+
+/*
+* Float vertex streams to quantize, optional streams are left empty
+* Tangent w holds the bitangent sign
+*/
+struct QuantizationInput {
+    std::span<const glm::vec3> positions;
+    std::span<const glm::vec3> normals;
+    std::span<const glm::vec4> tangents;
+    std::span<const glm::vec2> uvs;
+};
+
+/*
+* Bounds a quantized stream has to stay within, streams that can't meet them stay float
+*/
+struct QuantizationDescription {
+    f32 max_position_error = 0.001f; // Object space units
+    f32 max_uv_error = 1.0f / 8192.0f;
+};
+
+struct QuantizationStats {
+    size_t float_bytes = 0;
+    size_t quantized_bytes = 0;
+    f32 max_position_error = 0.0f;
+    f32 max_normal_error = 0.0f;  // Radians
+    f32 max_tangent_error = 0.0f; // Radians
+    f32 max_uv_error = 0.0f;
+};
+
+/*
+* Interleaved quantized vertices in location order position, normal, tangent, uv
+* Positions: S16_4_Norm or F16_4 scaled by position_scale plus position_offset, or F32_3
+* Normals: octahedral S16_2_Norm, tangents: octahedral S10_10_10_2_Norm with sign in w
+* UVs: U16_2_Norm scaled by uv_scale plus uv_offset, or F32_2
+*/
+struct QuantizedMesh {
+    std::vector<std::byte> vertices;
+    std::vector<VertexAttribute> attributes;
+    u32 stride = 0;
+    glm::vec3 position_scale{ 1.0f };
+    glm::vec3 position_offset{ 0.0f };
+    glm::vec2 uv_scale{ 1.0f };
+    glm::vec2 uv_offset{ 0.0f };
+    QuantizationStats stats;
+
+    VertexFormat get_format() const {
+        return { attributes, stride, hash_vertex_attributes(attributes) };
+    }
+
+    static constexpr std::string_view glsl_source = R"(
+vec3 oct_decode(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+)";
+};
+
+QuantizedMesh quantize_vertices(const QuantizationInput& input, const QuantizationDescription& desc = {});
+
+u16 to_half(f32 value);
+f32 from_half(u16 value);
+
+} // namespace glw
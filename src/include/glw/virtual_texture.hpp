@@ -0,0 +1,199 @@
+#pragma once
+#include "glw/buffer.hpp"
+#include "glw/fence.hpp"
+#include "glw/texture.hpp"
+
+#include <cut/non_copyable.hpp>
+#include <cut/types.hpp>
+
+#include <array>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace glw {
+
+using cut::u8;
+using cut::u16;
+using cut::u32;
+using cut::f32;
+
+/*
+* CPU side LRU bookkeeping of which virtual pages occupy which physical cache slots
+*/
+class PageResidency final {
+public:
+    static constexpr u32 invalid = ~0u;
+
+    struct Allocation {
+        u32 slot;
+        u32 evicted_page;
+    };
+
+    PageResidency(u32 virtual_page_count, u32 slot_count);
+
+    u32 find(u32 page) const { return page_slots_[page]; }
+
+    /*
+    * Marks slot as most recently used in a given frame
+    */
+    void touch(u32 slot, u32 frame);
+
+    /*
+    * Assigns least recently used slot to a page
+    * Returns nothing if every slot is already used by the current frame
+    */
+    std::optional<Allocation> allocate(u32 page, u32 frame);
+
+    u32 get_slot_count() const { return cut::to_u32(slot_pages_.size()); }
+private:
+    void unlink(u32 slot);
+    void push_front(u32 slot);
+
+    std::vector<u32> page_slots_;
+    std::vector<u32> slot_pages_;
+    std::vector<u32> slot_frames_;
+    std::vector<u32> prev_;
+    std::vector<u32> next_;
+    u32 head_ = invalid;
+    u32 tail_ = invalid;
+};
+
+struct VirtualTextureDescription {
+    u32 width = 1;
+    u32 height = 1;
+    u16 page_size = 128;
+    u16 cache_width_pages = 32;
+    u16 cache_height_pages = 32;
+    u32 max_uploads_per_frame = 16;
+};
+
+struct VirtualTextureStats {
+    u32 requested_pages = 0;
+    u32 resident_pages = 0;
+    u32 uploaded_pages = 0;
+    u32 evicted_pages = 0;
+    u32 pending_pages = 0;
+    size_t upload_bytes = 0;
+    size_t memory_footprint = 0;
+
+    f32 get_hit_rate() const {
+        return requested_pages == 0 ? 1.0f : static_cast<f32>(resident_pages) / requested_pages;
+    }
+};
+
+/*
+* Texture larger than VRAM, streamed in fixed size RGBA8 pages into a physical cache texture
+* Shaders translate virtual UVs through a page table texture, see glsl_source
+*/
+class VirtualTexture final :
+    cut::NonCopyable {
+public:
+    /*
+    * Fills page_size * page_size RGBA8 pixels of a given virtual page
+    */
+    using PageProvider = std::function<void(u32 page_x, u32 page_y, std::span<std::byte> pixels)>;
+
+    /*
+    * RGBA8 texel of the page table, cache page coordinates of a resident virtual page
+    */
+    struct PageTableEntry {
+        u8 x;
+        u8 y;
+        u8 unused;
+        u8 resident;
+    };
+
+    static constexpr u32 invalid_page_id = ~0u;
+    static constexpr u32 feedback_latency = 3;
+
+    VirtualTexture(const VirtualTextureDescription& desc, PageProvider provider);
+
+    static u32 to_page_id(u32 page_x, u32 page_y) { return (page_y << 16) | page_x; }
+
+    /*
+    * Queues page ids to be made resident by the next update
+    */
+    void request_pages(std::span<const u32> page_ids);
+
+    /*
+    * Copies R32U feedback texture written with vt_page_id into a readback ring
+    * and requests pages from the copy made feedback_latency frames ago, never stalls
+    * Clears feedback afterwards, call once per frame after the feedback pass
+    */
+    void read_feedback(const Texture& feedback);
+
+    /*
+    * Fills feedback with invalid_page_id, texels no draw covers would request page 0 otherwise
+    * read_feedback does this every frame, call it once on a new feedback texture
+    */
+    static void clear_feedback(const Texture& feedback);
+
+    /*
+    * Makes requested pages resident in LRU order, uploading at most max_uploads_per_frame pages
+    */
+    void update();
+
+    void bind(u32 cache_unit, u32 page_table_unit) const;
+
+    const VirtualTextureStats& get_stats() const { return stats_; }
+    const VirtualTextureDescription& get_description() const { return desc_; }
+    u32 get_width_pages() const { return width_pages_; }
+    u32 get_height_pages() const { return height_pages_; }
+
+    /*
+    * CPU copy of the page table, matches the texture after each update
+    */
+    PageTableEntry get_page_table_entry(u32 page_x, u32 page_y) const { return page_table_entries_[page_y * width_pages_ + page_x]; }
+
+    static constexpr std::string_view glsl_source = R"(
+uint vt_page_id(vec2 uv, uvec2 virtual_pages) {
+    uvec2 page = min(uvec2(clamp(uv, 0.0, 1.0) * vec2(virtual_pages)), virtual_pages - 1u);
+    return (page.y << 16) | page.x;
+}
+
+vec4 vt_sample(sampler2D page_table, sampler2D cache, vec2 uv, uvec2 virtual_pages, uvec2 cache_pages, vec4 fallback) {
+    vec2 page_coord = clamp(uv, 0.0, 1.0) * vec2(virtual_pages);
+    ivec2 page = min(ivec2(page_coord), ivec2(virtual_pages) - 1);
+    vec4 entry = texelFetch(page_table, page, 0);
+    if (entry.a < 0.5) return fallback;
+    vec2 physical = round(entry.rg * 255.0);
+    return texture(cache, (physical + page_coord - vec2(page)) / vec2(cache_pages));
+}
+)";
+private:
+    struct FeedbackSlot {
+        std::optional<Buffer> buffer;
+        size_t size = 0;
+        std::optional<Fence> fence;
+    };
+
+    void set_page_table_entry(u32 page, PageTableEntry entry);
+    void upload_page_table();
+
+    VirtualTextureDescription desc_;
+    PageProvider provider_;
+    u32 width_pages_;
+    u32 height_pages_;
+    Texture cache_;
+    Texture page_table_;
+    PageResidency residency_;
+    std::vector<PageTableEntry> page_table_entries_;
+    std::vector<u32> requested_;
+    std::vector<u32> missing_;
+    std::vector<std::byte> page_pixels_;
+    std::vector<PageTableEntry> page_table_scratch_;
+    std::array<FeedbackSlot, feedback_latency> feedback_slots_;
+    std::vector<u32> feedback_scratch_;
+    u32 feedback_index_ = 0;
+    u32 dirty_min_x_;
+    u32 dirty_min_y_;
+    u32 dirty_max_x_ = 0;
+    u32 dirty_max_y_ = 0;
+    u32 frame_ = 0;
+    VirtualTextureStats stats_;
+};
+
+} // namespace glw
@@ -0,0 +1,77 @@
+#include "glw/mapped_file.hpp"
+
+#include <cut/exception.hpp>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace glw {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    cut::ensure(file != INVALID_HANDLE_VALUE, "Could not open {}!", path.string());
+
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    // The view keeps the mapping alive, both handles can be closed right away
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    cut::ensure(mapping != nullptr, "Could not map {}!", path.string());
+
+    data_ = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    cut::ensure(data_ != nullptr, "Could not map {}!", path.string());
+}
+
+MappedFile::~MappedFile() {
+    if (data_) UnmapViewOfFile(data_);
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    int file = open(path.c_str(), O_RDONLY);
+    cut::ensure(file != -1, "Could not open {}!", path.string());
+
+    struct stat info{};
+    bool has_info = fstat(file, &info) == 0;
+    if (!has_info) close(file);
+    cut::ensure(has_info, "Could not stat {}!", path.string());
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ == 0) {
+        close(file);
+        return;
+    }
+
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    cut::ensure(data != MAP_FAILED, "Could not map {}!", path.string());
+
+    // Whole file is read right away while uploading
+    madvise(data, size_, MADV_WILLNEED);
+    data_ = static_cast<const std::byte*>(data);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) munmap(const_cast<std::byte*>(data_), size_);
+}
+
+#endif
+
+} // namespace glw
@@ -3,23 +3,18 @@
 
 #include <cut/exception.hpp>
 
+#include <cstdint>
+
 namespace {
 
 using namespace glw;
 
-using cut::u8;
-using cut::u16;
-
-u32 to_size(Mesh::IndexType type) {
-    switch (type) {
-    using enum Mesh::IndexType;
-    case U8:  return sizeof(u8);
-    case U16: return sizeof(u16);
-    case U32: return sizeof(u32);
-    }
-
-    throw cut::Exception("Unhandled index type!");
-    return {};
+/*
+* Runs before the VertexArrayCache lookup, so a bad format never builds a VertexArray
+*/
+const VertexFormat& validate(const VertexFormat& vertex_format) {
+    cut::ensure(!vertex_format.attributes.empty(), "Vertex format has no attributes!");
+    return vertex_format;
 }
 
 } // namespace
@@ -28,13 +23,83 @@ namespace glw {
 
 Mesh::Mesh(ByteView vertices, ByteView indices, IndexType index_type,
            std::initializer_list<VertexArray::DataType> vertex_layout) :
-    vbo_{ vertices },
     ibo_{ indices },
-    vao_{ vbo_, vertex_layout },
     index_count_{ cut::to_u32(indices.size()) / to_size(index_type) },
-    index_type_{ index_type }
+    index_type_{ index_type },
+    lods_{ { 0, index_count_, 0.0f } }
 {
-    vao_.set_index_buffer(ibo_);
+    vbos_[0].emplace(vertices);
+    vao_.emplace(*vbos_[0], vertex_layout);
+    vao_->set_index_buffer(ibo_);
+}
+
+Mesh::Mesh(ByteView vertices, ByteView indices, IndexType index_type,
+           const VertexFormat& vertex_format, VertexArrayCache& vertex_array_cache) :
+    ibo_{ indices },
+    shared_vao_{ &vertex_array_cache.get(validate(vertex_format)) },
+    index_count_{ cut::to_u32(indices.size()) / to_size(index_type) },
+    index_type_{ index_type },
+    lods_{ { 0, index_count_, 0.0f } }
+{
+    vbos_[0].emplace(vertices);
+
+    auto position_attributes = vertex_format.attributes.first(1);
+    position_vao_ = &vertex_array_cache.get(VertexFormat{ position_attributes, vertex_format.stride, hash_vertex_attributes(position_attributes) });
+}
+
+Mesh::Mesh(std::span<const VertexStream> streams, ByteView indices, IndexType index_type,
+           VertexArrayCache& vertex_array_cache) :
+    ibo_{ indices },
+    stream_count_{ cut::to_u32(streams.size()) },
+    index_count_{ cut::to_u32(indices.size()) / to_size(index_type) },
+    index_type_{ index_type },
+    lods_{ { 0, index_count_, 0.0f } }
+{
+    cut::ensure(!streams.empty() && streams.size() <= max_vertex_streams, "Mesh needs 1 to {} vertex streams!", max_vertex_streams);
+
+    std::array<VertexFormat, max_vertex_streams> formats;
+    for (u32 i = 0; i < stream_count_; ++i) {
+        vbos_[i].emplace(streams[i].vertices);
+        formats[i] = streams[i].format;
+    }
+    shared_vao_ = &vertex_array_cache.get(std::span{ formats }.first(stream_count_));
+    position_vao_ = &vertex_array_cache.get(formats[0]);
+}
+
+void Mesh::bind() const {
+    if (vao_) {
+        vao_->bind();
+        return;
+    }
+
+    for (u32 i = 0; i < stream_count_; ++i) {
+        shared_vao_->set_vertex_buffer(*vbos_[i], i);
+    }
+    shared_vao_->set_index_buffer(ibo_);
+    shared_vao_->bind();
+}
+
+void Mesh::bind_positions() const {
+    if (!position_vao_) {
+        bind();
+        return;
+    }
+
+    position_vao_->set_vertex_buffer(*vbos_[0]);
+    position_vao_->set_index_buffer(ibo_);
+    position_vao_->bind();
+}
+
+void Mesh::set_lods(std::span<const LodLevel> lods) {
+    cut::ensure(!lods.empty(), "Mesh needs at least one LOD level!");
+    for (const auto& lod : lods) {
+        cut::ensure(static_cast<std::uint64_t>(lod.first_index) + lod.index_count <= index_count_, "LOD level reaches past the index buffer!");
+    }
+    lods_.assign(lods.begin(), lods.end());
+}
+
+const LodLevel& Mesh::get_lod(f32 distance, f32 fov_y, f32 viewport_height, f32 threshold_pixels) const {
+    return lods_[select_lod(lods_, distance, fov_y, viewport_height, threshold_pixels)];
 }
 
 u32 Mesh::to_gl_enum(IndexType type) {
@@ -49,4 +114,16 @@ u32 Mesh::to_gl_enum(IndexType type) {
     return {};
 }
 
+u32 Mesh::to_size(IndexType type) {
+    switch (type) {
+    using enum IndexType;
+    case U8:  return sizeof(cut::u8);
+    case U16: return sizeof(cut::u16);
+    case U32: return sizeof(u32);
+    }
+
+    throw cut::Exception("Unhandled index type!");
+    return {};
+}
+
 } // namespace glw
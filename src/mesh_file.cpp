@@ -0,0 +1,203 @@
+#include "glw/mesh_file.hpp"
+
+#include <cut/exception.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+using namespace glw;
+
+constexpr char magic[4] = { 'G', 'L', 'W', 'M' };
+constexpr u32 version = 1;
+constexpr size_t blob_alignment = 64;
+
+struct FileHeader {
+    char magic[4];
+    u32 version;
+    u32 stride;
+    u32 attribute_count;
+    u32 index_type;
+    u32 lod_count;
+    std::uint64_t vertex_offset;
+    std::uint64_t vertex_size;
+    std::uint64_t index_offset;
+    std::uint64_t index_size;
+    f32 position_scale[3];
+    f32 position_offset[3];
+    f32 uv_scale[2];
+    f32 uv_offset[2];
+};
+static_assert(sizeof(FileHeader) == 96);
+
+struct FileAttribute {
+    u32 type;
+    u32 offset;
+};
+
+struct FileLod {
+    u32 first_index;
+    u32 index_count;
+    f32 error;
+};
+
+/*
+* On disk codes of vertex data types are positions in this table, append new types at the end only
+*/
+constexpr VertexDataType file_data_types[] = {
+    VertexDataType::U8_4,
+    VertexDataType::U16_2, VertexDataType::U16_4,
+    VertexDataType::S16_2, VertexDataType::S16_4,
+    VertexDataType::U32, VertexDataType::U32_2, VertexDataType::U32_3, VertexDataType::U32_4,
+    VertexDataType::S32, VertexDataType::S32_2, VertexDataType::S32_3, VertexDataType::S32_4,
+    VertexDataType::U8_4_Norm,
+    VertexDataType::S8_4_Norm,
+    VertexDataType::U16_2_Norm, VertexDataType::U16_4_Norm,
+    VertexDataType::S16_2_Norm, VertexDataType::S16_4_Norm,
+    VertexDataType::U32_Norm, VertexDataType::U32_2_Norm, VertexDataType::U32_3_Norm, VertexDataType::U32_4_Norm,
+    VertexDataType::S32_Norm, VertexDataType::S32_2_Norm, VertexDataType::S32_3_Norm, VertexDataType::S32_4_Norm,
+    VertexDataType::U10_10_10_2_Norm,
+    VertexDataType::S10_10_10_2_Norm,
+    VertexDataType::F16_2, VertexDataType::F16_4,
+    VertexDataType::F32, VertexDataType::F32_2, VertexDataType::F32_3, VertexDataType::F32_4
+};
+
+u32 to_file_code(VertexDataType type) {
+    for (u32 code = 0; code < std::size(file_data_types); ++code) {
+        if (file_data_types[code] == type) return code;
+    }
+    throw cut::Exception("Vertex data type has no mesh file code!");
+    return {};
+}
+
+VertexDataType to_vertex_data_type(u32 code) {
+    cut::ensure(code < std::size(file_data_types), "Unknown vertex data type!");
+    return file_data_types[code];
+}
+
+size_t align_up(size_t value) {
+    return (value + blob_alignment - 1) / blob_alignment * blob_alignment;
+}
+
+template<typename T>
+T read_record(std::span<const std::byte> bytes, size_t offset) {
+    cut::ensure(offset + sizeof(T) <= bytes.size(), "Mesh file is truncated!");
+
+    T record;
+    std::memcpy(&record, bytes.data() + offset, sizeof(T));
+    return record;
+}
+
+} // namespace
+
+namespace glw {
+
+void write_mesh_file(const std::filesystem::path& path, const MeshFileData& data) {
+    cut::ensure(data.stride > 0 && data.vertices.size() % data.stride == 0, "Vertex data doesn't match the stride!");
+    cut::ensure(data.indices.size() % Mesh::to_size(data.index_type) == 0, "Index data doesn't match the index type!");
+
+    size_t records_size = sizeof(FileHeader) + data.attributes.size() * sizeof(FileAttribute) + data.lods.size() * sizeof(FileLod);
+
+    FileHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.stride = data.stride;
+    header.attribute_count = cut::to_u32(data.attributes.size());
+    header.index_type = static_cast<u32>(data.index_type);
+    header.lod_count = cut::to_u32(data.lods.size());
+    header.vertex_offset = align_up(records_size);
+    header.vertex_size = data.vertices.size();
+    header.index_offset = align_up(header.vertex_offset + header.vertex_size);
+    header.index_size = data.indices.size();
+    std::memcpy(header.position_scale, &data.position_scale, sizeof(header.position_scale));
+    std::memcpy(header.position_offset, &data.position_offset, sizeof(header.position_offset));
+    std::memcpy(header.uv_scale, &data.uv_scale, sizeof(header.uv_scale));
+    std::memcpy(header.uv_offset, &data.uv_offset, sizeof(header.uv_offset));
+
+    std::ofstream file(path, std::ios::binary);
+    cut::ensure(file.good(), "Could not open {}!", path.string());
+
+    auto write = [&file](const void* bytes, size_t size) {
+        file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+    };
+    auto pad_to = [&file, &write](size_t offset) {
+        static constexpr char zeros[blob_alignment] = {};
+        write(zeros, offset - static_cast<size_t>(file.tellp()));
+    };
+
+    write(&header, sizeof(header));
+    for (const auto& attribute : data.attributes) {
+        FileAttribute record{ to_file_code(attribute.type), attribute.offset };
+        write(&record, sizeof(record));
+    }
+    for (const auto& lod : data.lods) {
+        FileLod record{ lod.first_index, lod.index_count, lod.error };
+        write(&record, sizeof(record));
+    }
+    pad_to(header.vertex_offset);
+    write(data.vertices.data(), data.vertices.size());
+    pad_to(header.index_offset);
+    write(data.indices.data(), data.indices.size());
+
+    cut::ensure(file.good(), "Could not write {}!", path.string());
+}
+
+MeshFile::MeshFile(const std::filesystem::path& path) :
+    file_{ path }
+{
+    auto bytes = file_.get_bytes();
+    auto header = read_record<FileHeader>(bytes, 0);
+    cut::ensure(std::memcmp(header.magic, magic, sizeof(magic)) == 0, "{} is not a mesh file!", path.string());
+    cut::ensure(header.version == version, "Unsupported mesh file version {}!", header.version);
+    cut::ensure(header.index_type <= static_cast<u32>(Mesh::IndexType::U32), "Unknown index type!");
+    cut::ensure(header.vertex_offset <= bytes.size() && header.vertex_size <= bytes.size() - header.vertex_offset &&
+                header.index_offset <= bytes.size() && header.index_size <= bytes.size() - header.index_offset, "Mesh file is truncated!");
+    cut::ensure(header.stride > 0 && header.vertex_size % header.stride == 0, "Vertex data doesn't match the stride!");
+
+    // Everything is checked here so create_mesh never uploads out of range data
+    u32 index_size = Mesh::to_size(static_cast<Mesh::IndexType>(header.index_type));
+    cut::ensure(header.index_size % index_size == 0, "Index data doesn't match the index type!");
+    std::uint64_t index_count = header.index_size / index_size;
+
+    size_t offset = sizeof(FileHeader);
+    for (u32 i = 0; i < header.attribute_count; ++i, offset += sizeof(FileAttribute)) {
+        auto record = read_record<FileAttribute>(bytes, offset);
+        VertexDataType type = to_vertex_data_type(record.type);
+        cut::ensure(static_cast<std::uint64_t>(record.offset) + to_attribute_format(type).size <= header.stride,
+                    "Vertex attribute {} reaches past the stride!", i);
+        attributes_.push_back({ type, record.offset });
+    }
+    for (u32 i = 0; i < header.lod_count; ++i, offset += sizeof(FileLod)) {
+        auto record = read_record<FileLod>(bytes, offset);
+        cut::ensure(static_cast<std::uint64_t>(record.first_index) + record.index_count <= index_count,
+                    "LOD {} reaches past the index data!", i);
+        lods_.push_back({ record.first_index, record.index_count, record.error });
+    }
+
+    data_ = {
+        bytes.subspan(header.vertex_offset, header.vertex_size),
+        header.stride,
+        attributes_,
+        bytes.subspan(header.index_offset, header.index_size),
+        static_cast<Mesh::IndexType>(header.index_type),
+        lods_
+    };
+    std::memcpy(&data_.position_scale, header.position_scale, sizeof(header.position_scale));
+    std::memcpy(&data_.position_offset, header.position_offset, sizeof(header.position_offset));
+    std::memcpy(&data_.uv_scale, header.uv_scale, sizeof(header.uv_scale));
+    std::memcpy(&data_.uv_offset, header.uv_offset, sizeof(header.uv_offset));
+}
+
+VertexFormat MeshFile::get_format() const {
+    return { attributes_, data_.stride, hash_vertex_attributes(attributes_) };
+}
+
+Mesh MeshFile::create_mesh(VertexArrayCache& vertex_array_cache) const {
+    Mesh mesh(data_.vertices, data_.indices, data_.index_type, get_format(), vertex_array_cache);
+    if (!data_.lods.empty()) mesh.set_lods(data_.lods);
+    return mesh;
+}
+
+} // namespace glw
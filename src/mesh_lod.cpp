@@ -0,0 +1,356 @@
+#include "glw/mesh_lod.hpp"
+
+#include <cut/exception.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+
+namespace {
+
+using namespace glw;
+using u64 = std::uint64_t;
+
+struct Quadric {
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+    double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+    double a22 = 0.0, a23 = 0.0;
+    double a33 = 0.0;
+    double weight = 0.0;
+
+    void add_plane(double nx, double ny, double nz, double d, double w) {
+        a00 += w * nx * nx; a01 += w * nx * ny; a02 += w * nx * nz; a03 += w * nx * d;
+        a11 += w * ny * ny; a12 += w * ny * nz; a13 += w * ny * d;
+        a22 += w * nz * nz; a23 += w * nz * d;
+        a33 += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric& other) {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+        a11 += other.a11; a12 += other.a12; a13 += other.a13;
+        a22 += other.a22; a23 += other.a23;
+        a33 += other.a33;
+        weight += other.weight;
+    }
+
+    double evaluate(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        return a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x +
+               a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y +
+               a22 * z * z + 2.0 * a23 * z +
+               a33;
+    }
+};
+
+struct Collapse {
+    f32 cost;
+    u32 from;
+    u32 to;
+    u32 from_version;
+    u32 to_version;
+
+    bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+class Simplifier {
+public:
+    Simplifier(const LodSource& source, std::span<const u32> indices) :
+        source_(source),
+        vertex_count_(cut::to_u32(source.vertices.size() / source.stride)),
+        positions_(vertex_count_),
+        quadrics_(vertex_count_),
+        vertex_triangles_(vertex_count_),
+        locked_(vertex_count_, false),
+        dead_(vertex_count_, false),
+        versions_(vertex_count_, 0)
+    {
+        for (u32 v = 0; v < vertex_count_; ++v) {
+            std::memcpy(&positions_[v], source.vertices.data() + static_cast<size_t>(v) * source.stride + source.position_offset, sizeof(glm::vec3));
+        }
+
+        triangles_.reserve(indices.size());
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            u32 a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            if (a == b || b == c || a == c) continue;
+            triangles_.insert(triangles_.end(), { a, b, c });
+        }
+        u32 triangle_count = cut::to_u32(triangles_.size() / 3);
+        alive_.assign(triangle_count, true);
+        live_index_count_ = cut::to_u32(triangles_.size());
+
+        std::vector<u64> edges;
+        edges.reserve(triangles_.size());
+        for (u32 t = 0; t < triangle_count; ++t) {
+            const u32* tri = &triangles_[t * 3];
+            glm::vec3 normal = glm::cross(positions_[tri[1]] - positions_[tri[0]], positions_[tri[2]] - positions_[tri[0]]);
+            f32 length = glm::length(normal);
+            if (length > 0.0f) {
+                normal /= length;
+                Quadric plane;
+                plane.add_plane(normal.x, normal.y, normal.z, -glm::dot(normal, positions_[tri[0]]), length * 0.5);
+                for (u32 k = 0; k < 3; ++k) quadrics_[tri[k]].add(plane);
+            }
+
+            for (u32 k = 0; k < 3; ++k) {
+                vertex_triangles_[tri[k]].push_back(t);
+
+                u32 a = tri[k], b = tri[(k + 1) % 3];
+                edges.push_back(static_cast<u64>(std::min(a, b)) << 32 | std::max(a, b));
+            }
+        }
+
+        // Edges not shared by exactly two triangles are borders, UV/normal seams or non-manifold
+        std::ranges::sort(edges);
+        for (size_t i = 0; i < edges.size();) {
+            size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i]) ++j;
+
+            u32 a = static_cast<u32>(edges[i] >> 32);
+            u32 b = static_cast<u32>(edges[i]);
+            if (j - i != 2) {
+                locked_[a] = true;
+                locked_[b] = true;
+            }
+            i = j;
+        }
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        for (u64 edge : edges) {
+            u32 a = static_cast<u32>(edge >> 32);
+            u32 b = static_cast<u32>(edge);
+            push_collapse(a, b);
+            push_collapse(b, a);
+        }
+    }
+
+    f32 run(u32 target_index_count, f32 target_error) {
+        f32 target_cost = target_error * target_error;
+        f32 max_cost = 0.0f;
+        while (live_index_count_ > target_index_count && !heap_.empty()) {
+            Collapse collapse = heap_.top();
+            heap_.pop();
+
+            if (dead_[collapse.from] || dead_[collapse.to] ||
+                versions_[collapse.from] != collapse.from_version ||
+                versions_[collapse.to] != collapse.to_version) continue;
+
+            if (collapse.cost > target_cost) break;
+            if (!is_valid(collapse.from, collapse.to)) continue;
+
+            perform(collapse.from, collapse.to);
+            max_cost = std::max(max_cost, collapse.cost);
+        }
+        return std::sqrt(max_cost);
+    }
+
+    std::vector<u32> get_indices() const {
+        std::vector<u32> result;
+        result.reserve(live_index_count_);
+        for (u32 t = 0; t < alive_.size(); ++t) {
+            if (alive_[t]) result.insert(result.end(), triangles_.begin() + t * 3, triangles_.begin() + t * 3 + 3);
+        }
+        return result;
+    }
+private:
+    f32 collapse_cost(u32 from, u32 to) const {
+        Quadric quadric = quadrics_[from];
+        quadric.add(quadrics_[to]);
+        double cost = quadric.weight > 0.0 ? quadric.evaluate(positions_[to]) / quadric.weight : 0.0;
+
+        for (const auto& attribute : source_.attributes) {
+            const std::byte* from_data = source_.vertices.data() + static_cast<size_t>(from) * source_.stride + attribute.offset;
+            const std::byte* to_data = source_.vertices.data() + static_cast<size_t>(to) * source_.stride + attribute.offset;
+            for (u32 c = 0; c < attribute.count; ++c) {
+                f32 a, b;
+                std::memcpy(&a, from_data + c * sizeof(f32), sizeof(f32));
+                std::memcpy(&b, to_data + c * sizeof(f32), sizeof(f32));
+                cost += attribute.weight * (a - b) * (a - b);
+            }
+        }
+        return static_cast<f32>(std::max(cost, 0.0));
+    }
+
+    void push_collapse(u32 from, u32 to) {
+        if (locked_[from]) return;
+
+        heap_.push({ collapse_cost(from, to), from, to, versions_[from], versions_[to] });
+    }
+
+    void gather_neighbors(u32 v, std::vector<u32>& neighbors) const {
+        neighbors.clear();
+        for (u32 t : vertex_triangles_[v]) {
+            if (!alive_[t]) continue;
+            for (u32 k = 0; k < 3; ++k) {
+                if (triangles_[t * 3 + k] != v) neighbors.push_back(triangles_[t * 3 + k]);
+            }
+        }
+        std::ranges::sort(neighbors);
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    }
+
+    bool is_valid(u32 from, u32 to) {
+        // Link condition: vertices shared by both ends must be exactly the ones opposite to the edge
+        gather_neighbors(from, from_neighbors_);
+        gather_neighbors(to, to_neighbors_);
+        u32 shared_vertices = 0;
+        for (u32 n : from_neighbors_) {
+            if (std::ranges::binary_search(to_neighbors_, n)) shared_vertices++;
+        }
+
+        u32 edge_triangles = 0;
+        for (u32 t : vertex_triangles_[from]) {
+            if (!alive_[t]) continue;
+
+            const u32* tri = &triangles_[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                edge_triangles++;
+                continue;
+            }
+
+            // Reject collapses that flip or degenerate remaining triangles
+            glm::vec3 p[3], q[3];
+            for (u32 k = 0; k < 3; ++k) {
+                p[k] = positions_[tri[k]];
+                q[k] = tri[k] == from ? positions_[to] : p[k];
+            }
+            glm::vec3 old_normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 new_normal = glm::cross(q[1] - q[0], q[2] - q[0]);
+            f32 old_length = glm::length(old_normal);
+            f32 new_length = glm::length(new_normal);
+            if (new_length <= 1e-6f * old_length) return false;
+            if (glm::dot(old_normal, new_normal) < 0.25f * old_length * new_length) return false;
+        }
+
+        return edge_triangles > 0 && shared_vertices == edge_triangles;
+    }
+
+    void perform(u32 from, u32 to) {
+        auto& to_triangles = vertex_triangles_[to];
+        for (u32 t : vertex_triangles_[from]) {
+            if (!alive_[t]) continue;
+
+            u32* tri = &triangles_[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                alive_[t] = false;
+                live_index_count_ -= 3;
+                continue;
+            }
+
+            for (u32 k = 0; k < 3; ++k) {
+                if (tri[k] == from) tri[k] = to;
+            }
+            to_triangles.push_back(t);
+        }
+        std::erase_if(to_triangles, [this](u32 t) { return !alive_[t]; });
+
+        quadrics_[to].add(quadrics_[from]);
+        dead_[from] = true;
+        vertex_triangles_[from].clear();
+        versions_[to]++;
+
+        gather_neighbors(to, to_neighbors_);
+        for (u32 n : to_neighbors_) {
+            push_collapse(to, n);
+            push_collapse(n, to);
+        }
+    }
+
+    const LodSource& source_;
+    u32 vertex_count_;
+    std::vector<glm::vec3> positions_;
+    std::vector<Quadric> quadrics_;
+    std::vector<std::vector<u32>> vertex_triangles_;
+    std::vector<bool> locked_;
+    std::vector<bool> dead_;
+    std::vector<u32> versions_;
+    std::vector<u32> triangles_;
+    std::vector<bool> alive_;
+    u32 live_index_count_ = 0;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap_;
+    std::vector<u32> from_neighbors_;
+    std::vector<u32> to_neighbors_;
+};
+
+} // namespace
+
+namespace glw {
+
+std::vector<u32> simplify(const LodSource& source, std::span<const u32> indices,
+                          u32 target_index_count, f32 target_error, f32* result_error) {
+    cut::ensure(source.stride > 0 && source.vertices.size() % source.stride == 0, "Vertex data doesn't match the stride!");
+    cut::ensure(indices.size() % 3 == 0, "Only triangle lists can be simplified!");
+
+    Simplifier simplifier{ source, indices };
+    f32 error = simplifier.run(target_index_count, target_error);
+    if (result_error) *result_error = error;
+    return simplifier.get_indices();
+}
+
+LodChain build_lod_chain(const LodSource& source, const LodDescription& desc) {
+    cut::ensure(source.stride > 0 && source.vertices.size() % source.stride == 0, "Vertex data doesn't match the stride!");
+
+    LodChain chain;
+    chain.indices.assign(source.indices.begin(), source.indices.end());
+    chain.levels.push_back({ 0, cut::to_u32(source.indices.size()), 0.0f });
+
+    u32 vertex_count = cut::to_u32(source.vertices.size() / source.stride);
+    if (vertex_count == 0) return chain;
+
+    glm::vec3 min_position, max_position;
+    std::memcpy(&min_position, source.vertices.data() + source.position_offset, sizeof(glm::vec3));
+    max_position = min_position;
+    for (u32 v = 1; v < vertex_count; ++v) {
+        glm::vec3 position;
+        std::memcpy(&position, source.vertices.data() + static_cast<size_t>(v) * source.stride + source.position_offset, sizeof(glm::vec3));
+        min_position = glm::min(min_position, position);
+        max_position = glm::max(max_position, position);
+    }
+    f32 target_error = desc.max_relative_error * glm::length(max_position - min_position);
+
+    std::vector<u32> current(source.indices.begin(), source.indices.end());
+    f32 error = 0.0f;
+    for (u32 level = 1; level < desc.max_levels; ++level) {
+        u32 target_index_count = static_cast<u32>(current.size() * desc.reduction) / 3 * 3;
+        if (target_index_count == 0) break;
+
+        f32 level_error;
+        std::vector<u32> next = simplify(source, current, target_index_count, target_error, &level_error);
+        if (next.empty() || next.size() > current.size() * 0.95f) break;
+
+        // Each level is simplified from the previous one so errors add up
+        error += level_error;
+        chain.levels.push_back({ cut::to_u32(chain.indices.size()), cut::to_u32(next.size()), error });
+        chain.indices.insert(chain.indices.end(), next.begin(), next.end());
+        current = std::move(next);
+    }
+    return chain;
+}
+
+std::vector<LodChain> build_lod_chains(std::span<const LodSource> sources, const LodDescription& desc, ThreadPool& thread_pool) {
+    std::vector<LodChain> chains(sources.size());
+    thread_pool.parallel_for(sources.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            chains[i] = build_lod_chain(sources[i], desc);
+        }
+    });
+    return chains;
+}
+
+u32 select_lod(std::span<const LodLevel> levels, f32 distance, f32 fov_y, f32 viewport_height, f32 threshold_pixels) {
+    if (levels.empty() || distance <= 0.0f) return 0;
+
+    f32 pixels_per_unit = viewport_height / (2.0f * distance * std::tan(fov_y * 0.5f));
+    u32 selected = 0;
+    for (u32 i = 1; i < levels.size(); ++i) {
+        if (levels[i].error * pixels_per_unit > threshold_pixels) break;
+        selected = i;
+    }
+    return selected;
+}
+
+} // namespace glw
@@ -0,0 +1,335 @@
+#include "glw/mesh_optimizer.hpp"
+
+#include <cut/exception.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+using namespace glw;
+using cut::u8;
+using cut::u16;
+using cut::s32;
+
+constexpr u32 invalid_index = ~0u;
+
+// Forsyth, "Linear-Speed Vertex Cache Optimisation"
+constexpr u32 forsyth_cache_size = 32;
+constexpr u32 forsyth_max_valence = 32;
+
+struct ForsythTables {
+    std::array<f32, forsyth_cache_size> cache_scores;
+    std::array<f32, forsyth_max_valence + 1> valence_scores;
+};
+
+constexpr f32 last_triangle_score = 0.75f;
+
+ForsythTables make_forsyth_tables() {
+    ForsythTables tables;
+    for (u32 i = 0; i < forsyth_cache_size; ++i) {
+        tables.cache_scores[i] = i < 3 ? last_triangle_score :
+            std::pow(1.0f - static_cast<f32>(i - 3) / (forsyth_cache_size - 3), 1.5f);
+    }
+    tables.valence_scores[0] = 0.0f;
+    for (u32 i = 1; i <= forsyth_max_valence; ++i) {
+        tables.valence_scores[i] = 2.0f / std::sqrt(static_cast<f32>(i));
+    }
+    return tables;
+}
+
+f32 forsyth_vertex_score(const ForsythTables& tables, s32 cache_position, u32 live_triangles) {
+    if (live_triangles == 0) return -1.0f;
+
+    f32 score = cache_position >= 0 ? tables.cache_scores[cache_position] : 0.0f;
+    return score + tables.valence_scores[std::min(live_triangles, forsyth_max_valence)];
+}
+
+glm::vec3 load_position(std::span<const std::byte> vertices, u32 stride, u32 position_offset, u32 index) {
+    glm::vec3 position;
+    std::memcpy(&position, vertices.data() + static_cast<size_t>(index) * stride + position_offset, sizeof(position));
+    return position;
+}
+
+template<typename T>
+void write_indices(std::span<const u32> indices, std::vector<std::byte>& bytes) {
+    bytes.resize(indices.size() * sizeof(T));
+    T* out = reinterpret_cast<T*>(bytes.data());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        out[i] = static_cast<T>(indices[i]);
+    }
+}
+
+} // namespace
+
+namespace glw {
+
+VertexCacheStats analyze_vertex_cache(std::span<const u32> indices, u32 vertex_count, u32 cache_size) {
+    if (indices.empty()) return {};
+
+    // A vertex is cached if fewer than cache_size misses happened since it was loaded
+    std::vector<u32> load_times(vertex_count, 0);
+    std::vector<bool> referenced(vertex_count, false);
+    u32 timestamp = cache_size + 1;
+    u32 misses = 0;
+    u32 unique_vertices = 0;
+    for (u32 index : indices) {
+        if (timestamp - load_times[index] > cache_size) {
+            load_times[index] = timestamp++;
+            misses++;
+        }
+        if (!referenced[index]) {
+            referenced[index] = true;
+            unique_vertices++;
+        }
+    }
+
+    return {
+        .acmr = static_cast<f32>(misses) / (indices.size() / 3),
+        .atvr = static_cast<f32>(misses) / unique_vertices
+    };
+}
+
+void optimize_vertex_cache(std::span<u32> indices, u32 vertex_count) {
+    static const ForsythTables tables = make_forsyth_tables();
+
+    u32 triangle_count = cut::to_u32(indices.size() / 3);
+    if (triangle_count == 0) return;
+
+    // Triangles adjacent to each vertex, live ones are kept at the front of each range
+    std::vector<u32> live_triangles(vertex_count, 0);
+    for (u32 index : indices) {
+        live_triangles[index]++;
+    }
+    std::vector<u32> adjacency_offsets(vertex_count + 1, 0);
+    std::inclusive_scan(live_triangles.begin(), live_triangles.end(), adjacency_offsets.begin() + 1);
+    std::vector<u32> adjacency(indices.size());
+    {
+        std::vector<u32> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+        for (u32 i = 0; i < indices.size(); ++i) {
+            adjacency[fill[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<s32> cache_positions(vertex_count, -1);
+    std::vector<f32> vertex_scores(vertex_count);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        vertex_scores[v] = forsyth_vertex_score(tables, -1, live_triangles[v]);
+    }
+
+    std::vector<f32> triangle_scores(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    u32 best_triangle = 0;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        triangle_scores[t] = vertex_scores[indices[t * 3]] +
+                             vertex_scores[indices[t * 3 + 1]] +
+                             vertex_scores[indices[t * 3 + 2]];
+        if (triangle_scores[t] > triangle_scores[best_triangle]) best_triangle = t;
+    }
+
+    std::vector<u32> output(indices.size());
+    std::array<u32, forsyth_cache_size + 3> cache;
+    std::array<u32, forsyth_cache_size + 3> new_cache;
+    u32 cache_count = 0;
+    u32 scan_cursor = 0;
+
+    for (u32 output_triangle = 0; output_triangle < triangle_count; ++output_triangle) {
+        if (best_triangle == invalid_index) {
+            while (emitted[scan_cursor]) scan_cursor++;
+            best_triangle = scan_cursor;
+        }
+
+        const u32* triangle = &indices[best_triangle * 3];
+        std::copy(triangle, triangle + 3, output.begin() + output_triangle * 3);
+        emitted[best_triangle] = true;
+
+        u32 new_cache_count = 0;
+        for (u32 k = 0; k < 3; ++k) {
+            u32 v = triangle[k];
+            u32* begin = adjacency.data() + adjacency_offsets[v];
+            u32* last = begin + live_triangles[v] - 1;
+            std::swap(*std::find(begin, last, best_triangle), *last);
+            live_triangles[v]--;
+
+            new_cache[new_cache_count++] = v;
+        }
+        for (u32 i = 0; i < cache_count; ++i) {
+            u32 v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                new_cache[new_cache_count++] = v;
+            }
+        }
+
+        for (u32 i = 0; i < new_cache_count; ++i) {
+            u32 v = new_cache[i];
+            cache_positions[v] = i < forsyth_cache_size ? static_cast<s32>(i) : -1;
+            vertex_scores[v] = forsyth_vertex_score(tables, cache_positions[v], live_triangles[v]);
+        }
+
+        best_triangle = invalid_index;
+        f32 best_score = -1.0f;
+        for (u32 i = 0; i < new_cache_count; ++i) {
+            u32 v = new_cache[i];
+            const u32* adjacent = adjacency.data() + adjacency_offsets[v];
+            for (u32 j = 0; j < live_triangles[v]; ++j) {
+                u32 t = adjacent[j];
+                triangle_scores[t] = vertex_scores[indices[t * 3]] +
+                                     vertex_scores[indices[t * 3 + 1]] +
+                                     vertex_scores[indices[t * 3 + 2]];
+                if (triangle_scores[t] > best_score) {
+                    best_score = triangle_scores[t];
+                    best_triangle = t;
+                }
+            }
+        }
+
+        cache_count = std::min(new_cache_count, forsyth_cache_size);
+        std::copy(new_cache.begin(), new_cache.begin() + cache_count, cache.begin());
+    }
+
+    std::ranges::copy(output, indices.begin());
+}
+
+void optimize_overdraw(std::span<u32> indices, std::span<const std::byte> vertices, u32 stride, u32 position_offset) {
+    u32 triangle_count = cut::to_u32(indices.size() / 3);
+    if (triangle_count == 0) return;
+
+    // Cluster boundaries are placed where the cache gets refilled, so reordering clusters keeps ACMR
+    constexpr u32 cache_size = 16;
+    u32 vertex_count = cut::to_u32(vertices.size() / stride);
+    std::vector<u32> load_times(vertex_count, 0);
+    u32 timestamp = cache_size + 1;
+    std::vector<u32> cluster_starts;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        u32 misses = 0;
+        for (u32 k = 0; k < 3; ++k) {
+            u32 index = indices[t * 3 + k];
+            if (timestamp - load_times[index] > cache_size) {
+                load_times[index] = timestamp++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) cluster_starts.push_back(t);
+    }
+    cluster_starts.push_back(triangle_count);
+
+    u32 cluster_count = cut::to_u32(cluster_starts.size() - 1);
+    std::vector<glm::vec3> centroids(cluster_count, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(cluster_count, glm::vec3(0.0f));
+    glm::vec3 mesh_centroid(0.0f);
+    f32 mesh_area = 0.0f;
+    for (u32 c = 0; c < cluster_count; ++c) {
+        f32 cluster_area = 0.0f;
+        for (u32 t = cluster_starts[c]; t < cluster_starts[c + 1]; ++t) {
+            glm::vec3 p0 = load_position(vertices, stride, position_offset, indices[t * 3]);
+            glm::vec3 p1 = load_position(vertices, stride, position_offset, indices[t * 3 + 1]);
+            glm::vec3 p2 = load_position(vertices, stride, position_offset, indices[t * 3 + 2]);
+
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            f32 area = glm::length(normal);
+            centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+            normals[c] += normal;
+            cluster_area += area;
+        }
+
+        mesh_centroid += centroids[c];
+        mesh_area += cluster_area;
+        centroids[c] = cluster_area > 0.0f ? centroids[c] / cluster_area :
+            load_position(vertices, stride, position_offset, indices[cluster_starts[c] * 3]);
+    }
+    if (mesh_area > 0.0f) mesh_centroid /= mesh_area;
+
+    std::vector<f32> sort_keys(cluster_count);
+    for (u32 c = 0; c < cluster_count; ++c) {
+        f32 normal_length = glm::length(normals[c]);
+        sort_keys[c] = normal_length > 0.0f ? glm::dot(centroids[c] - mesh_centroid, normals[c] / normal_length) : 0.0f;
+    }
+
+    std::vector<u32> order(cluster_count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::ranges::stable_sort(order, [&](u32 a, u32 b) { return sort_keys[a] > sort_keys[b]; });
+
+    std::vector<u32> output;
+    output.reserve(indices.size());
+    for (u32 c : order) {
+        output.insert(output.end(), indices.begin() + cluster_starts[c] * 3, indices.begin() + cluster_starts[c + 1] * 3);
+    }
+    std::ranges::copy(output, indices.begin());
+}
+
+u32 optimize_vertex_fetch(std::span<std::byte> vertices, u32 stride, std::span<u32> indices) {
+    u32 vertex_count = cut::to_u32(vertices.size() / stride);
+    std::vector<u32> remap(vertex_count, invalid_index);
+    u32 next_vertex = 0;
+    for (u32& index : indices) {
+        if (remap[index] == invalid_index) remap[index] = next_vertex++;
+        index = remap[index];
+    }
+
+    std::vector<std::byte> reordered(static_cast<size_t>(next_vertex) * stride);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        if (remap[v] == invalid_index) continue;
+
+        std::memcpy(reordered.data() + static_cast<size_t>(remap[v]) * stride,
+                    vertices.data() + static_cast<size_t>(v) * stride, stride);
+    }
+    std::ranges::copy(reordered, vertices.begin());
+    return next_vertex;
+}
+
+Mesh::IndexType to_smallest_index_type(u32 vertex_count) {
+    return vertex_count <= std::numeric_limits<u16>::max() + 1u ? Mesh::IndexType::U16 : Mesh::IndexType::U32;
+}
+
+std::vector<std::byte> narrow_indices(std::span<const u32> indices, Mesh::IndexType index_type) {
+    std::vector<std::byte> bytes;
+    switch (index_type) {
+    using enum Mesh::IndexType;
+    case U8:  write_indices<u8>(indices, bytes); break;
+    case U16: write_indices<u16>(indices, bytes); break;
+    case U32: write_indices<u32>(indices, bytes); break;
+    }
+    return bytes;
+}
+
+OptimizedMesh optimize_mesh(const MeshSource& source) {
+    cut::ensure(source.stride > 0 && source.vertices.size() % source.stride == 0, "Vertex data doesn't match the stride!");
+    cut::ensure(source.indices.size() % 3 == 0, "Only triangle lists can be optimized!");
+
+    u32 vertex_count = cut::to_u32(source.vertices.size() / source.stride);
+    cut::ensure(std::ranges::all_of(source.indices, [=](u32 index) { return index < vertex_count; }),
+        "Index out of vertex range!");
+
+    OptimizedMesh result;
+    result.vertices.assign(source.vertices.begin(), source.vertices.end());
+    std::vector<u32> indices(source.indices.begin(), source.indices.end());
+
+    result.before = analyze_vertex_cache(indices, vertex_count);
+    optimize_vertex_cache(indices, vertex_count);
+    optimize_overdraw(indices, result.vertices, source.stride, source.position_offset);
+    vertex_count = optimize_vertex_fetch(result.vertices, source.stride, indices);
+    result.vertices.resize(static_cast<size_t>(vertex_count) * source.stride);
+    result.after = analyze_vertex_cache(indices, vertex_count);
+
+    result.index_type = to_smallest_index_type(vertex_count);
+    result.indices = narrow_indices(indices, result.index_type);
+    return result;
+}
+
+std::vector<OptimizedMesh> optimize_meshes(std::span<const MeshSource> sources, ThreadPool& thread_pool) {
+    std::vector<OptimizedMesh> results(sources.size());
+    thread_pool.parallel_for(sources.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = optimize_mesh(sources[i]);
+        }
+    });
+    return results;
+}
+
+} // namespace glw
@@ -0,0 +1,202 @@
+#include "glw/occlusion_culler.hpp"
+#include "glw/glw.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+namespace {
+
+using namespace glw;
+
+using cut::u16;
+
+using ProxyLayout = VertexLayout<glm::vec3>;
+
+constexpr u32 proxy_vertex_count = 8;
+
+constexpr std::string_view vertex_source = R"(#version 450 core
+layout(location = 0) in vec3 a_position;
+uniform mat4 u_view_projection;
+void main() {
+    gl_Position = u_view_projection * vec4(a_position, 1.0);
+}
+)";
+
+// Depth tested before the empty shader runs, so hidden proxies never reach it
+constexpr std::string_view fragment_source = R"(#version 450 core
+layout(early_fragment_tests) in;
+void main() {}
+)";
+
+/*
+* Outward facing triangles of a box whose corner i takes max along x, y and z for bits 0, 1 and 2
+*/
+constexpr std::array<u16, 36> proxy_indices = {
+    0, 4, 6, 0, 6, 2, // -X
+    1, 3, 7, 1, 7, 5, // +X
+    0, 1, 5, 0, 5, 4, // -Y
+    2, 6, 7, 2, 7, 3, // +Y
+    0, 2, 3, 0, 3, 1, // -Z
+    4, 5, 7, 4, 7, 6  // +Z
+};
+
+Shader make_shader() {
+    ShaderStage vertex(ShaderStage::Type::Vertex, std::array{ vertex_source });
+    ShaderStage fragment(ShaderStage::Type::Fragment, std::array{ fragment_source });
+    const ShaderStage* stages[] = { &vertex, &fragment };
+    return Shader(stages);
+}
+
+bool contains(const OcclusionBounds& bounds, const glm::vec3& point, f32 margin) {
+    for (int axis = 0; axis < 3; ++axis) {
+        if (point[axis] < bounds.min[axis] - margin || point[axis] > bounds.max[axis] + margin) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+namespace glw {
+
+OcclusionCuller::OcclusionCuller(const OcclusionCullerDescription& desc) :
+    desc_{ desc },
+    queries_(static_cast<size_t>(desc.frame_latency) * desc.max_objects),
+    pending_(desc.frame_latency),
+    visible_until_(desc.max_objects),
+    query_frames_(desc.max_objects),
+    shader_{ make_shader() },
+    index_buffer_{ std::as_bytes(std::span{ proxy_indices }) },
+    vertex_buffer_{ queries_.size() * proxy_vertex_count * sizeof(glm::vec3), BufferUsage::PersistentWrite },
+    vertex_array_{ ProxyLayout::get_format() },
+    fences_(desc.frame_latency)
+{
+    cut::ensure(desc.frame_latency > 0 && desc.max_objects > 0, "Occlusion culler needs frames and objects!");
+
+    GLenum target = desc.conservative ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+    glCreateQueries(target, static_cast<GLsizei>(queries_.size()), queries_.data());
+
+    vertex_array_.set_vertex_buffer(vertex_buffer_);
+    vertex_array_.set_index_buffer(index_buffer_);
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    glDeleteQueries(static_cast<GLsizei>(queries_.size()), queries_.data());
+}
+
+void OcclusionCuller::begin_frame() {
+    u32 latency = desc_.frame_latency;
+    u32 slot = frame_index_ % latency;
+
+    // The GPU is done with the queries of the slot about to be reused once its fence signals,
+    // so every one of them can be read back before the slot is cleared
+    auto& fence = fences_[slot];
+    if (fence) {
+        fence->wait();
+        fence.reset();
+    }
+
+    stats_.occluded = 0;
+    // Oldest first so newer results win
+    for (u32 age = std::min(frame_index_, latency); age >= 1; --age) {
+        resolve((frame_index_ - age) % latency);
+    }
+
+    stats_.dropped_results += cut::to_u32(pending_[slot].size());
+    pending_[slot].clear();
+}
+
+void OcclusionCuller::query(std::span<const OcclusionBounds> objects, const glm::mat4& view_projection, const glm::vec3& camera_position) {
+    cut::ensure(objects.size() <= desc_.max_objects, "Too many occlusion objects!");
+
+    u32 slot = frame_index_ % desc_.frame_latency;
+    size_t first_query = static_cast<size_t>(slot) * desc_.max_objects;
+    auto vertices = reinterpret_cast<glm::vec3*>(vertex_buffer_.get_mapping().data()) + first_query * proxy_vertex_count;
+    auto& pending = pending_[slot];
+    GLenum target = desc_.conservative ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+
+    shader_.set_uniform_mat4f("u_view_projection", view_projection);
+    shader_.bind();
+    vertex_array_.bind();
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+
+    stats_.objects = cut::to_u32(objects.size());
+    stats_.queries = 0;
+    for (u32 i = 0; i < objects.size(); ++i) {
+        if (frame_index_ < visible_until_[i]) continue;
+
+        // Proxy faces behind the near plane would hide an object the camera is in
+        const auto& bounds = objects[i];
+        if (contains(bounds, camera_position, desc_.near_plane)) {
+            visible_until_[i] = frame_index_ + 1;
+            continue;
+        }
+
+        glm::vec3* proxy = vertices + static_cast<size_t>(i) * proxy_vertex_count;
+        for (u32 corner = 0; corner < proxy_vertex_count; ++corner) {
+            proxy[corner] = { corner & 1 ? bounds.max.x : bounds.min.x,
+                              corner & 2 ? bounds.max.y : bounds.min.y,
+                              corner & 4 ? bounds.max.z : bounds.min.z };
+        }
+
+        glBeginQuery(target, queries_[first_query + i]);
+        glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(proxy_indices.size()), GL_UNSIGNED_SHORT, nullptr,
+                                 static_cast<GLint>((first_query + i) * proxy_vertex_count));
+        glEndQuery(target);
+
+        query_frames_[i] = frame_index_ + 1;
+        pending.push_back(i);
+        stats_.queries++;
+    }
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+}
+
+void OcclusionCuller::begin_conditional(u32 object) {
+    cut::ensure(!conditional_, "Occlusion conditionals can't nest!");
+    if (!is_queried(object)) return;
+
+    size_t query = static_cast<size_t>(frame_index_ % desc_.frame_latency) * desc_.max_objects + object;
+    glBeginConditionalRender(queries_[query], GL_QUERY_NO_WAIT);
+    conditional_ = true;
+}
+
+void OcclusionCuller::end_conditional() {
+    if (!conditional_) return;
+
+    glEndConditionalRender();
+    conditional_ = false;
+}
+
+void OcclusionCuller::end_frame() {
+    fences_[frame_index_ % desc_.frame_latency].emplace();
+    frame_index_++;
+}
+
+void OcclusionCuller::resolve(u32 slot) {
+    auto& pending = pending_[slot];
+    const u32* queries = &queries_[static_cast<size_t>(slot) * desc_.max_objects];
+
+    // Results that aren't there yet leave the value alone, they stay pending for the next frame
+    std::erase_if(pending, [&](u32 object) {
+        GLuint64 samples = ~GLuint64{ 0 };
+        glGetQueryObjectui64v(queries[object], GL_QUERY_RESULT_NO_WAIT, &samples);
+        if (samples == ~GLuint64{ 0 }) return false;
+
+        if (samples) {
+            // Between half and all of visible_frames, so objects found visible together come back spread out
+            u32 half = desc_.visible_frames / 2;
+            visible_until_[object] = frame_index_ + half + object % (desc_.visible_frames - half + 1);
+        }
+        else {
+            stats_.occluded++;
+        }
+        return true;
+    });
+}
+
+} // namespace glw
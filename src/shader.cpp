@@ -1,4 +1,5 @@
 #include "glw/shader.hpp"
+#include "glw/capabilities.hpp"
 #include "glw/glw.hpp"
 
 #include <cut/exception.hpp>
@@ -22,6 +23,19 @@ GLenum to_gl_enum(ShaderStage::Type type) {
     return {};
 }
 
+void ensure_compiled(u32 shader) {
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (success != GL_TRUE) {
+        GLint length = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::string infoLog;
+        infoLog.resize(length);
+        glGetShaderInfoLog(shader, length, nullptr, infoLog.data());
+        throw cut::Exception(std::format("Could not compile shader! {}", infoLog));
+    }
+}
+
 } // namespace
 
 namespace glw {
@@ -50,16 +64,8 @@ ShaderStage::ShaderStage(Type type, std::span<const std::string_view> sources) :
     glShaderSource(handle_.get(), gl_sources.size(), gl_sources.data(), gl_lengths.data());
     glCompileShader(handle_.get());
 
-    GLint success;
-    glGetShaderiv(handle_.get(), GL_COMPILE_STATUS, &success);
-    if (success != GL_TRUE) {
-        GLint length = 0;
-        glGetShaderiv(handle_.get(), GL_INFO_LOG_LENGTH, &length);
-        std::string infoLog;
-        infoLog.resize(length);
-        glGetShaderInfoLog(handle_.get(), length, nullptr, infoLog.data());
-        throw cut::Exception(std::format("Could not compile shader! {}", infoLog));
-    };
+    // Asking for the status waits for the compile, with parallel compile that's left to linking
+    if (!get_capabilities().parallel_compile) ensure_compiled(handle_.get());
 }
 
 Shader::Shader(std::span<const ShaderStage* const> shaders) :
@@ -78,6 +84,9 @@ Shader::Shader(std::span<const ShaderStage* const> shaders) :
     GLint success;
     glGetProgramiv(handle_.get(), GL_LINK_STATUS, &success);
     if (success != GL_TRUE) {
+        // A stage that failed to compile explains more than the link log
+        for (auto&& shader : shaders) ensure_compiled(shader->get_native_handle());
+
         GLint length = 0;
         glGetProgramiv(handle_.get(), GL_INFO_LOG_LENGTH, &length);
         std::string infoLog(length, '\0');
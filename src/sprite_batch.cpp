@@ -0,0 +1,214 @@
+#include "glw/sprite_batch.hpp"
+#include "glw/capabilities.hpp"
+#include "glw/glw.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <string>
+#include <string_view>
+
+namespace {
+
+using namespace glw;
+
+using cut::u16;
+
+constexpr u32 no_texture_slot = 0xFFFFFFFF;
+
+constexpr std::string_view vertex_source = R"(#version 450 core
+layout(location = 0) in vec2 a_position;
+layout(location = 1) in vec2 a_uv;
+layout(location = 2) in vec4 a_color;
+layout(location = 3) in uint a_texture_slot;
+uniform mat4 u_view_projection;
+out vec2 v_uv;
+out vec4 v_color;
+flat out uint v_texture_slot;
+void main() {
+    v_uv = a_uv;
+    v_color = a_color;
+    v_texture_slot = a_texture_slot;
+    gl_Position = u_view_projection * vec4(a_position, 0.0, 1.0);
+}
+)";
+
+// Loop indices are dynamically uniform where the slot isn't, derivatives are taken outside the branch
+constexpr std::string_view fragment_source = R"(
+in vec2 v_uv;
+in vec4 v_color;
+flat in uint v_texture_slot;
+layout(binding = 0) uniform sampler2D u_textures[GLW_SPRITE_TEXTURE_SLOTS];
+out vec4 o_color;
+void main() {
+    vec2 uv_dx = dFdx(v_uv);
+    vec2 uv_dy = dFdy(v_uv);
+    vec4 texel = vec4(1.0);
+    for (uint i = 0u; i < GLW_SPRITE_TEXTURE_SLOTS; ++i) {
+        if (i == v_texture_slot) texel = textureGrad(u_textures[i], v_uv, uv_dx, uv_dy);
+    }
+    o_color = texel * v_color;
+}
+)";
+
+Shader make_shader(u32 slot_count) {
+    std::string header = std::format("#version 450 core\n#define GLW_SPRITE_TEXTURE_SLOTS {}u\n", slot_count);
+    ShaderStage vertex(ShaderStage::Type::Vertex, std::array{ vertex_source });
+    ShaderStage fragment(ShaderStage::Type::Fragment, std::array{ std::string_view{ header }, fragment_source });
+    const ShaderStage* stages[] = { &vertex, &fragment };
+    return Shader(stages);
+}
+
+// Every slot is sampled by the fragment stage, whose own limit is usually well below the combined one
+u32 to_slot_count(const SpriteBatchDescription& desc) {
+    u32 slot_count = std::min(desc.max_texture_slots, get_capabilities().max_fragment_texture_units);
+    cut::ensure(slot_count > 0, "Sprite batch needs at least one texture slot!");
+    return slot_count;
+}
+
+/*
+* Two triangles per quad over four vertices, shared by every flush through its base vertex
+*/
+struct BlendState {
+    GLboolean enabled;
+    GLint funcs[4];
+};
+
+BlendState get_blend_state() {
+    BlendState state{ glIsEnabled(GL_BLEND), {} };
+    glGetIntegerv(GL_BLEND_SRC_RGB, &state.funcs[0]);
+    glGetIntegerv(GL_BLEND_DST_RGB, &state.funcs[1]);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &state.funcs[2]);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &state.funcs[3]);
+    return state;
+}
+
+void set_blend_state(const BlendState& state) {
+    if (state.enabled) glEnable(GL_BLEND);
+    else glDisable(GL_BLEND);
+    glBlendFuncSeparate(static_cast<GLenum>(state.funcs[0]), static_cast<GLenum>(state.funcs[1]),
+                        static_cast<GLenum>(state.funcs[2]), static_cast<GLenum>(state.funcs[3]));
+}
+
+Buffer make_index_buffer(u32 quad_count) {
+    std::vector<u16> indices(static_cast<size_t>(quad_count) * 6);
+    for (u32 i = 0; i < quad_count; ++i) {
+        auto vertex = static_cast<u16>(i * 4);
+        u16* quad = indices.data() + static_cast<size_t>(i) * 6;
+        quad[0] = vertex;
+        quad[1] = static_cast<u16>(vertex + 1);
+        quad[2] = static_cast<u16>(vertex + 2);
+        quad[3] = static_cast<u16>(vertex + 2);
+        quad[4] = static_cast<u16>(vertex + 3);
+        quad[5] = vertex;
+    }
+    return Buffer(std::as_bytes(std::span{ indices }));
+}
+
+} // namespace
+
+namespace glw {
+
+SpriteBatch::SpriteBatch(const SpriteBatchDescription& desc) :
+    desc_{ desc },
+    slot_count_{ to_slot_count(desc) },
+    arena_quads_{ std::min(desc.max_quads, max_quads_per_draw) },
+    shader_{ make_shader(slot_count_) },
+    sampler_{ desc.sampler },
+    index_buffer_{ make_index_buffer(arena_quads_) },
+    vertex_buffer_{ static_cast<size_t>(desc.max_quads) * 4 * sizeof(SpriteVertex) * desc.frames_in_flight, BufferUsage::PersistentWrite },
+    vertex_array_{ SpriteLayout::get_format() },
+    arena_(static_cast<size_t>(arena_quads_) * 4),
+    fences_(desc.frames_in_flight)
+{
+    static_assert(sizeof(SpriteVertex) == SpriteLayout::stride, "SpriteVertex doesn't match SpriteLayout!");
+    cut::ensure(desc.max_quads > 0, "Sprite batch needs at least one quad!");
+    cut::ensure(desc.frames_in_flight > 0, "Sprite batch needs at least one frame in flight!");
+
+    slots_.reserve(slot_count_);
+    vertex_array_.set_vertex_buffer(vertex_buffer_);
+    vertex_array_.set_index_buffer(index_buffer_);
+}
+
+void SpriteBatch::begin_frame(const glm::mat4& view_projection) {
+    region_ = (region_ + 1) % desc_.frames_in_flight;
+    frame_quads_ = 0;
+    draw_count_ = 0;
+
+    auto& fence = fences_[region_];
+    if (fence) {
+        fence->wait();
+        fence.reset();
+    }
+
+    shader_.set_uniform_mat4f("u_view_projection", view_projection);
+}
+
+void SpriteBatch::draw(const Sprite& sprite) {
+    glm::vec2 max = sprite.position + sprite.size;
+    draw_quad({ sprite.position, glm::vec2{ max.x, sprite.position.y }, max, glm::vec2{ sprite.position.x, max.y } },
+              sprite.uv_rect, sprite.color, sprite.texture);
+}
+
+void SpriteBatch::draw_quad(const std::array<glm::vec2, 4>& corners, const glm::vec4& uv_rect, u32 color, const Texture* texture) {
+    if (pending_quads_ == arena_quads_) flush();
+    u32 slot = to_texture_slot(texture);
+
+    SpriteVertex* quad = arena_.data() + static_cast<size_t>(pending_quads_) * 4;
+    quad[0] = { corners[0], { uv_rect.x, uv_rect.y }, color, slot };
+    quad[1] = { corners[1], { uv_rect.z, uv_rect.y }, color, slot };
+    quad[2] = { corners[2], { uv_rect.z, uv_rect.w }, color, slot };
+    quad[3] = { corners[3], { uv_rect.x, uv_rect.w }, color, slot };
+    ++pending_quads_;
+}
+
+void SpriteBatch::flush() {
+    if (pending_quads_ == 0) return;
+    cut::ensure(frame_quads_ + pending_quads_ <= desc_.max_quads, "Too many sprites in a frame!");
+
+    u32 first_vertex = (region_ * desc_.max_quads + frame_quads_) * 4;
+    std::memcpy(vertex_buffer_.get_mapping().data() + static_cast<size_t>(first_vertex) * sizeof(SpriteVertex),
+                arena_.data(), static_cast<size_t>(pending_quads_) * 4 * sizeof(SpriteVertex));
+
+    for (u32 i = 0; i < slots_.size(); ++i) {
+        slots_[i]->bind(i);
+        sampler_.bind(i);
+    }
+    shader_.bind();
+    vertex_array_.bind();
+    std::optional<BlendState> previous_blend;
+    if (desc_.alpha_blending) {
+        previous_blend = get_blend_state();
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(pending_quads_ * 6), GL_UNSIGNED_SHORT, nullptr,
+                             static_cast<GLint>(first_vertex));
+    if (previous_blend) set_blend_state(*previous_blend);
+
+    frame_quads_ += pending_quads_;
+    pending_quads_ = 0;
+    slots_.clear();
+    ++draw_count_;
+}
+
+void SpriteBatch::end_frame() {
+    flush();
+    fences_[region_].emplace();
+}
+
+u32 SpriteBatch::to_texture_slot(const Texture* texture) {
+    if (!texture) return no_texture_slot;
+
+    // Sprites mostly repeat the texture of the one before
+    for (u32 i = static_cast<u32>(slots_.size()); i-- > 0;) {
+        if (slots_[i] == texture) return i;
+    }
+    if (slots_.size() == slot_count_) flush();
+    slots_.push_back(texture);
+    return static_cast<u32>(slots_.size() - 1);
+}
+
+} // namespace glw
@@ -0,0 +1,176 @@
+#include "glw/static_batch.hpp"
+#include "glw/capabilities.hpp"
+#include "glw/glw.hpp"
+#include "glw/mesh_optimizer.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace glw {
+
+StaticBatch::StaticBatch(const VertexFormat& vertex_format, std::span<const StaticBatchMesh> meshes,
+                         VertexArrayCache& vertex_array_cache, const StaticBatchDescription& desc) :
+    StaticBatch(merge(vertex_format, meshes, desc), vertex_format, vertex_array_cache, desc.indirect_regions) {}
+
+StaticBatch::StaticBatch(Geometry geometry, const VertexFormat& vertex_format, VertexArrayCache& vertex_array_cache, u32 indirect_regions) :
+    mesh_{ geometry.vertices, geometry.indices, geometry.index_type, vertex_format, vertex_array_cache },
+    sub_meshes_{ std::move(geometry.sub_meshes) }
+{
+    cut::ensure(indirect_regions > 0, "Static batch needs at least one indirect region!");
+
+    // Every range is one of the sub meshes at most, so the commands of a draw always fit a region
+    if (get_capabilities().multi_draw_indirect && !sub_meshes_.empty()) {
+        indirect_region_size_ = sub_meshes_.size() * sizeof(IndirectCommand);
+        indirect_commands_.emplace(indirect_region_size_ * indirect_regions, BufferUsage::PersistentWrite);
+        indirect_fences_.resize(indirect_regions);
+    }
+}
+
+StaticBatch::Geometry StaticBatch::merge(const VertexFormat& vertex_format, std::span<const StaticBatchMesh> meshes,
+                                         const StaticBatchDescription& desc) {
+    u32 stride = vertex_format.stride;
+    size_t total_vertices = 0;
+    size_t total_indices = 0;
+    u32 max_vertices = 0;
+    for (const auto& mesh : meshes) {
+        cut::ensure(mesh.vertices.size() % stride == 0, "Vertex data doesn't match the stride!");
+        u32 vertex_count = cut::to_u32(mesh.vertices.size() / stride);
+        total_vertices += vertex_count;
+        total_indices += mesh.indices.size();
+        max_vertices = std::max(max_vertices, vertex_count);
+    }
+
+    Geometry geometry;
+    geometry.index_type = to_smallest_index_type(max_vertices);
+    size_t segment_vertices = geometry.index_type == Mesh::IndexType::U16 ? 65536 : total_vertices;
+
+    geometry.vertices.resize(total_vertices * stride);
+    std::vector<u32> indices;
+    indices.reserve(total_indices);
+
+    u32 first_vertex = 0;
+    u32 segment_base = 0;
+    for (const auto& mesh : meshes) {
+        u32 vertex_count = cut::to_u32(mesh.vertices.size() / stride);
+        if (first_vertex + vertex_count - segment_base > segment_vertices) segment_base = first_vertex;
+
+        std::byte* vertices = geometry.vertices.data() + static_cast<size_t>(first_vertex) * stride;
+        std::memcpy(vertices, mesh.vertices.data(), mesh.vertices.size());
+
+        glm::mat3 normal_transform = glm::transpose(glm::inverse(glm::mat3(mesh.transform)));
+        glm::vec3 bounds_min{ 0.0f };
+        glm::vec3 bounds_max{ 0.0f };
+        for (u32 v = 0; v < vertex_count; ++v) {
+            std::byte* vertex = vertices + static_cast<size_t>(v) * stride;
+
+            glm::vec3 position;
+            std::memcpy(&position, vertex + desc.position_offset, sizeof(position));
+            position = glm::vec3(mesh.transform * glm::vec4(position, 1.0f));
+            std::memcpy(vertex + desc.position_offset, &position, sizeof(position));
+
+            bounds_min = v == 0 ? position : glm::min(bounds_min, position);
+            bounds_max = v == 0 ? position : glm::max(bounds_max, position);
+
+            if (desc.normal_offset) {
+                glm::vec3 normal;
+                std::memcpy(&normal, vertex + *desc.normal_offset, sizeof(normal));
+                normal = glm::normalize(normal_transform * normal);
+                std::memcpy(vertex + *desc.normal_offset, &normal, sizeof(normal));
+            }
+        }
+
+        u32 index_base = first_vertex - segment_base;
+        geometry.sub_meshes.push_back({
+            cut::to_u32(indices.size()),
+            cut::to_u32(mesh.indices.size()),
+            static_cast<s32>(segment_base),
+            bounds_min,
+            bounds_max
+        });
+        for (u32 index : mesh.indices) {
+            cut::ensure(index < vertex_count, "Index out of range!");
+            indices.push_back(index + index_base);
+        }
+        first_vertex += vertex_count;
+    }
+
+    geometry.indices = narrow_indices(indices, geometry.index_type);
+    return geometry;
+}
+
+void StaticBatch::draw() {
+    counts_.clear();
+    first_indices_.clear();
+    offsets_.clear();
+    base_vertices_.clear();
+    for (const auto& sub_mesh : sub_meshes_) add_range(sub_mesh);
+    submit();
+}
+
+void StaticBatch::draw(std::span<const u32> visible_sub_meshes) {
+    counts_.clear();
+    first_indices_.clear();
+    offsets_.clear();
+    base_vertices_.clear();
+    // Strictly ascending keeps the range count within the sub mesh count the indirect regions are sized for
+    for (size_t i = 0; i < visible_sub_meshes.size(); ++i) {
+        u32 index = visible_sub_meshes[i];
+        cut::ensure(index < sub_meshes_.size(), "Sub mesh {} out of range!", index);
+        cut::ensure(i == 0 || index > visible_sub_meshes[i - 1], "Visible sub meshes aren't strictly ascending!");
+        add_range(sub_meshes_[index]);
+    }
+    submit();
+}
+
+void StaticBatch::add_range(const StaticBatchSubMesh& sub_mesh) {
+    // Meshes next to each other in the index buffer with the same base vertex draw as one range
+    if (!counts_.empty() && base_vertices_.back() == sub_mesh.base_vertex &&
+        first_indices_.back() + static_cast<u32>(counts_.back()) == sub_mesh.first_index) {
+        counts_.back() += static_cast<s32>(sub_mesh.index_count);
+        return;
+    }
+
+    u32 index_size = Mesh::to_size(mesh_.get_index_type());
+    counts_.push_back(static_cast<s32>(sub_mesh.index_count));
+    first_indices_.push_back(sub_mesh.first_index);
+    offsets_.push_back(reinterpret_cast<const void*>(static_cast<size_t>(sub_mesh.first_index) * index_size));
+    base_vertices_.push_back(sub_mesh.base_vertex);
+}
+
+void StaticBatch::submit() {
+    if (counts_.empty()) return;
+
+    mesh_.bind();
+    u32 index_type = Mesh::to_gl_enum(mesh_.get_index_type());
+    if (counts_.size() == 1) {
+        glDrawElementsBaseVertex(GL_TRIANGLES, counts_[0], index_type, offsets_[0], base_vertices_[0]);
+        return;
+    }
+
+    if (indirect_commands_) {
+        // Rewriting commands the GPU may still read would sync implicitly, so each draw takes the next region
+        indirect_region_ = (indirect_region_ + 1) % cut::to_u32(indirect_fences_.size());
+        auto& fence = indirect_fences_[indirect_region_];
+        if (fence) {
+            fence->wait();
+            fence.reset();
+        }
+
+        size_t offset = indirect_region_ * indirect_region_size_;
+        auto commands = reinterpret_cast<IndirectCommand*>(indirect_commands_->get_mapping().data() + offset);
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            commands[i] = { static_cast<u32>(counts_[i]), 1, first_indices_[i], base_vertices_[i], 0 };
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_commands_->get_native_handle());
+        glMultiDrawElementsIndirect(GL_TRIANGLES, index_type, reinterpret_cast<const void*>(offset), static_cast<s32>(counts_.size()), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        fence.emplace();
+        return;
+    }
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts_.data(), index_type, offsets_.data(),
+                                  static_cast<s32>(counts_.size()), base_vertices_.data());
+}
+
+} // namespace glw
@@ -1,8 +1,13 @@
 #include "glw/texture.hpp"
+#include "glw/buffer.hpp"
+#include "glw/capabilities.hpp"
 #include "glw/glw.hpp"
 
 #include <cut/exception.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 namespace {
 
 using namespace glw;
@@ -29,14 +34,45 @@ GLenum to_gl_enum(TextureWrapMode wrap_mode) {
 
 GLenum to_gl_enum(TextureType type) {
     switch (type) {
-    case TextureType::Texture2D: return GL_TEXTURE_2D;
-    case TextureType::Cubemap:   return GL_TEXTURE_CUBE_MAP;
+    case TextureType::Texture2D:      return GL_TEXTURE_2D;
+    case TextureType::Texture2DArray: return GL_TEXTURE_2D_ARRAY;
+    case TextureType::Texture3D:      return GL_TEXTURE_3D;
+    case TextureType::Cubemap:        return GL_TEXTURE_CUBE_MAP;
+    case TextureType::CubemapArray:   return GL_TEXTURE_CUBE_MAP_ARRAY;
     }
 
     throw cut::Exception("Unhandled texture format!");
     return {};
 }
 
+bool is_layered(TextureType type) {
+    switch (type) {
+    using enum TextureType;
+    case Texture2D:
+    case Cubemap:        return false;
+    case Texture2DArray:
+    case Texture3D:
+    case CubemapArray:   return true;
+    }
+
+    throw cut::Exception("Unhandled texture type!");
+    return {};
+}
+
+u32 to_layer_count(const TextureDescription& desc, u16 level) {
+    switch (desc.type) {
+    using enum TextureType;
+    case Texture2D:      return 1;
+    case Texture2DArray: return desc.layers;
+    case Texture3D:      return std::max(desc.layers >> level, 1);
+    case Cubemap:        return 6;
+    case CubemapArray:   return desc.layers * 6u;
+    }
+
+    throw cut::Exception("Unhandled texture type!");
+    return {};
+}
+
 GLenum to_gl_enum(TextureFormat format) {
     switch (format) {
     using enum TextureFormat;
@@ -77,6 +113,39 @@ void Sampler::bind(u32 unit) const {
     glBindSampler(unit, handle_.get());
 }
 
+TextureStaging::TextureStaging(size_t region_size, u32 region_count) :
+    fences_(region_count)
+{
+    cut::ensure(region_count > 0, "Texture staging needs at least one region!");
+    if (region_size > 0) {
+        region_size_ = region_size;
+        buffer_.emplace(region_size_ * region_count, BufferUsage::PersistentWrite);
+    }
+}
+
+std::span<std::byte> TextureStaging::map(size_t size) {
+    if (!buffer_ || region_size_ < size) {
+        // Uploads still reading a replaced buffer keep it alive until they are done
+        region_size_ = size;
+        buffer_.emplace(region_size_ * fences_.size(), BufferUsage::PersistentWrite);
+        for (auto& fence : fences_) fence.reset();
+        region_ = 0;
+    }
+    else {
+        region_ = (region_ + 1) % cut::to_u32(fences_.size());
+        auto& fence = fences_[region_];
+        if (fence) {
+            fence->wait();
+            fence.reset();
+        }
+    }
+    return buffer_->get_mapping().subspan(get_offset(), size);
+}
+
+void TextureStaging::fence() {
+    fences_[region_].emplace();
+}
+
 Texture::Texture(const TextureDescription &desc) :
     handle_(0u, [](u32 handle){ glDeleteTextures(1, &handle); }),
     desc_(desc)
@@ -85,7 +154,12 @@ Texture::Texture(const TextureDescription &desc) :
     glCreateTextures(to_gl_enum(desc.type), 1, &handle);
     handle_.reset(handle);
 
-    glTextureStorage2D(handle, 1, to_gl_enum(desc.format), desc.width, desc.height);
+    if (is_layered(desc.type)) {
+        glTextureStorage3D(handle, desc.levels, to_gl_enum(desc.format), desc.width, desc.height, to_layer_count(desc, 0));
+    }
+    else {
+        glTextureStorage2D(handle, desc.levels, to_gl_enum(desc.format), desc.width, desc.height);
+    }
 }
 
 void Texture::set_pixels_2d(std::span<const std::byte> pixels, u16 channels,
@@ -104,20 +178,61 @@ void Texture::set_pixels_2d(std::span<const std::byte> pixels, u16 channels,
 }
 
 void Texture::set_pixels_3d(std::span<const std::byte> pixels, u16 channels,
-    u16 x_offset, u16 y_offset, u16 z_offset, u16 width, u16 height) const
+    u16 x_offset, u16 y_offset, u16 z_offset, u16 width, u16 height, u16 depth) const
 {
     if (width == 0) width = desc_.width;
     if (height == 0) height = desc_.height;
 
-    cut::ensure(width * height * channels == pixels.size(), "Setting pixels partially is unsupported!");
+    cut::ensure(width * height * depth * channels == pixels.size(), "Setting pixels partially is unsupported!");
 
     glTextureSubImage3D(handle_.get(), 0,
                         x_offset, y_offset, z_offset,
-                        width, height, 1,
+                        width, height, depth,
                         channels == 4 ? GL_RGBA : GL_RGB,
                         GL_UNSIGNED_BYTE, pixels.data());
 }
 
+void Texture::set_pixels(std::span<const std::byte> pixels, u16 channels, TextureStaging& staging) const {
+    size_t size = 0;
+    for (u16 level = 0; level < desc_.levels; ++level) {
+        size_t level_width = std::max(desc_.width >> level, 1);
+        size_t level_height = std::max(desc_.height >> level, 1);
+        size += level_width * level_height * to_layer_count(desc_, level) * channels;
+    }
+    cut::ensure(size == pixels.size(), "Pixels have to cover every layer and level of the texture!");
+
+    std::memcpy(staging.map(pixels.size()).data(), pixels.data(), pixels.size());
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.get_native_handle());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    GLenum format = channels == 4 ? GL_RGBA : GL_RGB;
+    size_t offset = staging.get_offset();
+    for (u16 level = 0; level < desc_.levels; ++level) {
+        GLsizei level_width = std::max(desc_.width >> level, 1);
+        GLsizei level_height = std::max(desc_.height >> level, 1);
+        GLsizei layers = to_layer_count(desc_, level);
+        const void* data = reinterpret_cast<const void*>(offset);
+
+        if (is_layered(desc_.type) || desc_.type == TextureType::Cubemap) {
+            glTextureSubImage3D(handle_.get(), level,
+                                0, 0, 0,
+                                level_width, level_height, layers,
+                                format, GL_UNSIGNED_BYTE, data);
+        }
+        else {
+            glTextureSubImage2D(handle_.get(), level,
+                                0, 0,
+                                level_width, level_height,
+                                format, GL_UNSIGNED_BYTE, data);
+        }
+        offset += static_cast<size_t>(level_width) * level_height * layers * channels;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    staging.fence();
+}
+
 void Texture::generate_mipmaps() const {
     glGenerateTextureMipmap(handle_.get());
 }
@@ -126,4 +241,13 @@ void Texture::bind(u32 unit) const {
     glBindTextureUnit(unit, handle_.get());
 }
 
+std::uint64_t Texture::get_bindless_handle() {
+    if (bindless_handle_ == 0) {
+        cut::ensure(get_capabilities().bindless_textures, "Bindless textures are not supported!");
+        bindless_handle_ = glGetTextureHandleARB(handle_.get());
+        glMakeTextureHandleResidentARB(bindless_handle_);
+    }
+    return bindless_handle_;
+}
+
 } // namespace glw
@@ -0,0 +1,335 @@
+#include "glw/texture_atlas.hpp"
+#include "glw/glw.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace {
+
+using namespace glw;
+
+size_t to_free_bucket(u16 width, u16 height) {
+    return std::bit_width(std::min(width, height)) - 1u;
+}
+
+} // namespace
+
+namespace glw {
+
+AtlasPacker::AtlasPacker(u16 width, u16 height) :
+    width_(width),
+    height_(height)
+{
+    clear();
+}
+
+std::optional<AtlasRect> AtlasPacker::insert(u16 width, u16 height) {
+    if (width == 0 || height == 0 || width > width_ || height > height_) return std::nullopt;
+
+    auto rect = insert_free(width, height);
+    if (!rect) rect = insert_skyline(width, height);
+    if (rect) used_area_ += static_cast<u32>(width) * height;
+    return rect;
+}
+
+void AtlasPacker::free(const AtlasRect& rect) {
+    used_area_ -= static_cast<u32>(rect.width) * rect.height;
+    merge_free_rect(rect);
+}
+
+void AtlasPacker::clear() {
+    skyline_.assign(1, SkylineNode{ 0, 0, width_ });
+    for (auto& bucket : free_rects_) {
+        bucket.clear();
+    }
+    used_area_ = 0;
+}
+
+std::optional<AtlasRect> AtlasPacker::insert_free(u16 width, u16 height) {
+    // Best area fit inside the first bucket that has any fit
+    std::vector<AtlasRect>* best_bucket = nullptr;
+    size_t best_index = 0;
+    for (size_t b = to_free_bucket(width, height); b < free_bucket_count && !best_bucket; ++b) {
+        auto& bucket = free_rects_[b];
+        u32 best_area = std::numeric_limits<u32>::max();
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            const AtlasRect& free_rect = bucket[i];
+            if (free_rect.width < width || free_rect.height < height) continue;
+
+            u32 area = static_cast<u32>(free_rect.width) * free_rect.height;
+            if (area < best_area) {
+                best_area = area;
+                best_bucket = &bucket;
+                best_index = i;
+            }
+        }
+    }
+    if (!best_bucket) return std::nullopt;
+
+    AtlasRect free_rect = (*best_bucket)[best_index];
+    (*best_bucket)[best_index] = best_bucket->back();
+    best_bucket->pop_back();
+
+    // Guillotine split along the shorter leftover axis
+    u16 leftover_width = free_rect.width - width;
+    u16 leftover_height = free_rect.height - height;
+    AtlasRect right, bottom;
+    if (leftover_width < leftover_height) {
+        right = { static_cast<u16>(free_rect.x + width), free_rect.y, leftover_width, height };
+        bottom = { free_rect.x, static_cast<u16>(free_rect.y + height), free_rect.width, leftover_height };
+    }
+    else {
+        right = { static_cast<u16>(free_rect.x + width), free_rect.y, leftover_width, free_rect.height };
+        bottom = { free_rect.x, static_cast<u16>(free_rect.y + height), width, leftover_height };
+    }
+    add_free_rect(right);
+    add_free_rect(bottom);
+
+    return AtlasRect{ free_rect.x, free_rect.y, width, height };
+}
+
+std::optional<AtlasRect> AtlasPacker::insert_skyline(u16 width, u16 height) {
+    size_t best_index = skyline_.size();
+    u32 best_y = std::numeric_limits<u32>::max();
+    u32 best_node_width = std::numeric_limits<u32>::max();
+    for (size_t i = 0; i < skyline_.size(); ++i) {
+        if (skyline_[i].x + width > width_) break;
+
+        u32 y = 0;
+        u32 remaining = width;
+        for (size_t j = i; remaining > 0; ++j) {
+            y = std::max<u32>(y, skyline_[j].y);
+            if (skyline_[j].width >= remaining) break;
+            remaining -= skyline_[j].width;
+        }
+        if (y + height > height_) continue;
+
+        if (y < best_y || (y == best_y && skyline_[i].width < best_node_width)) {
+            best_index = i;
+            best_y = y;
+            best_node_width = skyline_[i].width;
+        }
+    }
+    if (best_index == skyline_.size()) return std::nullopt;
+
+    AtlasRect rect{ skyline_[best_index].x, static_cast<u16>(best_y), width, height };
+
+    // Space between covered nodes and the bottom of the new rect goes to the free list
+    u32 right = rect.x + width;
+    size_t end = best_index;
+    for (; end < skyline_.size() && skyline_[end].x < right; ++end) {
+        SkylineNode& node = skyline_[end];
+        u32 node_right = node.x + node.width;
+        if (node.y < best_y) {
+            add_free_rect({ node.x, node.y,
+                            static_cast<u16>(std::min(node_right, right) - node.x),
+                            static_cast<u16>(best_y - node.y) });
+        }
+        if (node_right > right) {
+            node.width = static_cast<u16>(node_right - right);
+            node.x = static_cast<u16>(right);
+            break;
+        }
+    }
+    skyline_.erase(skyline_.begin() + best_index, skyline_.begin() + end);
+    skyline_.insert(skyline_.begin() + best_index, SkylineNode{ rect.x, static_cast<u16>(best_y + height), width });
+
+    for (size_t i = 0; i + 1 < skyline_.size();) {
+        if (skyline_[i].y == skyline_[i + 1].y) {
+            skyline_[i].width += skyline_[i + 1].width;
+            skyline_.erase(skyline_.begin() + i + 1);
+        }
+        else {
+            ++i;
+        }
+    }
+
+    return rect;
+}
+
+void AtlasPacker::add_free_rect(AtlasRect rect) {
+    if (rect.width == 0 || rect.height == 0) return;
+
+    free_rects_[to_free_bucket(rect.width, rect.height)].push_back(rect);
+}
+
+void AtlasPacker::merge_free_rect(AtlasRect rect) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t b = 0; b < free_bucket_count && !merged; ++b) {
+            auto& bucket = free_rects_[b];
+            for (size_t i = 0; i < bucket.size(); ++i) {
+                const AtlasRect& other = bucket[i];
+                if (other.y == rect.y && other.height == rect.height &&
+                    (other.x + other.width == rect.x || rect.x + rect.width == other.x)) {
+                    rect.x = std::min(rect.x, other.x);
+                    rect.width += other.width;
+                    merged = true;
+                }
+                else if (other.x == rect.x && other.width == rect.width &&
+                         (other.y + other.height == rect.y || rect.y + rect.height == other.y)) {
+                    rect.y = std::min(rect.y, other.y);
+                    rect.height += other.height;
+                    merged = true;
+                }
+
+                if (merged) {
+                    bucket[i] = bucket.back();
+                    bucket.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+    add_free_rect(rect);
+}
+
+TextureAtlas::TextureAtlas(const TextureAtlasDescription& desc) :
+    desc_(desc)
+{
+    cut::ensure(desc.max_pages > 0, "Texture atlas needs at least one page!");
+}
+
+std::optional<TextureAtlas::Handle> TextureAtlas::insert(std::span<const std::byte> pixels, u16 channels, u16 width, u16 height) {
+    // Zero would make set_pixels_2d upload a whole page
+    cut::ensure(width > 0 && height > 0, "Texture atlas images can't be empty!");
+
+    auto entry = pack(packers_, width, height);
+    if (!entry) return std::nullopt;
+
+    try {
+        while (pages_.size() < packers_.size()) {
+            pages_.emplace_back(TextureDescription{
+                .type = TextureType::Texture2D,
+                .format = desc_.format,
+                .width = desc_.page_width,
+                .height = desc_.page_height
+            });
+        }
+        pages_[entry->page].set_pixels_2d(pixels, channels, entry->rect.x, entry->rect.y, width, height);
+    }
+    catch (...) {
+        release(*entry);
+        throw;
+    }
+
+    Handle handle;
+    if (!free_handles_.empty()) {
+        handle = free_handles_.back();
+        free_handles_.pop_back();
+        entries_[handle] = *entry;
+    }
+    else {
+        handle = cut::to_u32(entries_.size());
+        entries_.push_back(*entry);
+    }
+    return handle;
+}
+
+void TextureAtlas::remove(Handle handle) {
+    Entry& entry = entries_[handle];
+    cut::ensure(entry.alive, "Removing texture atlas entry twice!");
+
+    release(entry);
+    entry.alive = false;
+    free_handles_.push_back(handle);
+}
+
+bool TextureAtlas::repack() {
+    std::vector<Handle> order;
+    order.reserve(entries_.size());
+    for (Handle handle = 0; handle < entries_.size(); ++handle) {
+        if (entries_[handle].alive) order.push_back(handle);
+    }
+    std::ranges::sort(order, [this](Handle a, Handle b) {
+        const AtlasRect& ra = entries_[a].rect;
+        const AtlasRect& rb = entries_[b].rect;
+        return ra.height != rb.height ? ra.height > rb.height : ra.width > rb.width;
+    });
+
+    std::vector<AtlasPacker> packers;
+    std::vector<Entry> repacked(entries_.size());
+    for (Handle handle : order) {
+        auto entry = pack(packers, entries_[handle].rect.width, entries_[handle].rect.height);
+        if (!entry) return false;
+        repacked[handle] = *entry;
+    }
+
+    std::vector<Texture> pages;
+    pages.reserve(packers.size());
+    for (size_t i = 0; i < packers.size(); ++i) {
+        pages.emplace_back(TextureDescription{
+            .type = TextureType::Texture2D,
+            .format = desc_.format,
+            .width = desc_.page_width,
+            .height = desc_.page_height
+        });
+    }
+
+    for (Handle handle : order) {
+        const Entry& from = entries_[handle];
+        const Entry& to = repacked[handle];
+        glCopyImageSubData(pages_[from.page].get_native_handle(), GL_TEXTURE_2D, 0, from.rect.x, from.rect.y, 0,
+                           pages[to.page].get_native_handle(), GL_TEXTURE_2D, 0, to.rect.x, to.rect.y, 0,
+                           from.rect.width, from.rect.height, 1);
+        entries_[handle] = to;
+    }
+
+    packers_ = std::move(packers);
+    pages_ = std::move(pages);
+    return true;
+}
+
+void TextureAtlas::bind(u32 first_unit) const {
+    for (u32 i = 0; i < pages_.size(); ++i) {
+        pages_[i].bind(first_unit + i);
+    }
+}
+
+AtlasUVRect TextureAtlas::get_uv_rect(Handle handle) const {
+    const AtlasRect& rect = entries_[handle].rect;
+    f32 inv_width = 1.0f / desc_.page_width;
+    f32 inv_height = 1.0f / desc_.page_height;
+    return {
+        rect.x * inv_width,
+        rect.y * inv_height,
+        (rect.x + rect.width) * inv_width,
+        (rect.y + rect.height) * inv_height
+    };
+}
+
+f32 TextureAtlas::get_occupancy() const {
+    if (packers_.empty()) return 0.0f;
+
+    f32 used_area = 0.0f;
+    for (const auto& packer : packers_) {
+        used_area += packer.get_used_area();
+    }
+    return used_area / (static_cast<f32>(desc_.page_width) * desc_.page_height * packers_.size());
+}
+
+std::optional<TextureAtlas::Entry> TextureAtlas::pack(std::vector<AtlasPacker>& packers, u16 width, u16 height) const {
+    u32 padded_width = width + desc_.padding;
+    u32 padded_height = height + desc_.padding;
+    if (padded_width > desc_.page_width || padded_height > desc_.page_height) return std::nullopt;
+
+    for (u32 page = 0; page < desc_.max_pages; ++page) {
+        if (page == packers.size()) packers.emplace_back(desc_.page_width, desc_.page_height);
+
+        auto rect = packers[page].insert(static_cast<u16>(padded_width), static_cast<u16>(padded_height));
+        if (rect) return Entry{ page, AtlasRect{ rect->x, rect->y, width, height }, true };
+    }
+    return std::nullopt;
+}
+
+void TextureAtlas::release(const Entry& entry) {
+    packers_[entry.page].free({ entry.rect.x, entry.rect.y,
+                                static_cast<u16>(entry.rect.width + desc_.padding),
+                                static_cast<u16>(entry.rect.height + desc_.padding) });
+}
+
+} // namespace glw
@@ -0,0 +1,93 @@
+#include "glw/thread_pool.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+
+namespace glw {
+
+ThreadPool::ThreadPool(u32 thread_count) {
+    thread_count = std::max(thread_count, 1u);
+    workers_.reserve(thread_count - 1);
+    for (u32 i = 1; i < thread_count; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{ mutex_ };
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, size_t chunk_size, const RangeFunc& func) {
+    if (count == 0) return;
+
+    // A second caller would wait for workers that only ever finish the first one's chunks
+    cut::ensure(!running_.exchange(true, std::memory_order_acquire), "ThreadPool::parallel_for can't nest or run concurrently!");
+
+    {
+        std::lock_guard lock{ mutex_ };
+        func_ = &func;
+        count_ = count;
+        chunk_size_ = std::max<size_t>(chunk_size, 1);
+        next_.store(0, std::memory_order_relaxed);
+        exception_ = nullptr;
+        busy_workers_ = cut::to_u32(workers_.size());
+        generation_++;
+    }
+    work_cv_.notify_all();
+
+    run_chunks();
+
+    std::unique_lock lock{ mutex_ };
+    done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+    func_ = nullptr;
+    running_.store(false, std::memory_order_release);
+
+    if (exception_) std::rethrow_exception(exception_);
+}
+
+void ThreadPool::worker_loop() {
+    u32 seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock{ mutex_ };
+            work_cv_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) return;
+            seen_generation = generation_;
+        }
+
+        run_chunks();
+
+        {
+            std::lock_guard lock{ mutex_ };
+            busy_workers_--;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+void ThreadPool::run_chunks() {
+    while (true) {
+        size_t begin = next_.fetch_add(chunk_size_, std::memory_order_relaxed);
+        if (begin >= count_) return;
+
+        try {
+            (*func_)(begin, std::min(begin + chunk_size_, count_));
+        }
+        catch (...) {
+            std::lock_guard lock{ mutex_ };
+            if (!exception_) exception_ = std::current_exception();
+            next_.store(count_, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace glw
@@ -4,87 +4,58 @@
 
 #include <cut/exception.hpp>
 
+#include <algorithm>
+
 namespace {
 
 using namespace glw;
-using cut::u8;
-using cut::u16;
-using cut::s32;
-using cut::f32;
 
-u32 to_size(VertexArray::DataType type) {
-    switch (type) {
-    using enum VertexArray::DataType;
-    case U8_4:
-    case U8_4_Norm:  return sizeof(u8) * 4;
-    case U16_2:
-    case U16_2_Norm: return sizeof(u16) * 2;
-    case U32:
-    case U32_Norm:   return sizeof(u32);
-    case U32_2:
-    case U32_2_Norm: return sizeof(u32) * 2;
-    case U32_3:
-    case U32_3_Norm: return sizeof(u32) * 3;
-    case U32_4:
-    case U32_4_Norm: return sizeof(u32) * 4;
-    case S32:
-    case S32_Norm:   return sizeof(s32);
-    case S32_2:
-    case S32_2_Norm: return sizeof(s32) * 2;
-    case S32_3:
-    case S32_3_Norm: return sizeof(s32) * 3;
-    case S32_4:
-    case S32_4_Norm: return sizeof(s32) * 4;
-    case F32:        return sizeof(f32);
-    case F32_2:      return sizeof(f32) * 2;
-    case F32_3:      return sizeof(f32) * 3;
-    case F32_4:      return sizeof(f32) * 4;
-    }
+/*
+* Returns first location after the attributes
+*/
+GLuint set_attribute_formats(GLuint handle, std::span<const VertexAttribute> attributes,
+                             GLuint vertex_buffer_binding = 0, GLuint first_index = 0) {
+    GLuint index = first_index;
+    for (const auto& attribute : attributes) {
+        VertexAttributeFormat format = to_attribute_format(attribute.type);
 
-    throw cut::Exception("Unhandled data type!");
-    return {};
-}
+        glEnableVertexArrayAttrib(handle, index);
+        glVertexArrayAttribBinding(handle, index, vertex_buffer_binding);
 
-GLint to_count(VertexArray::DataType type) {
-    switch (type) {
-    using enum VertexArray::DataType;
-    case U32:
-    case S32:
-    case U32_Norm:
-    case S32_Norm:
-    case F32: return 1;
-    case U16_2:
-    case U32_2:
-    case S32_2:
-    case U16_2_Norm:
-    case U32_2_Norm:
-    case S32_2_Norm:
-    case F32_2: return 2;
-    case U32_3:
-    case S32_3:
-    case U32_3_Norm:
-    case S32_3_Norm:
-    case F32_3: return 3;
-    case U8_4:
-    case U32_4:
-    case S32_4:
-    case U8_4_Norm:
-    case U32_4_Norm:
-    case S32_4_Norm:
-    case F32_4: return 4;
+        if (format.integer) {
+            glVertexArrayAttribIFormat(handle, index,
+                format.count, to_gl_enum(attribute.type),
+                attribute.offset);
+        }
+        else {
+            glVertexArrayAttribFormat(handle, index,
+                format.count, to_gl_enum(attribute.type),
+                format.normalized ? GL_TRUE : GL_FALSE,
+                attribute.offset);
+        }
+        index++;
     }
-
-    throw cut::Exception("Unhandled data type!");
-    return {};
+    return index;
 }
 
-GLenum to_gl_enum(VertexArray::DataType type) {
+} // namespace
+
+namespace glw {
+
+u32 to_gl_enum(VertexDataType type) {
     switch (type) {
-    using enum VertexArray::DataType;
+    using enum VertexDataType;
     case U8_4:
-    case U8_4_Norm:  return GL_UNSIGNED_BYTE;
+    case U8_4_Norm:        return GL_UNSIGNED_BYTE;
+    case S8_4_Norm:        return GL_BYTE;
     case U16_2:
-    case U16_2_Norm: return GL_UNSIGNED_SHORT;
+    case U16_4:
+    case U16_2_Norm:
+    case U16_4_Norm:       return GL_UNSIGNED_SHORT;
+    case S16_2:
+    case S16_4:
+    case S16_2_Norm:
+    case S16_4_Norm:       return GL_SHORT;
     case U32:
     case U32_2:
     case U32_3:
@@ -92,7 +63,7 @@ GLenum to_gl_enum(VertexArray::DataType type) {
     case U32_Norm:
     case U32_2_Norm:
     case U32_3_Norm:
-    case U32_4_Norm: return GL_UNSIGNED_INT;
+    case U32_4_Norm:       return GL_UNSIGNED_INT;
     case S32:
     case S32_2:
     case S32_3:
@@ -100,117 +71,61 @@ GLenum to_gl_enum(VertexArray::DataType type) {
     case S32_Norm:
     case S32_2_Norm:
     case S32_3_Norm:
-    case S32_4_Norm: return GL_INT;
+    case S32_4_Norm:       return GL_INT;
+    case U10_10_10_2_Norm: return GL_UNSIGNED_INT_2_10_10_10_REV;
+    case S10_10_10_2_Norm: return GL_INT_2_10_10_10_REV;
+    case F16_2:
+    case F16_4:            return GL_HALF_FLOAT;
     case F32:
     case F32_2:
     case F32_3:
-    case F32_4:      return GL_FLOAT;
+    case F32_4:            return GL_FLOAT;
     }
 
-    throw cut::Exception("Unhandled data type!");
+    throw cut::Exception("Unhandled vertex data type!");
     return {};
 }
 
-bool is_integer(VertexArray::DataType type) {
-    switch (type) {
-    using enum VertexArray::DataType;
-    case F32:
-    case F32_2:
-    case F32_3:
-    case F32_4:
-    case S32_Norm:
-    case S32_2_Norm:
-    case S32_3_Norm:
-    case S32_4_Norm:
-    case U8_4_Norm:
-    case U16_2_Norm:
-    case U32_Norm:
-    case U32_2_Norm:
-    case U32_3_Norm:
-    case U32_4_Norm: return false;
-    case S32:
-    case S32_2:
-    case S32_3:
-    case S32_4:
-    case U8_4:
-    case U16_2:
-    case U32:
-    case U32_2:
-    case U32_3:
-    case U32_4: return true;
-    }
-
-    throw cut::Exception("Unhandled data type!");
-    return {};
-}
+VertexArray::VertexArray(const Buffer& vertex_buffer, std::initializer_list<DataType> layout) :
+    handle_(0u, [](u32 handle){ glDeleteVertexArrays(1, &handle); }) {   
+    
+    GLuint handle;
+    glCreateVertexArrays(1, &handle);
+    handle_.reset(handle);
 
-bool should_normalize(VertexArray::DataType type) {
-    switch (type) {
-    using enum VertexArray::DataType;
-    case U8_4:
-    case U16_2:
-    case U32:
-    case U32_2:
-    case U32_3:
-    case U32_4:
-    case S32:
-    case S32_2:
-    case S32_3:
-    case S32_4:
-    case F32:
-    case F32_2:
-    case F32_3:
-    case F32_4: return false;
-    case U8_4_Norm:
-    case U16_2_Norm:
-    case U32_Norm:
-    case U32_2_Norm:
-    case U32_3_Norm:
-    case U32_4_Norm:
-    case S32_Norm:
-    case S32_2_Norm:
-    case S32_3_Norm:
-    case S32_4_Norm: return true;
+    std::vector<VertexAttribute> attributes;
+    attributes.reserve(layout.size());
+    for (const auto& element_type : layout) {
+        attributes.push_back({ element_type, strides_[0] });
+        strides_[0] += to_attribute_format(element_type).size;
     }
+    set_attribute_formats(handle, attributes);
 
-    throw cut::Exception("Unhandled data type!");
-    return {};
+    set_vertex_buffer(vertex_buffer);
 }
 
-} // namespace
+VertexArray::VertexArray(const VertexFormat& format) :
+    VertexArray(std::span{ &format, 1 }) {}
 
-namespace glw {
+VertexArray::VertexArray(std::span<const VertexFormat> streams) :
+    handle_(0u, [](u32 handle){ glDeleteVertexArrays(1, &handle); }) {
+
+    cut::ensure(streams.size() <= max_vertex_streams, "Too many vertex streams!");
 
-VertexArray::VertexArray(const Buffer& vertex_buffer, std::initializer_list<DataType> layout) :
-    handle_(0u, [](u32 handle){ glDeleteVertexArrays(1, &handle); }) {   
-    
     GLuint handle;
     glCreateVertexArrays(1, &handle);
     handle_.reset(handle);
 
-    constexpr GLuint vertex_buffer_binding = 0;
-    u32 offset = 0;
     GLuint index = 0;
-    for (const auto& element_type : layout) {
-        glEnableVertexArrayAttrib(handle, index);
-        glVertexArrayAttribBinding(handle, index, vertex_buffer_binding);
-        
-        if (is_integer(element_type)) {
-            glVertexArrayAttribIFormat(handle, index,
-                to_count(element_type), to_gl_enum(element_type),
-                offset);
-        }
-        else {
-            glVertexArrayAttribFormat(handle, index,
-                to_count(element_type), to_gl_enum(element_type),
-                should_normalize(element_type) ? GL_TRUE : GL_FALSE,
-                offset);
-        }
-        index++;
-        offset += to_size(element_type);
+    for (u32 binding = 0; binding < streams.size(); ++binding) {
+        index = set_attribute_formats(handle, streams[binding].attributes, binding, index);
+        strides_[binding] = streams[binding].stride;
     }
+}
 
-    glVertexArrayVertexBuffer(handle, vertex_buffer_binding, vertex_buffer.get_native_handle(), 0, offset);
+void VertexArray::set_vertex_buffer(const Buffer& vertex_buffer, u32 binding) {
+    cut::ensure(binding < max_vertex_streams, "Vertex buffer binding {} out of range!", binding);
+    glVertexArrayVertexBuffer(handle_.get(), binding, vertex_buffer.get_native_handle(), 0, strides_[binding]);
 }
 
 void VertexArray::set_index_buffer(const Buffer& index_buffer) {
@@ -221,4 +136,40 @@ void VertexArray::bind() const {
     glBindVertexArray(handle_.get());
 }
 
+VertexArray& VertexArrayCache::get(const VertexFormat& format) {
+    return get(std::span{ &format, 1 });
+}
+
+VertexArray& VertexArrayCache::get(std::span<const VertexFormat> streams) {
+    u32 hash = hash_vertex_streams(streams);
+    auto [first, last] = entries_.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        if (it->second.matches(streams)) return it->second.vertex_array;
+    }
+
+    return entries_.emplace(hash, streams)->second.vertex_array;
+}
+
+VertexArrayCache::Entry::Entry(std::span<const VertexFormat> streams) :
+    vertex_array(streams)
+{
+    for (const auto& stream : streams) {
+        attributes.insert(attributes.end(), stream.attributes.begin(), stream.attributes.end());
+        attribute_counts.push_back(cut::to_u32(stream.attributes.size()));
+        strides.push_back(stream.stride);
+    }
+}
+
+bool VertexArrayCache::Entry::matches(std::span<const VertexFormat> streams) const {
+    if (streams.size() != strides.size()) return false;
+
+    size_t offset = 0;
+    for (size_t i = 0; i < streams.size(); ++i) {
+        if (streams[i].stride != strides[i] || streams[i].attributes.size() != attribute_counts[i]) return false;
+        if (!std::ranges::equal(streams[i].attributes, std::span{ attributes }.subspan(offset, attribute_counts[i]))) return false;
+        offset += attribute_counts[i];
+    }
+    return true;
+}
+
 } // namespace glw
@@ -0,0 +1,253 @@
+#include "glw/vertex_quantization.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+using namespace glw;
+using cut::s16;
+using cut::s32;
+
+s16 to_snorm16(f32 value) {
+    return static_cast<s16>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+f32 from_snorm16(s16 value) {
+    return std::max(value / 32767.0f, -1.0f);
+}
+
+s32 to_snorm10(f32 value) {
+    return static_cast<s32>(std::round(std::clamp(value, -1.0f, 1.0f) * 511.0f));
+}
+
+f32 from_snorm10(s32 value) {
+    return std::max(value / 511.0f, -1.0f);
+}
+
+f32 sign_not_zero(f32 value) {
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+glm::vec2 oct_encode(glm::vec3 n) {
+    n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    glm::vec2 e{ n.x, n.y };
+    if (n.z < 0.0f) {
+        e = glm::vec2{ (1.0f - std::abs(n.y)) * sign_not_zero(n.x),
+                       (1.0f - std::abs(n.x)) * sign_not_zero(n.y) };
+    }
+    return e;
+}
+
+glm::vec3 oct_decode(glm::vec2 e) {
+    glm::vec3 v{ e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y) };
+    if (v.z < 0.0f) {
+        glm::vec2 folded{ (1.0f - std::abs(v.y)) * sign_not_zero(v.x),
+                          (1.0f - std::abs(v.x)) * sign_not_zero(v.y) };
+        v.x = folded.x;
+        v.y = folded.y;
+    }
+    return glm::normalize(v);
+}
+
+f32 angle_between(glm::vec3 a, glm::vec3 b) {
+    return std::acos(std::clamp(glm::dot(glm::normalize(a), b), -1.0f, 1.0f));
+}
+
+template<typename T>
+void store(std::vector<std::byte>& vertices, size_t vertex, u32 stride, u32 offset, const T& value) {
+    std::memcpy(vertices.data() + vertex * stride + offset, &value, sizeof(T));
+}
+
+} // namespace
+
+namespace glw {
+
+u16 to_half(f32 value) {
+    u32 bits = std::bit_cast<u32>(value);
+    u16 sign = static_cast<u16>((bits >> 16) & 0x8000);
+    u32 magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude >= 0x7F800000) return sign | (magnitude > 0x7F800000 ? 0x7E00 : 0x7C00);
+    if (magnitude >= 0x477FF000) return sign | 0x7C00; // Rounds past 65504
+    if (magnitude < 0x38800000) {
+        // Subnormal half, multiples of 2^-24
+        return sign | static_cast<u16>(std::nearbyint(std::bit_cast<f32>(magnitude) * 16777216.0f));
+    }
+
+    // Rebias exponent and round mantissa to nearest even
+    u32 rebiased = magnitude - 0x38000000;
+    rebiased += 0x0FFF + ((rebiased >> 13) & 1);
+    return sign | static_cast<u16>(rebiased >> 13);
+}
+
+f32 from_half(u16 value) {
+    u32 sign = static_cast<u32>(value & 0x8000) << 16;
+    u32 exponent = (value >> 10) & 0x1F;
+    u32 mantissa = value & 0x3FF;
+
+    if (exponent == 0) {
+        f32 magnitude = mantissa * (1.0f / 16777216.0f);
+        return sign ? -magnitude : magnitude;
+    }
+    if (exponent == 31) return std::bit_cast<f32>(sign | 0x7F800000 | (mantissa << 13));
+    return std::bit_cast<f32>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+QuantizedMesh quantize_vertices(const QuantizationInput& input, const QuantizationDescription& desc) {
+    size_t vertex_count = input.positions.size();
+    cut::ensure(input.normals.empty() || input.normals.size() == vertex_count, "Normal count doesn't match position count!");
+    cut::ensure(input.tangents.empty() || input.tangents.size() == vertex_count, "Tangent count doesn't match position count!");
+    cut::ensure(input.uvs.empty() || input.uvs.size() == vertex_count, "UV count doesn't match position count!");
+
+    QuantizedMesh mesh;
+
+    // Positions: fixed point inside the bounding box, half floats, or full floats as a last resort
+    glm::vec3 min_position{ 0.0f };
+    glm::vec3 max_position{ 0.0f };
+    if (vertex_count > 0) {
+        min_position = max_position = input.positions[0];
+        for (const auto& position : input.positions) {
+            min_position = glm::min(min_position, position);
+            max_position = glm::max(max_position, position);
+        }
+    }
+    glm::vec3 center = (min_position + max_position) * 0.5f;
+    glm::vec3 half_extent = (max_position - min_position) * 0.5f;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (half_extent[axis] == 0.0f) half_extent[axis] = 1.0f;
+    }
+
+    f32 fixed_error = 0.0f;
+    f32 half_error = 0.0f;
+    for (const auto& position : input.positions) {
+        for (int axis = 0; axis < 3; ++axis) {
+            f32 fixed = from_snorm16(to_snorm16((position[axis] - center[axis]) / half_extent[axis])) * half_extent[axis] + center[axis];
+            fixed_error = std::max(fixed_error, std::abs(fixed - position[axis]));
+            half_error = std::max(half_error, std::abs(from_half(to_half(position[axis])) - position[axis]));
+        }
+    }
+
+    VertexDataType position_type = VertexDataType::F32_3;
+    if (fixed_error <= desc.max_position_error && fixed_error <= half_error) {
+        position_type = VertexDataType::S16_4_Norm;
+        mesh.position_scale = half_extent;
+        mesh.position_offset = center;
+        mesh.stats.max_position_error = fixed_error;
+    }
+    else if (half_error <= desc.max_position_error) {
+        position_type = VertexDataType::F16_4;
+        mesh.stats.max_position_error = half_error;
+    }
+
+    // UVs: 16 bit fixed point inside their bounding rect
+    glm::vec2 min_uv{ 0.0f };
+    glm::vec2 max_uv{ 0.0f };
+    if (!input.uvs.empty()) {
+        min_uv = max_uv = input.uvs[0];
+        for (const auto& uv : input.uvs) {
+            min_uv = glm::min(min_uv, uv);
+            max_uv = glm::max(max_uv, uv);
+        }
+    }
+    glm::vec2 uv_extent = max_uv - min_uv;
+    for (int axis = 0; axis < 2; ++axis) {
+        if (uv_extent[axis] == 0.0f) uv_extent[axis] = 1.0f;
+    }
+    f32 uv_error = 0.0f;
+    for (const auto& uv : input.uvs) {
+        for (int axis = 0; axis < 2; ++axis) {
+            f32 quantized = std::round((uv[axis] - min_uv[axis]) / uv_extent[axis] * 65535.0f);
+            uv_error = std::max(uv_error, std::abs(quantized / 65535.0f * uv_extent[axis] + min_uv[axis] - uv[axis]));
+        }
+    }
+    VertexDataType uv_type = uv_error <= desc.max_uv_error ? VertexDataType::U16_2_Norm : VertexDataType::F32_2;
+    if (uv_type == VertexDataType::U16_2_Norm) {
+        mesh.uv_scale = uv_extent;
+        mesh.uv_offset = min_uv;
+        mesh.stats.max_uv_error = uv_error;
+    }
+
+    auto add_attribute = [&mesh](VertexDataType type) {
+        u32 offset = mesh.stride;
+        mesh.attributes.push_back({ type, offset });
+        mesh.stride += to_attribute_format(type).size;
+        return offset;
+    };
+    u32 position_offset = add_attribute(position_type);
+    u32 normal_offset = input.normals.empty() ? 0 : add_attribute(VertexDataType::S16_2_Norm);
+    u32 tangent_offset = input.tangents.empty() ? 0 : add_attribute(VertexDataType::S10_10_10_2_Norm);
+    u32 uv_offset = input.uvs.empty() ? 0 : add_attribute(uv_type);
+
+    mesh.vertices.resize(vertex_count * mesh.stride);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        const glm::vec3& position = input.positions[v];
+        switch (position_type) {
+        case VertexDataType::S16_4_Norm: {
+            glm::vec3 normalized = (position - center) / half_extent;
+            s16 packed[4] = { to_snorm16(normalized.x), to_snorm16(normalized.y), to_snorm16(normalized.z), 32767 };
+            store(mesh.vertices, v, mesh.stride, position_offset, packed);
+            break;
+        }
+        case VertexDataType::F16_4: {
+            u16 packed[4] = { to_half(position.x), to_half(position.y), to_half(position.z), to_half(1.0f) };
+            store(mesh.vertices, v, mesh.stride, position_offset, packed);
+            break;
+        }
+        default:
+            store(mesh.vertices, v, mesh.stride, position_offset, position);
+            break;
+        }
+
+        if (!input.normals.empty()) {
+            glm::vec2 encoded = oct_encode(input.normals[v]);
+            s16 packed[2] = { to_snorm16(encoded.x), to_snorm16(encoded.y) };
+            store(mesh.vertices, v, mesh.stride, normal_offset, packed);
+
+            glm::vec3 decoded = oct_decode({ from_snorm16(packed[0]), from_snorm16(packed[1]) });
+            mesh.stats.max_normal_error = std::max(mesh.stats.max_normal_error, angle_between(input.normals[v], decoded));
+        }
+
+        if (!input.tangents.empty()) {
+            const glm::vec4& tangent = input.tangents[v];
+            glm::vec2 encoded = oct_encode({ tangent.x, tangent.y, tangent.z });
+            s32 x = to_snorm10(encoded.x);
+            s32 y = to_snorm10(encoded.y);
+            s32 w = tangent.w < 0.0f ? -1 : 1;
+            u32 packed = (static_cast<u32>(x) & 0x3FF) | ((static_cast<u32>(y) & 0x3FF) << 10) | ((static_cast<u32>(w) & 0x3) << 30);
+            store(mesh.vertices, v, mesh.stride, tangent_offset, packed);
+
+            glm::vec3 decoded = oct_decode({ from_snorm10(x), from_snorm10(y) });
+            mesh.stats.max_tangent_error = std::max(mesh.stats.max_tangent_error,
+                angle_between({ tangent.x, tangent.y, tangent.z }, decoded));
+        }
+
+        if (!input.uvs.empty()) {
+            const glm::vec2& uv = input.uvs[v];
+            if (uv_type == VertexDataType::U16_2_Norm) {
+                u16 packed[2] = {
+                    static_cast<u16>(std::round((uv.x - min_uv.x) / uv_extent.x * 65535.0f)),
+                    static_cast<u16>(std::round((uv.y - min_uv.y) / uv_extent.y * 65535.0f))
+                };
+                store(mesh.vertices, v, mesh.stride, uv_offset, packed);
+            }
+            else {
+                store(mesh.vertices, v, mesh.stride, uv_offset, uv);
+            }
+        }
+    }
+
+    size_t float_stride = sizeof(glm::vec3) +
+        (input.normals.empty() ? 0 : sizeof(glm::vec3)) +
+        (input.tangents.empty() ? 0 : sizeof(glm::vec4)) +
+        (input.uvs.empty() ? 0 : sizeof(glm::vec2));
+    mesh.stats.float_bytes = vertex_count * float_stride;
+    mesh.stats.quantized_bytes = mesh.vertices.size();
+    return mesh;
+}
+
+} // namespace glw
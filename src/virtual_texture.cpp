@@ -0,0 +1,273 @@
+#include "glw/virtual_texture.hpp"
+#include "glw/glw.hpp"
+
+#include <cut/exception.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+using namespace glw;
+
+constexpr u32 max_extent = std::numeric_limits<u16>::max();
+
+u32 to_page_count(u32 size, u16 page_size) {
+    return static_cast<u32>((static_cast<std::uint64_t>(size) + page_size - 1) / page_size);
+}
+
+/*
+* Runs before any member is built, page counts and cache sizes end up in u16 texture sizes and u8 page table entries
+*/
+const VirtualTextureDescription& validate(const VirtualTextureDescription& desc) {
+    cut::ensure(desc.width > 0 && desc.height > 0, "Virtual texture can't be empty!");
+    cut::ensure(desc.page_size > 0, "Virtual texture pages can't be empty!");
+    cut::ensure(to_page_count(desc.width, desc.page_size) <= max_extent &&
+                to_page_count(desc.height, desc.page_size) <= max_extent, "Virtual texture has too many pages!");
+    cut::ensure(desc.cache_width_pages > 0 && desc.cache_height_pages > 0, "Virtual texture cache needs at least one page!");
+    cut::ensure(desc.cache_width_pages <= 256 && desc.cache_height_pages <= 256,
+        "Virtual texture cache can't address more than 256 pages per axis!");
+    cut::ensure(static_cast<u32>(desc.cache_width_pages) * desc.page_size <= max_extent &&
+                static_cast<u32>(desc.cache_height_pages) * desc.page_size <= max_extent, "Virtual texture cache is too big!");
+    return desc;
+}
+
+} // namespace
+
+namespace glw {
+
+PageResidency::PageResidency(u32 virtual_page_count, u32 slot_count) :
+    page_slots_(virtual_page_count, invalid),
+    slot_pages_(slot_count, invalid),
+    slot_frames_(slot_count, 0),
+    prev_(slot_count, invalid),
+    next_(slot_count, invalid)
+{
+    cut::ensure(slot_count > 0, "Page residency needs at least one slot!");
+
+    for (u32 slot = 0; slot < slot_count; ++slot) {
+        push_front(slot);
+    }
+}
+
+void PageResidency::touch(u32 slot, u32 frame) {
+    slot_frames_[slot] = frame;
+    if (slot == head_) return;
+
+    unlink(slot);
+    push_front(slot);
+}
+
+std::optional<PageResidency::Allocation> PageResidency::allocate(u32 page, u32 frame) {
+    u32 slot = tail_;
+    if (slot_pages_[slot] != invalid && slot_frames_[slot] == frame) {
+        return std::nullopt;
+    }
+
+    u32 evicted_page = slot_pages_[slot];
+    if (evicted_page != invalid) {
+        page_slots_[evicted_page] = invalid;
+    }
+
+    slot_pages_[slot] = page;
+    page_slots_[page] = slot;
+    touch(slot, frame);
+    return Allocation{ slot, evicted_page };
+}
+
+void PageResidency::unlink(u32 slot) {
+    if (prev_[slot] != invalid) next_[prev_[slot]] = next_[slot];
+    else head_ = next_[slot];
+
+    if (next_[slot] != invalid) prev_[next_[slot]] = prev_[slot];
+    else tail_ = prev_[slot];
+
+    prev_[slot] = invalid;
+    next_[slot] = invalid;
+}
+
+void PageResidency::push_front(u32 slot) {
+    prev_[slot] = invalid;
+    next_[slot] = head_;
+    if (head_ != invalid) prev_[head_] = slot;
+    head_ = slot;
+    if (tail_ == invalid) tail_ = slot;
+}
+
+VirtualTexture::VirtualTexture(const VirtualTextureDescription& desc, PageProvider provider) :
+    desc_{ validate(desc) },
+    provider_(std::move(provider)),
+    width_pages_(to_page_count(desc.width, desc.page_size)),
+    height_pages_(to_page_count(desc.height, desc.page_size)),
+    cache_(TextureDescription{
+        .type = TextureType::Texture2D,
+        .format = TextureFormat::RGBA8,
+        .width = static_cast<u16>(desc.cache_width_pages * desc.page_size),
+        .height = static_cast<u16>(desc.cache_height_pages * desc.page_size)
+    }),
+    page_table_(TextureDescription{
+        .type = TextureType::Texture2D,
+        .format = TextureFormat::RGBA8,
+        .width = static_cast<u16>(width_pages_),
+        .height = static_cast<u16>(height_pages_)
+    }),
+    residency_(width_pages_ * height_pages_, desc.cache_width_pages * desc.cache_height_pages),
+    page_table_entries_(static_cast<size_t>(width_pages_) * height_pages_, PageTableEntry{}),
+    page_pixels_(static_cast<size_t>(desc.page_size) * desc.page_size * 4),
+    dirty_min_x_(width_pages_),
+    dirty_min_y_(height_pages_)
+{
+    page_table_.set_pixels_2d(std::as_bytes(std::span{ page_table_entries_ }), 4);
+
+    stats_.memory_footprint = page_pixels_.size() * residency_.get_slot_count() +
+                              page_table_entries_.size() * sizeof(PageTableEntry);
+}
+
+void VirtualTexture::request_pages(std::span<const u32> page_ids) {
+    for (u32 page_id : page_ids) {
+        if (page_id == invalid_page_id) continue;
+
+        u32 page_x = page_id & 0xFFFF;
+        u32 page_y = page_id >> 16;
+        if (page_x >= width_pages_ || page_y >= height_pages_) continue;
+
+        requested_.push_back(page_y * width_pages_ + page_x);
+    }
+}
+
+void VirtualTexture::read_feedback(const Texture& feedback) {
+    const auto& feedback_desc = feedback.get_description();
+    cut::ensure(feedback_desc.format == TextureFormat::R32U, "Virtual texture feedback must be R32U!");
+
+    FeedbackSlot& slot = feedback_slots_[feedback_index_];
+    if (slot.fence) {
+        if (!slot.fence->is_signaled()) {
+            clear_feedback(feedback);
+            return;
+        }
+
+        feedback_scratch_.resize(slot.size / sizeof(u32));
+        slot.buffer->read(std::as_writable_bytes(std::span{ feedback_scratch_ }));
+        request_pages(feedback_scratch_);
+        slot.fence.reset();
+    }
+
+    size_t size = feedback_desc.width * feedback_desc.height * sizeof(u32);
+    if (slot.size != size) {
+        size_t old_size = slot.buffer ? slot.size : 0;
+        slot.buffer.emplace(size, BufferUsage::Readback);
+        slot.size = size;
+        stats_.memory_footprint += size - old_size;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer->get_native_handle());
+    glGetTextureImage(feedback.get_native_handle(), 0, GL_RED_INTEGER, GL_UNSIGNED_INT, size, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence.emplace();
+    clear_feedback(feedback);
+
+    feedback_index_ = (feedback_index_ + 1) % feedback_latency;
+}
+
+void VirtualTexture::clear_feedback(const Texture& feedback) {
+    glClearTexImage(feedback.get_native_handle(), 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &invalid_page_id);
+}
+
+void VirtualTexture::update() {
+    ++frame_;
+    stats_.requested_pages = 0;
+    stats_.resident_pages = 0;
+    stats_.uploaded_pages = 0;
+    stats_.evicted_pages = 0;
+    stats_.pending_pages = 0;
+    stats_.upload_bytes = 0;
+
+    std::ranges::sort(requested_);
+    auto [first, last] = std::ranges::unique(requested_);
+    requested_.erase(first, last);
+
+    missing_.clear();
+    for (u32 page : requested_) {
+        u32 slot = residency_.find(page);
+        if (slot != PageResidency::invalid) {
+            residency_.touch(slot, frame_);
+            stats_.resident_pages++;
+        }
+        else {
+            missing_.push_back(page);
+        }
+    }
+    stats_.requested_pages = cut::to_u32(requested_.size());
+    requested_.clear();
+
+    for (u32 page : missing_) {
+        if (stats_.uploaded_pages == desc_.max_uploads_per_frame) break;
+
+        auto allocation = residency_.allocate(page, frame_);
+        if (!allocation) break;
+
+        if (allocation->evicted_page != PageResidency::invalid) {
+            set_page_table_entry(allocation->evicted_page, PageTableEntry{});
+            stats_.evicted_pages++;
+        }
+
+        u16 slot_x = allocation->slot % desc_.cache_width_pages;
+        u16 slot_y = allocation->slot / desc_.cache_width_pages;
+        provider_(page % width_pages_, page / width_pages_, page_pixels_);
+        cache_.set_pixels_2d(page_pixels_, 4,
+                             slot_x * desc_.page_size, slot_y * desc_.page_size,
+                             desc_.page_size, desc_.page_size);
+
+        set_page_table_entry(page, PageTableEntry{
+            .x = static_cast<u8>(slot_x),
+            .y = static_cast<u8>(slot_y),
+            .unused = 0,
+            .resident = 255
+        });
+        stats_.uploaded_pages++;
+        stats_.upload_bytes += page_pixels_.size();
+    }
+    stats_.pending_pages = cut::to_u32(missing_.size()) - stats_.uploaded_pages;
+
+    upload_page_table();
+}
+
+void VirtualTexture::bind(u32 cache_unit, u32 page_table_unit) const {
+    cache_.bind(cache_unit);
+    page_table_.bind(page_table_unit);
+}
+
+void VirtualTexture::set_page_table_entry(u32 page, PageTableEntry entry) {
+    page_table_entries_[page] = entry;
+
+    u32 page_x = page % width_pages_;
+    u32 page_y = page / width_pages_;
+    dirty_min_x_ = std::min(dirty_min_x_, page_x);
+    dirty_min_y_ = std::min(dirty_min_y_, page_y);
+    dirty_max_x_ = std::max(dirty_max_x_, page_x + 1);
+    dirty_max_y_ = std::max(dirty_max_y_, page_y + 1);
+}
+
+void VirtualTexture::upload_page_table() {
+    if (dirty_min_x_ >= dirty_max_x_ || dirty_min_y_ >= dirty_max_y_) return;
+
+    u32 width = dirty_max_x_ - dirty_min_x_;
+    u32 height = dirty_max_y_ - dirty_min_y_;
+    page_table_scratch_.resize(width * height);
+    for (u32 y = 0; y < height; ++y) {
+        auto row = page_table_entries_.begin() + (dirty_min_y_ + y) * width_pages_ + dirty_min_x_;
+        std::copy(row, row + width, page_table_scratch_.begin() + y * width);
+    }
+
+    page_table_.set_pixels_2d(std::as_bytes(std::span{ page_table_scratch_ }), 4,
+                              dirty_min_x_, dirty_min_y_, width, height);
+    stats_.upload_bytes += page_table_scratch_.size() * sizeof(PageTableEntry);
+
+    dirty_min_x_ = width_pages_;
+    dirty_min_y_ = height_pages_;
+    dirty_max_x_ = 0;
+    dirty_max_y_ = 0;
+}
+
+} // namespace glw
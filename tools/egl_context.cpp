@@ -0,0 +1,38 @@
+#include "egl_context.hpp"
+
+#include <cut/exception.hpp>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace glw::tools {
+
+void create_egl_context() {
+    auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    cut::ensure(get_platform_display != nullptr, "EGL_EXT_platform_base is not supported!");
+
+    EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    cut::ensure(display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr), "Could not initialize surfaceless EGL display!");
+    cut::ensure(eglBindAPI(EGL_OPENGL_API), "EGL does not support desktop OpenGL!");
+
+    const EGLint config_attributes[] = { EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config;
+    EGLint config_count = 0;
+    cut::ensure(eglChooseConfig(display, config_attributes, &config, 1, &config_count) && config_count > 0, "No EGL config with OpenGL!");
+
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    cut::ensure(context != EGL_NO_CONTEXT, "Could not create OpenGL 4.5 core context!");
+    cut::ensure(eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context), "Could not make surfaceless context current!");
+}
+
+GLWApiProc load_egl_function(const char* name) {
+    return reinterpret_cast<GLWApiProc>(eglGetProcAddress(name));
+}
+
+} // namespace glw::tools
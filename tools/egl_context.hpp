@@ -0,0 +1,13 @@
+#pragma once
+#include "glw/glw.hpp"
+
+namespace glw::tools {
+
+/*
+* Makes a GL 4.5 core context current without any surface, Mesa picks llvmpipe with LIBGL_ALWAYS_SOFTWARE=1
+*/
+void create_egl_context();
+
+GLWApiProc load_egl_function(const char* name);
+
+} // namespace glw::tools
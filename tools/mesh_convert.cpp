@@ -0,0 +1,318 @@
+#include "glw/mesh_file.hpp"
+#include "glw/mesh_lod.hpp"
+#include "glw/mesh_optimizer.hpp"
+#include "glw/thread_pool.hpp"
+#include "glw/vertex_quantization.hpp"
+
+#include <cut/exception.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using namespace glw;
+
+struct ObjMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<u32> indices;
+};
+
+struct VertexKey {
+    s32 position;
+    s32 uv;
+    s32 normal;
+
+    bool operator==(const VertexKey&) const = default;
+};
+
+struct VertexKeyHash {
+    size_t operator()(const VertexKey& key) const {
+        return std::hash<s32>{}(key.position) * 73856093u ^ std::hash<s32>{}(key.uv) * 19349663u ^ std::hash<s32>{}(key.normal) * 83492791u;
+    }
+};
+
+/*
+* Negative indices count back from the data read so far, positive ones may point at data further down
+* the file, so only the lower bound can be checked here
+*/
+s32 to_index(std::string_view token, size_t count) {
+    if (token.empty()) return -1;
+
+    s32 index = 0;
+    std::from_chars(token.data(), token.data() + token.size(), index);
+    s32 resolved = index < 0 ? static_cast<s32>(count) + index : index - 1;
+    cut::ensure(resolved >= 0, "OBJ index {} out of range!", index);
+    return resolved;
+}
+
+template<typename T>
+const T& at_index(const std::vector<T>& values, s32 index) {
+    cut::ensure(static_cast<size_t>(index) < values.size(), "OBJ index {} out of range!", index + 1);
+    return values[index];
+}
+
+/*
+* Positions, normals, texture coordinates and polygonal faces, everything else is skipped
+*/
+ObjMesh parse_obj(const std::string& path) {
+    std::ifstream file(path);
+    cut::ensure(file.good(), "Could not open {}!", path);
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::unordered_map<VertexKey, u32, VertexKeyHash> vertices;
+    std::vector<VertexKey> keys;
+    ObjMesh mesh;
+
+    std::string line;
+    std::vector<u32> polygon;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+
+        if (type == "v") {
+            glm::vec3 p;
+            stream >> p.x >> p.y >> p.z;
+            positions.push_back(p);
+        }
+        else if (type == "vn") {
+            glm::vec3 n;
+            stream >> n.x >> n.y >> n.z;
+            normals.push_back(n);
+        }
+        else if (type == "vt") {
+            glm::vec2 uv;
+            stream >> uv.x >> uv.y;
+            uvs.push_back(uv);
+        }
+        else if (type == "f") {
+            polygon.clear();
+            std::string corner;
+            while (stream >> corner) {
+                std::string_view view = corner;
+                size_t first_slash = view.find('/');
+                size_t second_slash = first_slash == std::string_view::npos ? std::string_view::npos : view.find('/', first_slash + 1);
+
+                VertexKey key{
+                    to_index(view.substr(0, first_slash), positions.size()),
+                    first_slash == std::string_view::npos ? -1 : to_index(view.substr(first_slash + 1, second_slash - first_slash - 1), uvs.size()),
+                    second_slash == std::string_view::npos ? -1 : to_index(view.substr(second_slash + 1), normals.size())
+                };
+
+                auto [it, inserted] = vertices.try_emplace(key, cut::to_u32(keys.size()));
+                if (inserted) keys.push_back(key);
+                polygon.push_back(it->second);
+            }
+
+            // Fan triangulation, fine for the convex faces exporters write
+            for (size_t i = 2; i < polygon.size(); ++i) {
+                mesh.indices.insert(mesh.indices.end(), { polygon[0], polygon[i - 1], polygon[i] });
+            }
+        }
+    }
+
+    // Resolved once the whole file is read, vn and vt lines may come after the faces using them
+    mesh.positions.reserve(keys.size());
+    for (const auto& key : keys) {
+        mesh.positions.push_back(at_index(positions, key.position));
+        if (!normals.empty()) mesh.normals.push_back(key.normal >= 0 ? at_index(normals, key.normal) : glm::vec3{ 0.0f });
+        if (!uvs.empty()) mesh.uvs.push_back(key.uv >= 0 ? at_index(uvs, key.uv) : glm::vec2{ 0.0f });
+    }
+    return mesh;
+}
+
+struct ConvertOptions {
+    u32 max_levels = 1;
+    bool quantize = false;
+};
+
+struct LevelResult {
+    LodLevel level;
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+struct ConvertResult {
+    u32 vertex_count;
+    size_t triangle_count;
+    std::vector<LevelResult> levels;
+};
+
+ConvertResult convert(const std::filesystem::path& input, const std::filesystem::path& output, const ConvertOptions& options) {
+    ObjMesh obj = parse_obj(input.string());
+    u32 vertex_count = cut::to_u32(obj.positions.size());
+
+    // Interleave floats so LOD generation and vertex fetch optimization move whole vertices
+    std::vector<VertexAttribute> attributes{ { VertexDataType::F32_3, 0 } };
+    u32 stride = sizeof(glm::vec3);
+    if (!obj.normals.empty()) {
+        attributes.push_back({ VertexDataType::F32_3, stride });
+        stride += sizeof(glm::vec3);
+    }
+    if (!obj.uvs.empty()) {
+        attributes.push_back({ VertexDataType::F32_2, stride });
+        stride += sizeof(glm::vec2);
+    }
+
+    std::vector<std::byte> vertices(static_cast<size_t>(vertex_count) * stride);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        std::byte* vertex = vertices.data() + static_cast<size_t>(v) * stride;
+        std::memcpy(vertex, &obj.positions[v], sizeof(glm::vec3));
+        if (!obj.normals.empty()) std::memcpy(vertex + attributes[1].offset, &obj.normals[v], sizeof(glm::vec3));
+        if (!obj.uvs.empty()) std::memcpy(vertex + attributes.back().offset, &obj.uvs[v], sizeof(glm::vec2));
+    }
+
+    LodSource source{ vertices, obj.indices, stride, 0, {} };
+    LodChain chain = build_lod_chain(source, { .max_levels = options.max_levels });
+    std::vector<LevelResult> levels;
+    for (const auto& level : chain.levels) {
+        auto level_indices = std::span{ chain.indices }.subspan(level.first_index, level.index_count);
+        VertexCacheStats before = analyze_vertex_cache(level_indices, vertex_count);
+        optimize_vertex_cache(level_indices, vertex_count);
+        optimize_overdraw(level_indices, vertices, stride, 0);
+        levels.push_back({ level, before, analyze_vertex_cache(level_indices, vertex_count) });
+    }
+    vertex_count = optimize_vertex_fetch(vertices, stride, chain.indices);
+    vertices.resize(static_cast<size_t>(vertex_count) * stride);
+
+    QuantizedMesh quantized;
+    if (options.quantize) {
+        std::vector<glm::vec3> positions(vertex_count);
+        std::vector<glm::vec3> normals(obj.normals.empty() ? 0 : vertex_count);
+        std::vector<glm::vec2> uvs(obj.uvs.empty() ? 0 : vertex_count);
+        for (u32 v = 0; v < vertex_count; ++v) {
+            const std::byte* vertex = vertices.data() + static_cast<size_t>(v) * stride;
+            std::memcpy(&positions[v], vertex, sizeof(glm::vec3));
+            if (!normals.empty()) std::memcpy(&normals[v], vertex + attributes[1].offset, sizeof(glm::vec3));
+            if (!uvs.empty()) std::memcpy(&uvs[v], vertex + attributes.back().offset, sizeof(glm::vec2));
+        }
+        quantized = quantize_vertices({ .positions = positions, .normals = normals, .tangents = {}, .uvs = uvs });
+    }
+
+    Mesh::IndexType index_type = to_smallest_index_type(vertex_count);
+    std::vector<std::byte> indices = narrow_indices(chain.indices, index_type);
+    MeshFileData data{ vertices, stride, attributes, indices, index_type, chain.levels };
+    if (options.quantize) {
+        data.vertices = quantized.vertices;
+        data.stride = quantized.stride;
+        data.attributes = quantized.attributes;
+        data.position_scale = quantized.position_scale;
+        data.position_offset = quantized.position_offset;
+        data.uv_scale = quantized.uv_scale;
+        data.uv_offset = quantized.uv_offset;
+    }
+    write_mesh_file(output, data);
+
+    return { vertex_count, obj.indices.size() / 3, std::move(levels) };
+}
+
+void print_result(const ConvertResult& result) {
+    std::println("{} vertices, {} triangles, {} levels", result.vertex_count, result.triangle_count, result.levels.size());
+    for (const auto& [level, before, after] : result.levels) {
+        std::println("  {} triangles, error {:g}, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+                     level.index_count / 3, level.error, before.acmr, after.acmr, before.atvr, after.atvr);
+    }
+}
+
+/*
+* Converts every .obj directly inside input into a .glwm of the same name in output, one file per task
+* Failures are reported per file and don't stop the others
+*/
+int convert_directory(const std::filesystem::path& input, const std::filesystem::path& output, const ConvertOptions& options) {
+    std::vector<std::filesystem::path> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(input)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".obj") paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+    std::filesystem::create_directories(output);
+
+    std::vector<std::optional<ConvertResult>> results(paths.size());
+    std::vector<std::string> errors(paths.size());
+    ThreadPool thread_pool;
+    thread_pool.parallel_for(paths.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            try {
+                results[i] = convert(paths[i], output / paths[i].filename().replace_extension(".glwm"), options);
+            }
+            catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        }
+    });
+
+    size_t failed = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        std::print("{}: ", paths[i].filename().string());
+        if (results[i]) {
+            print_result(*results[i]);
+        }
+        else {
+            std::println("failed, {}", errors[i]);
+            failed++;
+        }
+    }
+    std::println("{} of {} meshes converted on {} threads", paths.size() - failed, paths.size(), thread_pool.get_thread_count());
+    return failed == 0 ? 0 : 1;
+}
+
+void print_usage() {
+    std::println("usage: glw_mesh_convert <input.obj> <output.glwm> [--lods <count>] [--quantize]");
+    std::println("       glw_mesh_convert <input directory> <output directory> [--lods <count>] [--quantize]");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+
+    ConvertOptions options;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--lods") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            auto [end, error] = std::from_chars(value, value + std::strlen(value), options.max_levels);
+            if (error != std::errc{} || *end != '\0' || options.max_levels == 0) {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--quantize") == 0) {
+            options.quantize = true;
+        }
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    try {
+        if (std::filesystem::is_directory(argv[1])) return convert_directory(argv[1], argv[2], options);
+
+        print_result(convert(argv[1], argv[2], options));
+    }
+    catch (const std::exception& e) {
+        std::println(std::cerr, "{}", e.what());
+        return 1;
+    }
+    return 0;
+}
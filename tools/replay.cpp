@@ -0,0 +1,108 @@
+#include "egl_context.hpp"
+
+#include "glw/gl_trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+using namespace glw;
+
+struct FrameTimes {
+    double min_ms = 0.0;
+    double average_ms = 0.0;
+    double p95_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+FrameTimes to_frame_times(std::vector<double> times) {
+    if (times.empty()) return {};
+
+    std::sort(times.begin(), times.end());
+    double total = std::accumulate(times.begin(), times.end(), 0.0);
+    return { times.front(), total / times.size(), times[(times.size() - 1) * 95 / 100], times.back() };
+}
+
+/*
+* Entry points by calls over the whole replay, busiest first
+*/
+std::vector<u32> to_busiest_functions(std::span<const std::uint64_t> call_counts, size_t count) {
+    std::vector<u32> order(call_counts.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::erase_if(order, [&](u32 i) { return call_counts[i] == 0; });
+    std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) { return call_counts[a] > call_counts[b]; });
+    order.resize(std::min(order.size(), count));
+    return order;
+}
+
+void print_usage() {
+    std::puts("usage: glw_replay <trace> [--json]");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    bool json = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0) {
+            json = true;
+        }
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    try {
+        tools::create_egl_context();
+        init(tools::load_egl_function, { .debug_output = DebugOutput::Off });
+
+        GLReplay replay(argv[1]);
+        std::vector<double> times;
+        std::vector<u32> calls;
+        while (replay.replay_frame()) {
+            times.push_back(replay.get_last_frame().cpu_ms);
+            calls.push_back(replay.get_last_frame().calls);
+        }
+
+        FrameTimes frame_times = to_frame_times(times);
+        std::uint64_t total_calls = std::accumulate(calls.begin(), calls.end(), std::uint64_t{ 0 });
+        double calls_per_frame = calls.empty() ? 0.0 : static_cast<double>(total_calls) / calls.size();
+        auto busiest = to_busiest_functions(replay.get_call_counts(), 10);
+
+        if (json) {
+            std::printf("{\"frames\":%zu,\"min_ms\":%.4f,\"avg_ms\":%.4f,\"p95_ms\":%.4f,\"max_ms\":%.4f,\"calls_per_frame\":%.1f,\"frame_ms\":[",
+                        times.size(), frame_times.min_ms, frame_times.average_ms, frame_times.p95_ms, frame_times.max_ms, calls_per_frame);
+            for (size_t i = 0; i < times.size(); ++i) std::printf("%s%.4f", i ? "," : "", times[i]);
+            std::printf("],\"functions\":[");
+            for (size_t i = 0; i < busiest.size(); ++i) {
+                std::printf("%s{\"name\":\"%s\",\"calls\":%llu}", i ? "," : "", get_gl_function_name(static_cast<GLFunction>(busiest[i])),
+                            static_cast<unsigned long long>(replay.get_call_counts()[busiest[i]]));
+            }
+            std::printf("]}\n");
+        }
+        else {
+            std::printf("%zu frames, %.1f calls per frame\n", times.size(), calls_per_frame);
+            std::printf("CPU ms min %.3f avg %.3f p95 %.3f max %.3f\n",
+                        frame_times.min_ms, frame_times.average_ms, frame_times.p95_ms, frame_times.max_ms);
+            for (u32 function : busiest) {
+                std::printf("  %-40s %10llu calls\n", get_gl_function_name(static_cast<GLFunction>(function)),
+                            static_cast<unsigned long long>(replay.get_call_counts()[function]));
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}